@@ -0,0 +1,269 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_async_live_muxer.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace webm_tools {
+
+const int WebMAsyncLiveMuxer::kIdleWaitMs;
+
+WebMAsyncLiveMuxer::WebMAsyncLiveMuxer(size_t frame_queue_capacity,
+                                       size_t chunk_queue_capacity,
+                                       QueuePolicy policy)
+    // Buffers are in the frame queue, held by the writers or being muxed.
+    : frame_pool_(frame_queue_capacity * 2),
+      frames_(frame_queue_capacity),
+      chunks_(chunk_queue_capacity),
+      policy_(policy),
+      running_(false),
+      stop_(false),
+      failed_(false),
+      video_needs_key_(false),
+      audio_needs_key_(false),
+      frames_dropped_(0),
+      frames_muxed_(0),
+      muxer_idle_(false),
+      space_waiters_(0),
+      has_overflow_(false) {
+}
+
+WebMAsyncLiveMuxer::~WebMAsyncLiveMuxer() {
+  if (running_)
+    Finalize();
+}
+
+int WebMAsyncLiveMuxer::Init() {
+  if (muxer_.Init() != WebMLiveMuxer::kSuccess) {
+    fprintf(stderr, "Cannot Init WebMLiveMuxer.\n");
+    return kMuxerError;
+  }
+  if (!frame_pool_.Init() || !frames_.Init() || !chunks_.Init()) {
+    fprintf(stderr, "Cannot allocate queues.\n");
+    return kNoMemory;
+  }
+  return kSuccess;
+}
+
+int WebMAsyncLiveMuxer::Start(const ChunkCallback& callback) {
+  if (running_ || stop_ || !muxer_.initialized()) {
+    fprintf(stderr, "Cannot Start, not Initialized or already started.\n");
+    return kInvalidArg;
+  }
+  callback_ = callback;
+  running_ = true;
+  thread_ = std::thread(&WebMAsyncLiveMuxer::Run, this);
+  return kSuccess;
+}
+
+int WebMAsyncLiveMuxer::WriteVideoFrame(const uint8* data, size_t size,
+                                        uint64 timestamp_ns, bool is_key) {
+  return QueueFrame(true, data, size, timestamp_ns, is_key);
+}
+
+int WebMAsyncLiveMuxer::WriteAudioFrame(const uint8* data, size_t size,
+                                        uint64 timestamp_ns, bool is_key) {
+  return QueueFrame(false, data, size, timestamp_ns, is_key);
+}
+
+bool WebMAsyncLiveMuxer::PopChunk(Chunk* chunk) {
+  if (chunks_.TryPop(chunk)) {
+    NotifySpace();
+    return true;
+  }
+  if (!has_overflow_)
+    return false;
+
+  std::lock_guard<std::mutex> lock(overflow_mutex_);
+  // A chunk may have been queued before the overflow started.
+  if (chunks_.TryPop(chunk))
+    return true;
+  if (overflow_chunks_.empty())
+    return false;
+  *chunk = overflow_chunks_.front();
+  overflow_chunks_.pop_front();
+  return true;
+}
+
+int WebMAsyncLiveMuxer::Finalize() {
+  if (!running_.exchange(false))
+    return kNotRunning;
+
+  stop_ = true;
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(space_mutex_);
+    space_.notify_all();
+  }
+  thread_.join();
+
+  // The muxer thread has stopped, so |muxer_| is used from this thread.
+  if (muxer_.Finalize() != WebMLiveMuxer::kSuccess || !DeliverChunks())
+    failed_ = true;
+  return failed_ ? kMuxerError : kSuccess;
+}
+
+int WebMAsyncLiveMuxer::QueueFrame(bool video, const uint8* data,
+                                   size_t size, uint64 timestamp_ns,
+                                   bool is_key) {
+  if (!running_)
+    return kNotRunning;
+  if (!data || size == 0)
+    return kInvalidArg;
+
+  std::atomic<bool>& needs_key = video ? video_needs_key_ : audio_needs_key_;
+  if (policy_ == kDropUntilKeyFrame && !is_key && needs_key) {
+    ++frames_dropped_;
+    return kFrameDropped;
+  }
+
+  Frame frame;
+  frame_pool_.Copy(data, size, &frame.data);
+  frame.timestamp_ns = timestamp_ns;
+  frame.is_key = is_key;
+  frame.video = video;
+
+  while (!frames_.TryPush(&frame)) {
+    if (policy_ != kBlock) {
+      if (policy_ == kDropUntilKeyFrame)
+        needs_key = true;
+      frame_pool_.Release(&frame.data);
+      ++frames_dropped_;
+      return kFrameDropped;
+    }
+    if (!running_) {
+      frame_pool_.Release(&frame.data);
+      return kNotRunning;
+    }
+    WakeMuxer();
+    WaitForSpace();
+  }
+
+  if (is_key)
+    needs_key = false;
+  WakeMuxer();
+  return kSuccess;
+}
+
+void WebMAsyncLiveMuxer::WakeMuxer() {
+  // Orders the queue update before the |muxer_idle_| check. Pairs with the
+  // fence in |Run()|.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (muxer_idle_) {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_.notify_one();
+  }
+}
+
+void WebMAsyncLiveMuxer::NotifySpace() {
+  // Orders the queue update before the |space_waiters_| check. Pairs with
+  // the fence in |WaitForSpace()|.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (space_waiters_ > 0) {
+    std::lock_guard<std::mutex> lock(space_mutex_);
+    space_.notify_all();
+  }
+}
+
+void WebMAsyncLiveMuxer::WaitForSpace() {
+  std::unique_lock<std::mutex> lock(space_mutex_);
+  ++space_waiters_;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // The timeout only matters if a notification is missed, since the caller
+  // checks its queue again before waiting.
+  if (!stop_)
+    space_.wait_for(lock, std::chrono::milliseconds(kIdleWaitMs));
+  --space_waiters_;
+}
+
+void WebMAsyncLiveMuxer::QueueChunk(Chunk* chunk) {
+  // Once the overflow has started chunks go to it, so they stay in order.
+  while (has_overflow_ || !chunks_.TryPush(chunk)) {
+    if (has_overflow_ || stop_) {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      overflow_chunks_.push_back(*chunk);
+      has_overflow_ = true;
+      return;
+    }
+    WaitForSpace();
+  }
+}
+
+void WebMAsyncLiveMuxer::Run() {
+  Frame frame;
+  for (;;) {
+    if (frames_.TryPop(&frame)) {
+      NotifySpace();
+      MuxFrame(&frame);
+      continue;
+    }
+    if (stop_) {
+      if (frames_.Empty())
+        break;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    muxer_idle_ = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // The timeout only matters if a wake up is missed.
+    if (frames_.Empty() && !stop_)
+      wake_.wait_for(lock, std::chrono::milliseconds(kIdleWaitMs));
+    muxer_idle_ = false;
+  }
+}
+
+void WebMAsyncLiveMuxer::MuxFrame(Frame* frame) {
+  if (failed_) {
+    frame_pool_.Release(&frame->data);
+    return;
+  }
+
+  const int status = frame->video ?
+      muxer_.WriteVideoFrame(&frame->data[0], frame->data.size(),
+                             frame->timestamp_ns, frame->is_key) :
+      muxer_.WriteAudioFrame(&frame->data[0], frame->data.size(),
+                             frame->timestamp_ns, frame->is_key);
+  // The muxer has copied or written the payload. The empty buffer left in
+  // |frame| is swapped into the queue slot by the next |TryPop()|.
+  frame_pool_.Release(&frame->data);
+  if (status != WebMLiveMuxer::kSuccess) {
+    fprintf(stderr, "Cannot mux %s frame.\n", frame->video ? "video" : "audio");
+    failed_ = true;
+    return;
+  }
+  ++frames_muxed_;
+
+  if (!DeliverChunks())
+    failed_ = true;
+}
+
+bool WebMAsyncLiveMuxer::DeliverChunks() {
+  int32 chunk_length = 0;
+  while (muxer_.ChunkReady(&chunk_length)) {
+    Chunk chunk;
+    chunk.flags = muxer_.chunk_flags();
+    if (muxer_.ReadChunk(&chunk.data) != WebMLiveMuxer::kSuccess) {
+      fprintf(stderr, "Cannot read chunk.\n");
+      return false;
+    }
+
+    if (callback_)
+      callback_(chunk);
+    else
+      QueueChunk(&chunk);
+  }
+  return true;
+}
+
+}  // namespace webm_tools
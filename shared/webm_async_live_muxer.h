@@ -0,0 +1,229 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_ASYNC_LIVE_MUXER_H_
+#define SHARED_WEBM_ASYNC_LIVE_MUXER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "webm_frame_pool.h"
+#include "webm_live_muxer.h"
+#include "webm_mpmc_queue.h"
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Asynchronous front end of |WebMLiveMuxer|. Encoder threads queue frames in
+// a lock free bounded queue and return immediately. A muxer thread drains the
+// queue into the |WebMLiveMuxer| and delivers the completed chunks to a
+// callback, or to a second lock free queue read with |PopChunk()|.
+//
+// Notes:
+// - Users MUST call |Init()|, set up the tracks through |muxer()|, and then
+//   call |Start()| before writing frames.
+//
+// - |QueuePolicy| sets what writes do when the frame queue is full. With the
+//   drop policies encoder threads never wait for the muxer thread.
+//
+// - Users MUST call |Finalize()| to mux the queued frames and get the last
+//   chunk. Writes must have returned before |Finalize()| is called.
+//
+// - Frame copies are made in buffers of a |WebMFramePool|, recycled once the
+//   frame is muxed, so writes stop allocating once the pool holds buffers of
+//   the stream's largest frame size.
+class WebMAsyncLiveMuxer {
+ public:
+  // Status codes returned by class methods.
+  enum {
+    // The frame was dropped by the |QueuePolicy|.
+    kFrameDropped = -5,
+
+    // |Start()| has not been called, or |Finalize()| has been called.
+    kNotRunning = -4,
+
+    // The muxer failed to mux a frame or to finalize.
+    kMuxerError = -3,
+
+    kNoMemory = -2,
+    kInvalidArg = -1,
+    kSuccess = 0,
+  };
+
+  // What writes do when the frame queue is full.
+  enum QueuePolicy {
+    // Wait for the muxer thread to make room.
+    kBlock,
+
+    // Drop the frame.
+    kDropFrame,
+
+    // Drop the frame and the following frames of its track until the next
+    // key frame, so the muxed stream stays decodable.
+    kDropUntilKeyFrame,
+  };
+
+  // Chunk delivered by the muxer thread.
+  struct Chunk {
+    Chunk() : flags(0) {}
+
+    WebMLiveMuxer::SharedChunk data;
+
+    // |WebMLiveMuxer::ChunkFlags| of the chunk.
+    int flags;
+  };
+
+  // Called on the muxer thread for each completed chunk. Chunks produced by
+  // |Finalize()| are passed on the thread calling |Finalize()|.
+  typedef std::function<void(const Chunk& chunk)> ChunkCallback;
+
+  // |frame_queue_capacity| and |chunk_queue_capacity| are rounded up to
+  // powers of two.
+  WebMAsyncLiveMuxer(size_t frame_queue_capacity, size_t chunk_queue_capacity,
+                     QueuePolicy policy);
+  ~WebMAsyncLiveMuxer();
+
+  // Initializes the wrapped muxer and allocates the queues. Returns
+  // |kSuccess| when successful.
+  int Init();
+
+  // Returns the wrapped muxer. Tracks and low latency settings are set up
+  // through it between |Init()| and |Start()|. It must not be used after
+  // |Start()|.
+  WebMLiveMuxer* muxer() { return &muxer_; }
+
+  // Starts the muxer thread. Chunks are passed to |callback|, or queued for
+  // |PopChunk()| when |callback| is empty. Returns |kSuccess| when
+  // successful.
+  int Start(const ChunkCallback& callback);
+
+  // Queues a copy of |data| for the video track. Returns |kSuccess| when the
+  // frame was queued, and |kFrameDropped| when the |QueuePolicy| dropped it.
+  // Thread safe.
+  int WriteVideoFrame(const uint8* data, size_t size,
+                      uint64 timestamp_ns, bool is_key);
+
+  // Queues a copy of |data| for the audio track. Returns |kSuccess| when the
+  // frame was queued, and |kFrameDropped| when the |QueuePolicy| dropped it.
+  // Thread safe.
+  int WriteAudioFrame(const uint8* data, size_t size,
+                      uint64 timestamp_ns, bool is_key);
+
+  // Moves the oldest queued chunk into |chunk|. Returns false if no chunk is
+  // queued. Only used when |Start()| was called without a callback. Thread
+  // safe.
+  //
+  // While the chunk queue is full the muxer thread waits for |PopChunk()|,
+  // and frames back up in the frame queue where |QueuePolicy| applies. Once
+  // |Finalize()| is called chunks that do not fit the queue are kept in an
+  // unbounded overflow list instead, so chunks may be popped after
+  // |Finalize()| returns.
+  bool PopChunk(Chunk* chunk);
+
+  // Muxes the queued frames, stops the muxer thread, finalizes the muxer
+  // and delivers the last chunk. Returns |kSuccess| if every frame was
+  // muxed.
+  int Finalize();
+
+  // Accessors.
+  int64 frames_dropped() const { return frames_dropped_; }
+  int64 frames_muxed() const { return frames_muxed_; }
+  const WebMFramePool& frame_pool() const { return frame_pool_; }
+
+ private:
+  // Maximum time in milliseconds the idle muxer thread sleeps before
+  // checking the frame queue again.
+  static const int kIdleWaitMs = 10;
+
+  struct Frame {
+    Frame() : timestamp_ns(0), is_key(false), video(false) {}
+
+    std::vector<uint8> data;
+    uint64 timestamp_ns;
+    bool is_key;
+    bool video;
+  };
+
+  // Copies |data| into the frame queue following |policy_|.
+  int QueueFrame(bool video, const uint8* data, size_t size,
+                 uint64 timestamp_ns, bool is_key);
+
+  // Wakes the muxer thread if it is waiting for frames.
+  void WakeMuxer();
+
+  // Wakes the threads waiting in |WaitForSpace()|, if any.
+  void NotifySpace();
+
+  // Waits on |space_| until notified, |stop_| is set, or |kIdleWaitMs|
+  // passes.
+  void WaitForSpace();
+
+  // Queues |chunk| for |PopChunk()|. Waits for room in |chunks_| until
+  // |stop_| is set, then moves the chunk to |overflow_chunks_|.
+  void QueueChunk(Chunk* chunk);
+
+  // Muxer thread function.
+  void Run();
+
+  // Muxes |frame| and delivers the chunks it completed. Returns the frame
+  // buffer to |frame_pool_|.
+  void MuxFrame(Frame* frame);
+
+  // Passes the ready chunks of |muxer_| to |callback_| or |chunks_|. Returns
+  // false on error.
+  bool DeliverChunks();
+
+  WebMLiveMuxer muxer_;
+  WebMFramePool frame_pool_;
+  MpmcQueue<Frame> frames_;
+  MpmcQueue<Chunk> chunks_;
+  const QueuePolicy policy_;
+  ChunkCallback callback_;
+  std::thread thread_;
+
+  std::atomic<bool> running_;
+  std::atomic<bool> stop_;
+  std::atomic<bool> failed_;
+
+  // Set when a frame of the track was dropped with |kDropUntilKeyFrame|, and
+  // cleared when a key frame of the track is queued.
+  std::atomic<bool> video_needs_key_;
+  std::atomic<bool> audio_needs_key_;
+
+  std::atomic<int64> frames_dropped_;
+  std::atomic<int64> frames_muxed_;
+
+  // Set while the muxer thread waits on |wake_| for frames.
+  std::atomic<bool> muxer_idle_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+
+  // Number of threads waiting on |space_|: writers blocked on a full frame
+  // queue with |kBlock|, and the muxer thread blocked on a full chunk queue.
+  std::atomic<int> space_waiters_;
+  std::mutex space_mutex_;
+  std::condition_variable space_;
+
+  // Chunks that did not fit |chunks_| after |stop_| was set, guarded by
+  // |overflow_mutex_|. Popped after |chunks_| is empty.
+  std::atomic<bool> has_overflow_;
+  std::mutex overflow_mutex_;
+  std::deque<Chunk> overflow_chunks_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMAsyncLiveMuxer);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_ASYNC_LIVE_MUXER_H_
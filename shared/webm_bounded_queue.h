@@ -0,0 +1,108 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_BOUNDED_QUEUE_H_
+#define SHARED_WEBM_BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Thread safe FIFO queue holding at most |capacity| items. Producers block in
+// |Push()| while the queue is full and consumers block in |Pop()| while the
+// queue is empty, which gives multi-stage pipelines backpressure.
+//
+// Notes:
+// - |Close()| wakes all waiting threads. After |Close()| |Push()| fails, and
+//   |Pop()| returns the remaining items before failing.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1),
+        closed_(false) {
+  }
+  ~BoundedQueue() {}
+
+  // Adds |item| to the back of the queue. Blocks while the queue is full.
+  // Returns false if the queue has been closed.
+  bool Push(const T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!closed_ && items_.size() >= capacity_)
+      not_full_.wait(lock);
+    if (closed_)
+      return false;
+
+    items_.push_back(item);
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Same as |Push(const T&)| except |item| is moved into the queue, so the
+  // buffers it owns are handed over without copies. |item| is unchanged if
+  // the queue has been closed.
+  bool Push(T&& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!closed_ && items_.size() >= capacity_)
+      not_full_.wait(lock);
+    if (closed_)
+      return false;
+
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Removes the item at the front of the queue and stores it in |item|.
+  // Blocks while the queue is empty. Returns false if the queue is empty and
+  // has been closed, or if |item| is NULL.
+  bool Pop(T* item) {
+    if (!item)
+      return false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!closed_ && items_.empty())
+      not_empty_.wait(lock);
+    if (items_.empty())
+      return false;
+
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Closes the queue and wakes all threads waiting in |Push()| or |Pop()|.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  bool closed_;
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(BoundedQueue);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_BOUNDED_QUEUE_H_
@@ -0,0 +1,354 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_chunk_sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "webm_live_muxer.h"
+
+namespace webm_tools {
+
+namespace {
+
+// Largest number of buffers passed to one |writev()| call.
+#ifdef IOV_MAX
+const size_t kMaxIovecs = IOV_MAX;
+#else
+const size_t kMaxIovecs = 16;
+#endif
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+// Writes the |num_pieces| pieces to |fd|, retrying partial writes and
+// interrupted calls. Sockets are written with |sendmsg()| so a closed
+// connection does not raise SIGPIPE. |iovecs| is scratch space. Returns the
+// number of bytes written, or -1 on error.
+int64 WritePieces(int fd, bool is_socket, const WebMChunkPiece* pieces,
+                  size_t num_pieces, std::vector<struct iovec>* iovecs) {
+  iovecs->clear();
+  int64 total = 0;
+  for (size_t i = 0; i < num_pieces; ++i) {
+    if (pieces[i].size > 0) {
+      struct iovec iov;
+      iov.iov_base = const_cast<uint8*>(pieces[i].data);
+      iov.iov_len = pieces[i].size;
+      iovecs->push_back(iov);
+      total += pieces[i].size;
+    }
+  }
+
+  size_t index = 0;
+  while (index < iovecs->size()) {
+    const size_t count = iovecs->size() - index < kMaxIovecs ?
+        iovecs->size() - index : kMaxIovecs;
+    ssize_t written;
+    if (is_socket) {
+      struct msghdr message;
+      memset(&message, 0, sizeof(message));
+      message.msg_iov = &(*iovecs)[index];
+      message.msg_iovlen = count;
+      written = sendmsg(fd, &message, kSendFlags);
+    } else {
+      written = writev(fd, &(*iovecs)[index], static_cast<int>(count));
+    }
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "Cannot write chunk: %s\n", strerror(errno));
+      return -1;
+    }
+
+    // Skip the buffers written, and the written part of a partial one.
+    size_t remaining = static_cast<size_t>(written);
+    while (remaining > 0) {
+      struct iovec& iov = (*iovecs)[index];
+      if (remaining >= iov.iov_len) {
+        remaining -= iov.iov_len;
+        ++index;
+      } else {
+        iov.iov_base = static_cast<uint8*>(iov.iov_base) + remaining;
+        iov.iov_len -= remaining;
+        remaining = 0;
+      }
+    }
+  }
+  return total;
+}
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMFdChunkSink
+//
+
+WebMFdChunkSink::WebMFdChunkSink(int fd)
+    : fd_(-1),
+      owns_fd_(false),
+      is_socket_(false),
+      bytes_written_(0) {
+  Reset(fd, false);
+}
+
+WebMFdChunkSink::~WebMFdChunkSink() {
+  Reset(-1, false);
+}
+
+void WebMFdChunkSink::Reset(int fd, bool owns_fd) {
+  if (owns_fd_ && fd_ >= 0)
+    close(fd_);
+  fd_ = fd;
+  owns_fd_ = owns_fd;
+  is_socket_ = false;
+  struct stat fd_stat;
+  if (fd >= 0 && fstat(fd, &fd_stat) == 0)
+    is_socket_ = S_ISSOCK(fd_stat.st_mode);
+}
+
+bool WebMFdChunkSink::WriteChunk(const WebMChunkPiece* pieces,
+                                 size_t num_pieces, int /* flags */) {
+  if (fd_ < 0 || (!pieces && num_pieces > 0)) {
+    fprintf(stderr, "Cannot WriteChunk, no descriptor or invalid pieces.\n");
+    return false;
+  }
+  const int64 written =
+      WritePieces(fd_, is_socket_, pieces, num_pieces, &iovecs_);
+  if (written < 0)
+    return false;
+  bytes_written_ += written;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMTcpChunkSink
+//
+
+WebMTcpChunkSink::WebMTcpChunkSink() : WebMFdChunkSink(-1) {
+}
+
+bool WebMTcpChunkSink::Connect(const std::string& host, int port) {
+  char port_string[16];
+  snprintf(port_string, sizeof(port_string), "%d", port);
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addresses = NULL;
+  const int status = getaddrinfo(host.c_str(), port_string, &hints,
+                                 &addresses);
+  if (status != 0) {
+    fprintf(stderr, "Cannot resolve %s: %s\n", host.c_str(),
+            gai_strerror(status));
+    return false;
+  }
+
+  int fd = -1;
+  for (struct addrinfo* address = addresses; address;
+       address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype,
+                address->ai_protocol);
+    if (fd < 0)
+      continue;
+    if (connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+      break;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) {
+    fprintf(stderr, "Cannot connect to %s:%d.\n", host.c_str(), port);
+    return false;
+  }
+
+  const int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+  Reset(fd, true);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMSegmentFileChunkSink
+//
+
+WebMSegmentFileChunkSink::WebMSegmentFileChunkSink(
+    const std::string& init_path, const std::string& segment_template,
+    int64 start_number)
+    : init_path_(init_path),
+      segment_template_(segment_template),
+      start_number_(start_number),
+      max_segments_(0),
+      number_pos_(std::string::npos),
+      number_length_(0),
+      number_width_(0),
+      fd_(-1),
+      in_segment_(false),
+      init_written_(false),
+      segment_number_(start_number),
+      segments_written_(0) {
+}
+
+WebMSegmentFileChunkSink::~WebMSegmentFileChunkSink() {
+  Close();
+}
+
+bool WebMSegmentFileChunkSink::Init() {
+  const std::string kNumber = "$Number";
+  number_pos_ = segment_template_.find(kNumber);
+  if (number_pos_ == std::string::npos) {
+    fprintf(stderr, "Segment template has no $Number$: %s\n",
+            segment_template_.c_str());
+    return false;
+  }
+
+  // "$Number$" or "$Number%0<width>d$".
+  size_t pos = number_pos_ + kNumber.size();
+  number_width_ = 0;
+  if (segment_template_.compare(pos, 2, "%0") == 0) {
+    pos += 2;
+    while (pos < segment_template_.size() &&
+           segment_template_[pos] >= '0' && segment_template_[pos] <= '9') {
+      number_width_ = number_width_ * 10 + (segment_template_[pos] - '0');
+      ++pos;
+    }
+    if (pos >= segment_template_.size() || segment_template_[pos] != 'd') {
+      fprintf(stderr, "Invalid $Number$ format: %s\n",
+              segment_template_.c_str());
+      number_pos_ = std::string::npos;
+      return false;
+    }
+    ++pos;
+  }
+  if (pos >= segment_template_.size() || segment_template_[pos] != '$') {
+    fprintf(stderr, "Invalid $Number$ identifier: %s\n",
+            segment_template_.c_str());
+    number_pos_ = std::string::npos;
+    return false;
+  }
+  number_length_ = pos + 1 - number_pos_;
+  return true;
+}
+
+std::string WebMSegmentFileChunkSink::SegmentPath(int64 number) const {
+  if (number_pos_ == std::string::npos)
+    return std::string();
+  char number_string[32];
+  snprintf(number_string, sizeof(number_string), "%0*lld", number_width_,
+           static_cast<long long>(number));
+  std::string path = segment_template_;
+  path.replace(number_pos_, number_length_, number_string);
+  return path;
+}
+
+bool WebMSegmentFileChunkSink::WriteChunk(const WebMChunkPiece* pieces,
+                                          size_t num_pieces, int flags) {
+  if (number_pos_ == std::string::npos) {
+    fprintf(stderr, "Cannot WriteChunk, not Initialized.\n");
+    return false;
+  }
+  if (!pieces && num_pieces > 0) {
+    fprintf(stderr, "Error invalid arg passed to WriteChunk.\n");
+    return false;
+  }
+
+  if (flags & WebMLiveMuxer::kChunkClusterStart) {
+    // The previous Cluster ended without a |kChunkClusterEnd| chunk when it
+    // ended right after a partial chunk.
+    if (!Close())
+      return false;
+    if (!Open(SegmentPath(segment_number_)))
+      return false;
+    in_segment_ = true;
+  } else if (fd_ < 0) {
+    if (init_written_) {
+      fprintf(stderr, "Chunk does not start a Cluster.\n");
+      return false;
+    }
+    if (!Open(init_path_))
+      return false;
+  }
+
+  if (WritePieces(fd_, false, pieces, num_pieces, &iovecs_) < 0)
+    return false;
+
+  if (flags & WebMLiveMuxer::kChunkClusterEnd)
+    return Close();
+  return true;
+}
+
+bool WebMSegmentFileChunkSink::Close() {
+  if (fd_ < 0)
+    return true;
+  if (in_segment_)
+    return CloseSegment();
+
+  const bool closed = close(fd_) == 0;
+  fd_ = -1;
+  init_written_ = true;
+  if (!closed) {
+    fprintf(stderr, "Cannot close %s: %s\n", init_path_.c_str(),
+            strerror(errno));
+  }
+  return closed;
+}
+
+bool WebMSegmentFileChunkSink::Open(const std::string& path) {
+  do {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  } while (fd_ < 0 && errno == EINTR);
+  if (fd_ < 0) {
+    fprintf(stderr, "Cannot open %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool WebMSegmentFileChunkSink::CloseSegment() {
+  const bool closed = close(fd_) == 0;
+  fd_ = -1;
+  in_segment_ = false;
+  if (!closed) {
+    fprintf(stderr, "Cannot close segment %lld: %s\n",
+            static_cast<long long>(segment_number_), strerror(errno));
+    return false;
+  }
+  ++segments_written_;
+
+  if (max_segments_ > 0) {
+    const int64 expired_number = segment_number_ - max_segments_;
+    if (expired_number >= start_number_)
+      unlink(SegmentPath(expired_number).c_str());
+  }
+  ++segment_number_;
+  return true;
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,173 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_CHUNK_SINK_H_
+#define SHARED_WEBM_CHUNK_SINK_H_
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Contiguous piece of a chunk. |WebMLiveMuxer::WriteChunk()| passes each
+// chunk to sinks as one piece, in place in the muxer's buffers.
+struct WebMChunkPiece {
+  const uint8* data;
+  size_t size;
+};
+
+// Destination of the chunks of a |WebMLiveMuxer|, written with
+// |WebMLiveMuxer::WriteChunk()|. A live packager is a loop of
+// |WebMLiveMuxer::ChunkReady()| and |WebMLiveMuxer::WriteChunk()| calls.
+class WebMChunkSink {
+ public:
+  virtual ~WebMChunkSink() {}
+
+  // Writes the |num_pieces| pieces of one chunk in order. |flags| are the
+  // |WebMLiveMuxer::ChunkFlags| of the chunk. The pieces are only valid
+  // during the call. Returns true when successful.
+  virtual bool WriteChunk(const WebMChunkPiece* pieces, size_t num_pieces,
+                          int flags) = 0;
+};
+
+// Writes chunks to a file descriptor, such as a pipe or a file, with one
+// |writev()| per chunk in most cases.
+//
+// Notes:
+// - The descriptor must be blocking. Partial writes are retried.
+//
+// - Writes to a socket do not raise SIGPIPE. Writes to a pipe whose reader
+//   exited do, unless the application ignores the signal.
+class WebMFdChunkSink : public WebMChunkSink {
+ public:
+  // Writes to |fd|, which the sink does not close.
+  explicit WebMFdChunkSink(int fd);
+  virtual ~WebMFdChunkSink();
+
+  // WebMChunkSink methods
+  virtual bool WriteChunk(const WebMChunkPiece* pieces, size_t num_pieces,
+                          int flags);
+
+  // Accessors.
+  int fd() const { return fd_; }
+  int64 bytes_written() const { return bytes_written_; }
+
+ protected:
+  // Closes the current descriptor if the sink owns it, and writes to |fd|.
+  // |owns_fd| tells if the sink closes |fd|.
+  void Reset(int fd, bool owns_fd);
+
+ private:
+  int fd_;
+  bool owns_fd_;
+  bool is_socket_;
+  int64 bytes_written_;
+
+  // Reused for every chunk, so steady state writes do not allocate.
+  std::vector<struct iovec> iovecs_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMFdChunkSink);
+};
+
+// Writes chunks to a TCP connection, for instance to a local packager or
+// relay.
+class WebMTcpChunkSink : public WebMFdChunkSink {
+ public:
+  WebMTcpChunkSink();
+  virtual ~WebMTcpChunkSink() {}
+
+  // Connects to |host| on |port|, with Nagle's algorithm disabled so chunks
+  // are sent as soon as they are written. Returns true when successful.
+  bool Connect(const std::string& host, int port);
+
+ private:
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMTcpChunkSink);
+};
+
+// Writes each Cluster to its own numbered file, as expected by DASH
+// SegmentTemplate addressing. Data written before the first Cluster, the
+// EBML header, Segment Info and Tracks, goes to an initialization file.
+//
+// Notes:
+// - |segment_template| names the segment files. "$Number$" is replaced by
+//   the segment number, and "$Number%0<width>d$" by the segment number
+//   padded with zeros to |width| digits.
+//
+// - A segment file is closed when the chunk ending its Cluster is written,
+//   so partial chunks of low latency muxers are appended to the open file.
+//
+// - With |set_max_segments()|, the oldest segment files are removed so the
+//   sink keeps a rolling window of segments.
+class WebMSegmentFileChunkSink : public WebMChunkSink {
+ public:
+  // Segments are numbered from |start_number|.
+  WebMSegmentFileChunkSink(const std::string& init_path,
+                           const std::string& segment_template,
+                           int64 start_number);
+  virtual ~WebMSegmentFileChunkSink();
+
+  // Checks |segment_template|. Returns true when it holds a "$Number$"
+  // identifier.
+  bool Init();
+
+  // Closes the open file. Returns true when successful.
+  bool Close();
+
+  // Returns the name of segment |number|.
+  std::string SegmentPath(int64 number) const;
+
+  // Keeps at most |max_segments| segment files, removing the oldest ones. 0,
+  // the default, keeps every segment.
+  void set_max_segments(int max_segments) { max_segments_ = max_segments; }
+
+  // WebMChunkSink methods
+  virtual bool WriteChunk(const WebMChunkPiece* pieces, size_t num_pieces,
+                          int flags);
+
+  // Accessors.
+  // Number of the segment being written, or of the next one when no
+  // segment file is open.
+  int64 segment_number() const { return segment_number_; }
+  int64 segments_written() const { return segments_written_; }
+
+ private:
+  // Creates or truncates |path| and opens it.
+  bool Open(const std::string& path);
+
+  // Closes the open segment and removes the segments out of the window.
+  bool CloseSegment();
+
+  const std::string init_path_;
+  const std::string segment_template_;
+  const int64 start_number_;
+  int max_segments_;
+
+  // Position of the "$Number" identifier in |segment_template_|, its length
+  // and the padding width.
+  size_t number_pos_;
+  size_t number_length_;
+  int number_width_;
+
+  int fd_;
+  bool in_segment_;
+  bool init_written_;
+  int64 segment_number_;
+  int64 segments_written_;
+
+  // Reused for every chunk, so steady state writes do not allocate.
+  std::vector<struct iovec> iovecs_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMSegmentFileChunkSink);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_CHUNK_SINK_H_
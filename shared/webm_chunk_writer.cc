@@ -9,44 +9,122 @@
 #include "webm_chunk_writer.h"
 
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <utility>
 #include <vector>
 
 #include "mkvmuxer.hpp"
 #include "webmids.hpp"
+#include "webm_log.h"
 
 namespace webm_tools {
 
 WebMChunkWriter::WebMChunkWriter()
     : bytes_buffered_(0),
       bytes_written_(0),
-      chunk_end_(0),
-      ptr_write_buffer_(NULL) {
+      initialized_(false),
+      chunks_emitted_(0),
+      bytes_emitted_(0),
+      max_bytes_buffered_(0),
+      chunks_completed_(0) {
 }
 
 WebMChunkWriter::~WebMChunkWriter() {
 }
 
-int32 WebMChunkWriter::Init(WriteBuffer* ptr_write_buffer) {
-  if (!ptr_write_buffer) {
-    fprintf(stderr, "Cannot Init, NULL write buffer.\n");
+int32 WebMChunkWriter::Init() {
+  chunks_.clear();
+  bytes_buffered_ = 0;
+  bytes_written_ = 0;
+  chunks_completed_ = 0;
+  OpenChunk(false);
+  initialized_ = true;
+  return kSuccess;
+}
+
+int32 WebMChunkWriter::CopyChunk(uint8* ptr_buf) const {
+  if (!initialized_) {
+    fprintf(stderr, "Cannot CopyChunk, not Initialized.\n");
+    return kNotInitialized;
+  }
+  if (!ptr_buf) {
+    fprintf(stderr, "Error invalid arg passed to CopyChunk.\n");
     return kInvalidArg;
   }
-  ptr_write_buffer_ = ptr_write_buffer;
+
+  // The open chunk at the back is never read.
+  if (chunk_end() > 0) {
+    const WriteBuffer& chunk = chunks_.front().data;
+    memcpy(ptr_buf, &chunk[0], chunk.size());
+  }
   return kSuccess;
 }
 
 void WebMChunkWriter::EraseChunk() {
-  if (ptr_write_buffer_) {
-    WriteBuffer::iterator erase_end_pos =
-        ptr_write_buffer_->begin() + static_cast<int32>(chunk_end_);
-    ptr_write_buffer_->erase(ptr_write_buffer_->begin(), erase_end_pos);
-    bytes_buffered_ = ptr_write_buffer_->size();
-    chunk_end_ = 0;
+  if (initialized_ && chunks_.size() > 1)
+    PopChunk(chunk_end());
+}
+
+void WebMChunkWriter::EndPartialChunk() {
+  if (initialized_ && !chunks_.back().data.empty())
+    CompleteChunk(false);
+}
+
+int32 WebMChunkWriter::ReadChunk(WriteBuffer* ptr_chunk) {
+  if (!initialized_) {
+    fprintf(stderr, "Cannot ReadChunk, not Initialized.\n");
+    return kNotInitialized;
+  }
+  if (!ptr_chunk) {
+    fprintf(stderr, "Error invalid arg passed to ReadChunk.\n");
+    return kInvalidArg;
+  }
+
+  if (chunks_.size() > 1) {
+    // Hand over the buffer of the oldest completed chunk. The buffer then
+    // holds the storage swapped in from |ptr_chunk|, so the chunk size is
+    // taken first.
+    const int64 chunk_bytes = chunk_end();
+    ptr_chunk->swap(chunks_.front().data);
+    PopChunk(chunk_bytes);
+  } else {
+    ptr_chunk->clear();
+  }
+  return kSuccess;
+}
+
+void WebMChunkWriter::CompleteChunk(bool ends_cluster) {
+  chunks_.back().ends_cluster = ends_cluster;
+  ++chunks_completed_;
+  OpenChunk(ends_cluster);
+}
+
+void WebMChunkWriter::OpenChunk(bool starts_cluster) {
+  chunks_.push_back(Chunk());
+  if (!free_buffers_.empty()) {
+    chunks_.back().data.swap(free_buffers_.back());
+    free_buffers_.pop_back();
+  }
+  chunks_.back().starts_cluster = starts_cluster;
+}
+
+void WebMChunkWriter::PopChunk(int64 chunk_bytes) {
+  WriteBuffer& chunk = chunks_.front().data;
+  if (free_buffers_.size() < kMaxFreeBuffers && chunk.capacity() > 0) {
+    chunk.clear();
+    free_buffers_.push_back(std::move(chunk));
+  }
+  chunks_.pop_front();
+  if (chunk_bytes > 0) {
+    ++chunks_emitted_;
+    bytes_emitted_ += chunk_bytes;
   }
+  bytes_buffered_ -= chunk_bytes;
 }
 
 int32 WebMChunkWriter::Write(const void* ptr_buffer, uint32 buffer_length) {
-  if (!ptr_write_buffer_) {
+  if (!initialized_) {
     fprintf(stderr, "Cannot Write, not Initialized.\n");
     return kNotInitialized;
   }
@@ -55,18 +133,30 @@ int32 WebMChunkWriter::Write(const void* ptr_buffer, uint32 buffer_length) {
     return kInvalidArg;
   }
   const uint8* ptr_data = reinterpret_cast<const uint8*>(ptr_buffer);
-  ptr_write_buffer_->insert(ptr_write_buffer_->end(),
-                            ptr_data,
-                            ptr_data + buffer_length);
+  WriteBuffer& chunk = chunks_.back().data;
+  chunk.insert(chunk.end(), ptr_data, ptr_data + buffer_length);
   bytes_written_ += buffer_length;
-  bytes_buffered_ = ptr_write_buffer_->size();
+  bytes_buffered_ += buffer_length;
+  if (bytes_buffered_ > max_bytes_buffered_)
+    max_bytes_buffered_ = bytes_buffered_;
   return kSuccess;
 }
 
 void WebMChunkWriter::ElementStartNotify(uint64 element_id, int64 position) {
   if (element_id == mkvmuxer::kMkvCluster) {
-    chunk_end_ = bytes_buffered_;
-    fprintf(stdout, "chunk_end_=%lld position=%lld\n", chunk_end_, position);
+    // Data written before the Cluster completes the open chunk. If a
+    // partial chunk was just completed it now ends the Cluster, unless it
+    // was already read.
+    if (initialized_) {
+      if (!chunks_.back().data.empty()) {
+        CompleteChunk(true);
+      } else {
+        if (chunks_.size() > 1)
+          chunks_[chunks_.size() - 2].ends_cluster = true;
+        chunks_.back().starts_cluster = true;
+      }
+    }
+    WEBM_TRACE("chunk_end=%lld position=%lld\n", chunk_end(), position);
   }
 }
 
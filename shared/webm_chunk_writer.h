@@ -9,6 +9,7 @@
 #ifndef SHARED_WEBM_CHUNK_WRITER_H_
 #define SHARED_WEBM_CHUNK_WRITER_H_
 
+#include <deque>
 #include <vector>
 
 #include "mkvmuxer.hpp"
@@ -16,8 +17,13 @@
 
 namespace webm_tools {
 
-// Buffer object implementing libwebm's IMkvWriter interface. Uses
-// |WriteBuffer| passed to |Init()| to store data written by libwebm.
+// Buffer object implementing libwebm's IMkvWriter interface. Data written by
+// libwebm is stored in a list of |WriteBuffer|s holding one chunk each:
+// every Cluster start completes the chunk being written and opens a new one.
+// |EndPartialChunk()| completes the chunk being written inside a Cluster.
+// Completed chunks are read one at a time, oldest first, so a chunk never
+// spans a Cluster start. Erasing a chunk pops it off the list, so buffered
+// data is never moved, and its buffer is recycled for later chunks.
 class WebMChunkWriter : public mkvmuxer::IMkvWriter {
  public:
   typedef std::vector<uint8> WriteBuffer;
@@ -31,17 +37,59 @@ class WebMChunkWriter : public mkvmuxer::IMkvWriter {
   WebMChunkWriter();
   virtual ~WebMChunkWriter();
 
-  // Stores |ptr_buffer| and returns |kSuccess|.
-  int32 Init(WriteBuffer* ptr_write_buffer);
+  // Discards all buffered data, opens the first chunk and returns
+  // |kSuccess|.
+  int32 Init();
 
   // Accessors.
+  int64 bytes_buffered() const { return bytes_buffered_; }
   int64 bytes_written() const { return bytes_written_; }
-  int64 chunk_end() const { return chunk_end_; }
-
-  // Erases chunk from |ptr_write_buffer_|, resets |chunk_end_| to 0, and
-  // updates |bytes_buffered_|.
+  int64 chunk_end() const {
+    return chunks_.size() > 1 ?
+        static_cast<int64>(chunks_.front().data.size()) : 0;
+  }
+  int64 chunks_emitted() const { return chunks_emitted_; }
+  int64 bytes_emitted() const { return bytes_emitted_; }
+  int64 max_bytes_buffered() const { return max_bytes_buffered_; }
+  int64 chunks_completed() const { return chunks_completed_; }
+  int64 open_chunk_bytes() const {
+    return chunks_.empty() ?
+        0 : static_cast<int64>(chunks_.back().data.size());
+  }
+
+  // Oldest completed chunk, holding the |chunk_end()| bytes returned by
+  // |ReadChunk()|. Lets callers write the chunk in place before calling
+  // |EraseChunk()|. Only valid when |chunk_end()| is greater than 0.
+  const WriteBuffer& ready_chunk() const { return chunks_.front().data; }
+
+  // Flags of the oldest completed chunk. |chunk_starts_cluster()| is true
+  // when the chunk starts with a Cluster element, and |chunk_ends_cluster()|
+  // is true when it ends where a Cluster starts.
+  bool chunk_starts_cluster() const {
+    return chunks_.size() > 1 && chunks_.front().starts_cluster;
+  }
+  bool chunk_ends_cluster() const {
+    return chunks_.size() > 1 && chunks_.front().ends_cluster;
+  }
+
+  // Completes the open chunk at the current write position, so data of an
+  // open Cluster can be read before the Cluster ends. Does nothing if no
+  // data was written since the last chunk was completed.
+  void EndPartialChunk();
+
+  // Copies the |chunk_end()| bytes of the oldest completed chunk to
+  // |ptr_buf|. Returns |kNotInitialized| before |Init()|.
+  int32 CopyChunk(uint8* ptr_buf) const;
+
+  // Erases the oldest completed chunk from |chunks_| and updates
+  // |bytes_buffered_|. The next completed chunk, if any, becomes ready.
   void EraseChunk();
 
+  // Swaps the oldest completed chunk with |ptr_chunk| without copying and
+  // erases it. The storage previously held by |ptr_chunk| is recycled for a
+  // later chunk. Returns |kNotInitialized| before |Init()|.
+  int32 ReadChunk(WriteBuffer* ptr_chunk);
+
   // mkvmuxer::IMkvWriter methods
   // Returns total bytes of data passed to |Write|.
   virtual int64 Position() const { return bytes_written_; }
@@ -50,20 +98,66 @@ class WebMChunkWriter : public mkvmuxer::IMkvWriter {
   virtual int32 Position(int64 /* pos */) { return kNotImplemented; }
 
   // Always returns false: |WebMChunkWriter| is never seekable. Written data
-  // goes into a vector, and data is buffered only until a chunk is completed.
+  // goes into |chunks_|, and data is buffered only until a chunk is read.
   virtual bool Seekable() const { return false; }
 
-  // Writes |ptr_buffer| contents to |ptr_write_buffer_|.
+  // Appends |ptr_buffer| contents to the open chunk.
   virtual int32 Write(const void* ptr_buffer, uint32 buffer_length);
 
   // Called by libwebm, and notifies writer of element start position.
   virtual void ElementStartNotify(uint64 element_id, int64 position);
 
  private:
+  // Number of erased chunk buffers kept for reuse.
+  static const size_t kMaxFreeBuffers = 4;
+
+  // One buffered chunk and its flags.
+  struct Chunk {
+    Chunk() : starts_cluster(false), ends_cluster(false) {}
+
+    WriteBuffer data;
+
+    // True when |data| starts with a Cluster element, and when it ends where
+    // a Cluster starts.
+    bool starts_cluster;
+    bool ends_cluster;
+  };
+
+  // Appends a new open chunk to |chunks_|, reusing a buffer from
+  // |free_buffers_| when one is available. |starts_cluster| tells if the
+  // chunk starts with a Cluster element.
+  void OpenChunk(bool starts_cluster);
+
+  // Completes the open chunk and opens a new one. |ends_cluster| tells if the
+  // chunk ends where a Cluster starts, in which case the new chunk starts
+  // with the Cluster.
+  void CompleteChunk(bool ends_cluster);
+
+  // Pops the oldest completed chunk, |chunk_bytes| long, off |chunks_| and
+  // recycles its buffer.
+  void PopChunk(int64 chunk_bytes);
+
   int64 bytes_buffered_;
   int64 bytes_written_;
-  int64 chunk_end_;
-  WriteBuffer* ptr_write_buffer_;
+  bool initialized_;
+
+  // Number and total size of the chunks erased after being read, and the
+  // largest value of |bytes_buffered_|.
+  int64 chunks_emitted_;
+  int64 bytes_emitted_;
+  int64 max_bytes_buffered_;
+
+  // Number of chunks completed since |Init()|.
+  int64 chunks_completed_;
+
+  // Buffered chunks in write order. The last chunk is the open chunk
+  // receiving |Write()| data; the chunks before it are completed, and the
+  // first one is read next.
+  std::deque<Chunk> chunks_;
+
+  // Erased chunk buffers. They keep their capacity, so writes to a recycled
+  // chunk do not reallocate once the buffers have grown to the chunk size.
+  std::vector<WriteBuffer> free_buffers_;
   WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMChunkWriter);
 };
 
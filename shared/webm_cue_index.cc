@@ -0,0 +1,242 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_cue_index.h"
+
+#include <cstring>
+
+namespace webm_tools {
+
+namespace {
+
+const size_t kMagicSize = 4;
+
+void PutLittleEndian(uint64 value, int bytes, std::vector<uint8>* buffer) {
+  for (int i = 0; i < bytes; ++i)
+    buffer->push_back(static_cast<uint8>(value >> (8 * i)));
+}
+
+uint64 GetLittleEndian(const uint8* data, int bytes) {
+  uint64 value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    value = (value << 8) | data[i];
+  return value;
+}
+
+void PutVarint(uint64 value, std::vector<uint8>* buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<uint8>(value | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<uint8>(value));
+}
+
+// Reads a varint at |*pos| and advances |*pos|. Returns false if the varint
+// runs past |size| or does not fit 64 bits.
+bool GetVarint(const uint8* data, size_t size, size_t* pos, uint64* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*pos >= size)
+      return false;
+    const uint8 byte = data[(*pos)++];
+    *value |= static_cast<uint64>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+uint64 ZigZagEncode(int64 value) {
+  return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63);
+}
+
+int64 ZigZagDecode(uint64 value) {
+  return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+}
+
+// Parses the header of the |size| bytes of |data|. Sets |flags| and
+// |num_entries|, and the header fields of |index|.
+bool ParseHeader(const uint8* data, size_t size, uint8* flags,
+                 int64* num_entries, WebMCueIndex* index) {
+  if (!data || size < kWebMCueIndexHeaderSize ||
+      memcmp(data, kWebMCueIndexMagic, kMagicSize) ||
+      data[4] != kWebMCueIndexVersion) {
+    return false;
+  }
+
+  *flags = data[5];
+  index->timescale = static_cast<uint32>(GetLittleEndian(data + 8, 4));
+  *num_entries = static_cast<int64>(GetLittleEndian(data + 12, 4));
+  index->init_offset = static_cast<int64>(GetLittleEndian(data + 16, 8));
+  index->init_size = static_cast<int64>(GetLittleEndian(data + 24, 8));
+  return index->timescale > 0 && (*flags & ~kWebMCueIndexCompressed) == 0;
+}
+
+}  // namespace
+
+bool SerializeWebMCueIndex(const WebMCueIndex& index, bool compressed,
+                           std::vector<uint8>* buffer) {
+  if (!buffer || index.timescale == 0 || index.entries.size() > 0xffffffff)
+    return false;
+
+  buffer->clear();
+  buffer->reserve(kWebMCueIndexHeaderSize +
+                  index.entries.size() * kWebMCueIndexEntrySize);
+  buffer->insert(buffer->end(), kWebMCueIndexMagic,
+                 kWebMCueIndexMagic + kMagicSize);
+  buffer->push_back(kWebMCueIndexVersion);
+  buffer->push_back(compressed ? kWebMCueIndexCompressed : 0);
+  PutLittleEndian(0, 2, buffer);
+  PutLittleEndian(index.timescale, 4, buffer);
+  PutLittleEndian(index.entries.size(), 4, buffer);
+  PutLittleEndian(index.init_offset, 8, buffer);
+  PutLittleEndian(index.init_size, 8, buffer);
+
+  int64 last_time = 0;
+  int64 last_end = 0;
+  for (size_t i = 0; i < index.entries.size(); ++i) {
+    const WebMCueIndexEntry& entry = index.entries[i];
+    if ((i > 0 && entry.time < last_time) || entry.offset < 0 ||
+        entry.size < 0 || entry.size > 0xffffffff) {
+      return false;
+    }
+
+    if (compressed) {
+      PutVarint(ZigZagEncode(entry.time - last_time), buffer);
+      PutVarint(ZigZagEncode(entry.offset - last_end), buffer);
+      PutVarint((static_cast<uint64>(entry.size) << 1) |
+                (entry.key_frame ? 1 : 0), buffer);
+    } else {
+      PutLittleEndian(entry.time, 8, buffer);
+      PutLittleEndian(entry.offset, 8, buffer);
+      PutLittleEndian(entry.size, 4, buffer);
+      PutLittleEndian(entry.key_frame ? kWebMCueIndexKeyFrame : 0, 4, buffer);
+    }
+    last_time = entry.time;
+    last_end = entry.offset + entry.size;
+  }
+
+  return true;
+}
+
+bool ParseWebMCueIndex(const uint8* data, size_t size, WebMCueIndex* index) {
+  if (!index)
+    return false;
+
+  uint8 flags = 0;
+  int64 num_entries = 0;
+  if (!ParseHeader(data, size, &flags, &num_entries, index))
+    return false;
+
+  index->entries.clear();
+  if (!(flags & kWebMCueIndexCompressed)) {
+    WebMCueIndexReader reader;
+    if (!reader.Init(data, size))
+      return false;
+    index->entries.resize(static_cast<size_t>(num_entries));
+    for (int64 i = 0; i < num_entries; ++i)
+      reader.GetEntry(i, &index->entries[static_cast<size_t>(i)]);
+    return true;
+  }
+
+  // A compressed entry is at least 3 bytes.
+  size_t pos = kWebMCueIndexHeaderSize;
+  if (static_cast<uint64>(num_entries) > (size - pos) / 3)
+    return false;
+  index->entries.resize(static_cast<size_t>(num_entries));
+
+  int64 last_time = 0;
+  int64 last_end = 0;
+  for (size_t i = 0; i < index->entries.size(); ++i) {
+    uint64 time_delta = 0;
+    uint64 offset_delta = 0;
+    uint64 size_and_flag = 0;
+    if (!GetVarint(data, size, &pos, &time_delta) ||
+        !GetVarint(data, size, &pos, &offset_delta) ||
+        !GetVarint(data, size, &pos, &size_and_flag)) {
+      return false;
+    }
+
+    WebMCueIndexEntry& entry = index->entries[i];
+    entry.time = last_time + ZigZagDecode(time_delta);
+    entry.offset = last_end + ZigZagDecode(offset_delta);
+    entry.size = static_cast<int64>(size_and_flag >> 1);
+    entry.key_frame = (size_and_flag & 1) != 0;
+    last_time = entry.time;
+    last_end = entry.offset + entry.size;
+  }
+
+  return pos == size;
+}
+
+WebMCueIndexReader::WebMCueIndexReader()
+    : entries_(NULL),
+      num_entries_(0),
+      timescale_(0),
+      init_offset_(0),
+      init_size_(0) {
+}
+
+WebMCueIndexReader::~WebMCueIndexReader() {
+}
+
+bool WebMCueIndexReader::Init(const uint8* data, size_t size) {
+  WebMCueIndex header;
+  uint8 flags = 0;
+  int64 num_entries = 0;
+  if (!ParseHeader(data, size, &flags, &num_entries, &header) ||
+      (flags & kWebMCueIndexCompressed)) {
+    return false;
+  }
+  if (size != kWebMCueIndexHeaderSize +
+                  static_cast<uint64>(num_entries) * kWebMCueIndexEntrySize) {
+    return false;
+  }
+
+  entries_ = data + kWebMCueIndexHeaderSize;
+  num_entries_ = num_entries;
+  timescale_ = header.timescale;
+  init_offset_ = header.init_offset;
+  init_size_ = header.init_size;
+  return true;
+}
+
+bool WebMCueIndexReader::GetEntry(int64 index,
+                                  WebMCueIndexEntry* entry) const {
+  if (!entry || index < 0 || index >= num_entries_)
+    return false;
+
+  const uint8* const data = entries_ + index * kWebMCueIndexEntrySize;
+  entry->time = static_cast<int64>(GetLittleEndian(data, 8));
+  entry->offset = static_cast<int64>(GetLittleEndian(data + 8, 8));
+  entry->size = static_cast<int64>(GetLittleEndian(data + 16, 4));
+  entry->key_frame =
+      (GetLittleEndian(data + 20, 4) & kWebMCueIndexKeyFrame) != 0;
+  return true;
+}
+
+int64 WebMCueIndexReader::FindEntry(int64 time) const {
+  // Binary search for the first entry starting after |time|.
+  int64 low = 0;
+  int64 high = num_entries_;
+  while (low < high) {
+    const int64 middle = low + (high - low) / 2;
+    if (EntryTime(middle) <= time)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low - 1;
+}
+
+int64 WebMCueIndexReader::EntryTime(int64 index) const {
+  return static_cast<int64>(
+      GetLittleEndian(entries_ + index * kWebMCueIndexEntrySize, 8));
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,140 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_CUE_INDEX_H_
+#define SHARED_WEBM_CUE_INDEX_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Compact index of the cues of a WebM file, written next to the file so
+// players can get the byte range of every chunk without parsing EBML. The
+// format does not depend on libwebm. All values are little-endian.
+//
+// Header, 32 bytes:
+//   offset  size  field
+//   0       4     magic "WCIX"
+//   4       1     version, 1
+//   5       1     flags, |kWebMCueIndexCompressed| or 0
+//   6       2     reserved, 0
+//   8       4     timescale, entry time units per second
+//   12      4     entry count
+//   16      8     initialization range offset
+//   24      8     initialization range size
+//
+// Fixed layout entries follow the header, 24 bytes each, sorted by time:
+//   0       8     time, signed
+//   8       8     offset in the file
+//   16      4     size
+//   20      4     flags, bit 0 set when the chunk starts with a key frame
+//
+// The fixed layout can be mapped and binary searched in place with
+// |WebMCueIndexReader|. When |kWebMCueIndexCompressed| is set each entry is
+// instead three LEB128 varints: the zigzag encoded difference to the time of
+// the previous entry, the zigzag encoded difference between the offset and
+// the end of the previous entry, and the size shifted left by one with the
+// key frame flag in bit 0. The previous entry of the first entry has a time,
+// offset and size of 0. Compressed indexes are read with
+// |ParseWebMCueIndex()|.
+
+const char kWebMCueIndexMagic[] = "WCIX";
+const char kWebMCueIndexExtension[] = ".cidx";
+const uint8 kWebMCueIndexVersion = 1;
+const uint8 kWebMCueIndexCompressed = 1;
+const uint32 kWebMCueIndexKeyFrame = 1;
+const size_t kWebMCueIndexHeaderSize = 32;
+const size_t kWebMCueIndexEntrySize = 24;
+
+// Byte range of the WebM file starting at a cue point.
+struct WebMCueIndexEntry {
+  WebMCueIndexEntry() : time(0), offset(0), size(0), key_frame(false) {}
+
+  // Start time in |WebMCueIndex::timescale| units.
+  int64 time;
+
+  // Range in bytes from the start of the file.
+  int64 offset;
+  int64 size;
+
+  // True if the range starts with a key frame.
+  bool key_frame;
+};
+
+struct WebMCueIndex {
+  WebMCueIndex() : timescale(1000), init_offset(0), init_size(0) {}
+
+  uint32 timescale;
+
+  // Range of the initialization segment, the bytes before the first Cluster.
+  int64 init_offset;
+  int64 init_size;
+
+  std::vector<WebMCueIndexEntry> entries;
+};
+
+// Serializes |index| to |buffer|, with compressed entries when |compressed|
+// is true. Returns false if the entries are not sorted by time or a value
+// does not fit the format.
+bool SerializeWebMCueIndex(const WebMCueIndex& index, bool compressed,
+                           std::vector<uint8>* buffer);
+
+// Parses an index of either layout from the |size| bytes of |data|. Returns
+// false if the data is not a valid index.
+bool ParseWebMCueIndex(const uint8* data, size_t size, WebMCueIndex* index);
+
+// Reads the fixed layout in place. The data must outlive the reader.
+//
+// Usage:
+//   WebMCueIndexReader reader;
+//   if (!reader.Init(data, size))
+//     return false;
+//   WebMCueIndexEntry entry;
+//   if (!reader.GetEntry(reader.FindEntry(seek_time), &entry))
+//     return false;
+//   // Request bytes [entry.offset, entry.offset + entry.size).
+class WebMCueIndexReader {
+ public:
+  WebMCueIndexReader();
+  ~WebMCueIndexReader();
+
+  // Checks the header and size of the |size| bytes of |data|. Returns false
+  // if the data is not a fixed layout index.
+  bool Init(const uint8* data, size_t size);
+
+  // Sets |entry| to entry |index|. Returns false if |index| is out of range.
+  bool GetEntry(int64 index, WebMCueIndexEntry* entry) const;
+
+  // Returns the index of the last entry starting at or before |time|, in
+  // timescale units, or -1 if there is none.
+  int64 FindEntry(int64 time) const;
+
+  uint32 timescale() const { return timescale_; }
+  int64 init_offset() const { return init_offset_; }
+  int64 init_size() const { return init_size_; }
+  int64 num_entries() const { return num_entries_; }
+
+ private:
+  // Returns the time of entry |index|.
+  int64 EntryTime(int64 index) const;
+
+  const uint8* entries_;
+  int64 num_entries_;
+  uint32 timescale_;
+  int64 init_offset_;
+  int64 init_size_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMCueIndexReader);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_CUE_INDEX_H_
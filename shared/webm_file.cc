@@ -795,6 +795,30 @@ bool WebMFile::CuesFirstInCluster(TrackTypes type) const {
   return true;
 }
 
+bool WebMFile::CueKeyFrames(vector<bool>* key_frames) const {
+  if (!key_frames || state_ <= kParsingHeader)
+    return false;
+  const mkvparser::Cues* const cues = GetCues();
+  if (!cues)
+    return false;
+  const mkvparser::Track* const track = GetTrack(0);
+  if (!track)
+    return false;
+
+  key_frames->clear();
+  for (const mkvparser::CuePoint* cp = cues->GetFirst();
+       cp;
+       cp = cues->GetNext(cp)) {
+    const mkvparser::Block* block = NULL;
+    const mkvparser::Cluster* cluster = NULL;
+    if (!GetIndexedBlock(*cp, *track, 0, &cluster, &block))
+      return false;
+    key_frames->push_back(StartsWithKey(*cp, *cluster, *block));
+  }
+
+  return true;
+}
+
 int WebMFile::DisplayWidth() const {
   int display_width = 0;
   const mkvparser::VideoTrack* const vid_track = GetVideoTrack();
@@ -988,6 +1012,15 @@ int64 WebMFile::GetSegmentStartOffset() const {
   return segment_->m_start;
 }
 
+int64 WebMFile::OutputTimecodeScale() const {
+  const mkvparser::SegmentInfo* const info = GetSegmentInfo();
+  if (!info || info->GetTimeCodeScale() <= 0 ||
+      kNanosecondsPerSecondi % info->GetTimeCodeScale() != 0) {
+    return 1;
+  }
+  return info->GetTimeCodeScale();
+}
+
 bool WebMFile::OnlyOneStream() const {
   if (state_ <= kParsingHeader)
     return false;
@@ -196,6 +196,13 @@ class WebMFile {
   // output to be valid.
   bool CuesFirstInCluster(TrackTypes type) const;
 
+  // Sets |key_frames| to one value per CuePoint, in Cues order, telling if
+  // the first Block of the first track referenced by the CuePoint is a key
+  // frame at the time of the CuePoint. The values match the entries of
+  // |cue_desc_list()|. Returns false on error. Parser state must equal
+  // kParsingDone for output to be valid.
+  bool CueKeyFrames(std::vector<bool>* key_frames) const;
+
   // Returns true if the file has accurate cluster duration for all the
   // Clusters. The last Cluster is not checked. By convention it is still
   // considered to have accurate cluster duration irrespective of the last
@@ -281,6 +288,12 @@ class WebMFile {
   // be >= kParsingClusters for output to be valid.
   int64 GetSegmentStartOffset() const;
 
+  // Returns the unit in nanoseconds of the times output for the file: the
+  // TimecodeScale when a second is a whole number of them, which is the case
+  // for the default of 1 millisecond, and 1 otherwise. Parser state must be
+  // >= kParsingClusters for output to be valid.
+  int64 OutputTimecodeScale() const;
+
   // Returns true if the first video track equals V_VP8 / V_VP9 or the first
   // audio track equals A_OPUS / A_VORBIS. Returns false if there are no audio
   // or video tracks. Returns false if there is both a video tack and an audio
@@ -355,6 +368,10 @@ class WebMFile {
   // be valid.
   int VideoWidth() const;
 
+  // Returns the ranges between the cue points of the first track, in Cues
+  // order. Offsets are relative to the start of the Segment payload. Parser
+  // state must be kParsingDone for the list to be complete.
+  const std::vector<CueDesc>& cue_desc_list() const { return cue_desc_list_; }
   const std::string& filename() const { return filename_; }
   Status state() const { return state_; }
   mkvparser::IMkvReader* reader() { return reader_; }
@@ -0,0 +1,47 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_file_util.h"
+
+#include <cstdio>
+#include <string>
+
+namespace webm_tools {
+
+bool WriteFileAtomically(const std::string& path, const void* data,
+                         size_t size) {
+  const std::string temp_path = path + ".tmp";
+  FILE* const file = fopen(temp_path.c_str(), "wb");
+  if (!file) {
+    fprintf(stderr, "Cannot open %s.\n", temp_path.c_str());
+    return false;
+  }
+  const bool written = size == 0 || fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0 || !written) {
+    fprintf(stderr, "Cannot write %s.\n", temp_path.c_str());
+    remove(temp_path.c_str());
+    return false;
+  }
+  if (rename(temp_path.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "Cannot rename %s to %s.\n", temp_path.c_str(),
+            path.c_str());
+    remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+  if (directory.empty())
+    return name;
+  if (directory[directory.size() - 1] == '/')
+    return directory + name;
+  return directory + "/" + name;
+}
+
+}  // namespace webm_tools
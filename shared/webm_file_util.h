@@ -0,0 +1,28 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_FILE_UTIL_H_
+#define SHARED_WEBM_FILE_UTIL_H_
+
+#include <cstddef>
+#include <string>
+
+namespace webm_tools {
+
+// Writes |size| bytes of |data| to a temporary file renamed to |path|, so
+// readers of |path| never see a partial file. Returns true when successful.
+bool WriteFileAtomically(const std::string& path, const void* data,
+                         size_t size);
+
+// Returns |name| prefixed with |directory| and a separator, or |name| when
+// |directory| is empty.
+std::string JoinPath(const std::string& directory, const std::string& name);
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_FILE_UTIL_H_
@@ -0,0 +1,108 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_frame_encryptor.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace webm_tools {
+
+WebMFrameEncryptor::WebMFrameEncryptor()
+    : ctx_(NULL),
+      initial_iv_(0),
+      next_iv_(0) {
+}
+
+WebMFrameEncryptor::~WebMFrameEncryptor() {
+  if (ctx_)
+    EVP_CIPHER_CTX_free(ctx_);
+}
+
+bool WebMFrameEncryptor::GenerateInitialIV(uint64* ptr_iv) {
+  if (!ptr_iv) {
+    fprintf(stderr, "Error invalid arg passed to GenerateInitialIV.\n");
+    return false;
+  }
+  uint8 iv[kIVSize];
+  if (!RAND_bytes(iv, kIVSize)) {
+    fprintf(stderr, "Cannot generate random IV.\n");
+    return false;
+  }
+  memcpy(ptr_iv, iv, kIVSize);
+  return true;
+}
+
+bool WebMFrameEncryptor::Init(const std::string& key, uint64 initial_iv) {
+  if (key.size() != kKeySize) {
+    fprintf(stderr, "Encryption key must be %d bytes.\n", kKeySize);
+    return false;
+  }
+  if (!ctx_) {
+    ctx_ = EVP_CIPHER_CTX_new();
+    if (!ctx_) {
+      fprintf(stderr, "Cannot construct cipher context.\n");
+      return false;
+    }
+  }
+  if (!EVP_EncryptInit_ex(ctx_, EVP_aes_128_ctr(), NULL,
+                          reinterpret_cast<const uint8*>(key.data()), NULL)) {
+    fprintf(stderr, "Cannot set encryption key.\n");
+    return false;
+  }
+  key_ = key;
+  initial_iv_ = initial_iv;
+  next_iv_ = initial_iv;
+  return true;
+}
+
+bool WebMFrameEncryptor::EncryptFrame(const uint8* data, size_t size,
+                                      std::vector<uint8>* ptr_frame) {
+  if (!ctx_) {
+    fprintf(stderr, "Cannot EncryptFrame, not Initialized.\n");
+    return false;
+  }
+  if ((!data && size > 0) || !ptr_frame || size > INT_MAX) {
+    fprintf(stderr, "Error invalid arg passed to EncryptFrame.\n");
+    return false;
+  }
+
+  // The IV is stored in host byte order, like webm_crypt.
+  const uint64 iv = next_iv_++;
+  uint8 counter_block[kKeySize];
+  memcpy(counter_block, &iv, kIVSize);
+  memset(counter_block + kIVSize, 0, kKeySize - kIVSize);
+
+  // Only the counter changes; the key schedule set by |Init()| is kept.
+  if (!EVP_EncryptInit_ex(ctx_, NULL, NULL, NULL, counter_block)) {
+    fprintf(stderr, "Cannot set encryption counter.\n");
+    return false;
+  }
+
+  ptr_frame->resize(size + kHeaderSize);
+  uint8* const frame = &(*ptr_frame)[0];
+  frame[0] = kEncryptedFrame;
+  memcpy(frame + kSignalByteSize, &iv, kIVSize);
+  int encrypted_size = 0;
+  if (size > 0 &&
+      (!EVP_EncryptUpdate(ctx_, frame + kHeaderSize, &encrypted_size, data,
+                          static_cast<int>(size)) ||
+       encrypted_size != static_cast<int>(size))) {
+    fprintf(stderr, "Cannot encrypt frame.\n");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace webm_tools
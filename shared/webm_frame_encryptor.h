@@ -0,0 +1,93 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_FRAME_ENCRYPTOR_H_
+#define SHARED_WEBM_FRAME_ENCRYPTOR_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "webm_tools_types.h"
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace webm_tools {
+
+// Encryption settings of one track.
+struct WebMEncryptionConfig {
+  WebMEncryptionConfig() : initial_iv(0), has_initial_iv(false) {}
+
+  // Written as the ContentEncKeyID of the track.
+  std::string key_id;
+
+  // AES-128 key, |WebMFrameEncryptor::kKeySize| bytes.
+  std::string key;
+
+  // IV of the first frame, used when |has_initial_iv| is true. Otherwise
+  // |WebMLiveMuxer::SetTrackEncryption()| draws a random IV, so restarted
+  // streams do not reuse the AES-CTR keystream of earlier runs. The IV is
+  // incremented for every frame.
+  uint64 initial_iv;
+  bool has_initial_iv;
+};
+
+// Encrypts frames in the WebM encryption format, as webm_crypt does: a
+// signal byte, the 8 byte IV, then the frame encrypted with AES-128 in CTR
+// mode. The counter block of a frame is its IV followed by 8 zero bytes.
+//
+// Notes:
+// - The key schedule is computed once by |Init()|. Encrypting a frame only
+//   resets the counter of the cipher context.
+//
+// - Frames are never partitioned, and every frame is encrypted.
+class WebMFrameEncryptor {
+ public:
+  enum {
+    kKeySize = 16,
+    kIVSize = 8,
+    kSignalByteSize = 1,
+    kHeaderSize = kSignalByteSize + kIVSize,
+  };
+
+  // Signal byte of encrypted frames.
+  static const uint8 kEncryptedFrame = 0x1;
+
+  WebMFrameEncryptor();
+  ~WebMFrameEncryptor();
+
+  // Stores a random IV in |ptr_iv|. Returns true when successful.
+  static bool GenerateInitialIV(uint64* ptr_iv);
+
+  // Creates the cipher context for |key|, which must be |kKeySize| bytes.
+  // Returns true when successful.
+  bool Init(const std::string& key, uint64 initial_iv);
+
+  // Writes the encrypted |data| to |ptr_frame|, which is resized to
+  // |size| + |kHeaderSize| bytes. Callers reusing |ptr_frame| for every frame
+  // do not allocate once it has grown to the frame size. Returns true when
+  // successful.
+  bool EncryptFrame(const uint8* data, size_t size,
+                    std::vector<uint8>* ptr_frame);
+
+  // Accessors.
+  const std::string& key() const { return key_; }
+  uint64 initial_iv() const { return initial_iv_; }
+  uint64 next_iv() const { return next_iv_; }
+
+ private:
+  EVP_CIPHER_CTX* ctx_;
+  std::string key_;
+  uint64 initial_iv_;
+  uint64 next_iv_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMFrameEncryptor);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_FRAME_ENCRYPTOR_H_
@@ -0,0 +1,56 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_frame_pool.h"
+
+namespace webm_tools {
+
+WebMFramePool::WebMFramePool(size_t max_buffers)
+    : buffers_(max_buffers),
+      high_water_mark_(0),
+      allocations_(0) {
+}
+
+bool WebMFramePool::Init() {
+  return buffers_.Init();
+}
+
+void WebMFramePool::Copy(const uint8* data, size_t size, Buffer* buffer) {
+  if (!buffer)
+    return;
+
+  if (buffer->capacity() < size) {
+    Buffer pooled;
+    if (buffers_.TryPop(&pooled))
+      buffer->swap(pooled);
+    // |pooled| now holds the storage |buffer| had, which was too small.
+    Release(&pooled);
+  }
+
+  size_t high_water_mark = high_water_mark_;
+  while (size > high_water_mark &&
+         !high_water_mark_.compare_exchange_weak(high_water_mark, size)) {
+  }
+
+  if (buffer->capacity() < size) {
+    // Grow to the high water mark so the buffer fits the following frames.
+    buffer->reserve(size > high_water_mark ? size : high_water_mark);
+    ++allocations_;
+  }
+  buffer->assign(data, data + size);
+}
+
+void WebMFramePool::Release(Buffer* buffer) {
+  if (!buffer || buffer->capacity() == 0)
+    return;
+  buffer->clear();
+  // A full pool leaves |buffer| unchanged and its owner frees it.
+  buffers_.TryPush(buffer);
+}
+
+}  // namespace webm_tools
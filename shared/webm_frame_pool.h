@@ -0,0 +1,66 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_FRAME_POOL_H_
+#define SHARED_WEBM_FRAME_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "webm_mpmc_queue.h"
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Thread safe pool of frame payload buffers. Buffers released to the pool
+// keep their storage, and every buffer the pool allocates is sized to the
+// largest frame seen so far, so once the pool holds enough buffers of the
+// stream's high water mark copying frames does not allocate.
+//
+// Notes:
+// - Any thread may call |Copy()| and |Release()|.
+//
+// - At most |max_buffers| buffers are kept. Buffers released to a full pool
+//   are freed by their owner.
+class WebMFramePool {
+ public:
+  typedef std::vector<uint8> Buffer;
+
+  explicit WebMFramePool(size_t max_buffers);
+  ~WebMFramePool() {}
+
+  // Allocates the pool. Returns false when out of memory.
+  bool Init();
+
+  // Copies |size| bytes of |data| into |buffer|, replacing its storage with
+  // a pooled buffer when one is available.
+  void Copy(const uint8* data, size_t size, Buffer* buffer);
+
+  // Returns the storage of |buffer| to the pool. |buffer| is left empty.
+  void Release(Buffer* buffer);
+
+  // Accessors.
+  int64 allocations() const { return allocations_; }
+  size_t high_water_mark() const { return high_water_mark_; }
+
+ private:
+  MpmcQueue<Buffer> buffers_;
+
+  // Size of the largest frame copied.
+  std::atomic<size_t> high_water_mark_;
+
+  // Number of times |Copy()| allocated storage.
+  std::atomic<int64> allocations_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMFramePool);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_FRAME_POOL_H_
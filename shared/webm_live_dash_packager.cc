@@ -0,0 +1,487 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_live_dash_packager.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "webmids.hpp"
+#include "webm_file_util.h"
+#include "webm_live_muxer.h"
+#include "xml_writer.h"
+
+namespace webm_tools {
+
+namespace {
+
+const uint64 kNanosecondsPerSecond = 1000000000ULL;
+
+// Bytes of a chunk searched for the Cluster Timecode. Live Clusters start
+// with their ID, an 8 byte unknown size and the Timecode.
+const size_t kMaxClusterHeaderSize = 64;
+
+// Reads the EBML ID at |*ptr_pos| of |data| and advances |*ptr_pos|.
+bool ReadId(const uint8* data, size_t size, size_t* ptr_pos, uint64* ptr_id) {
+  size_t pos = *ptr_pos;
+  if (pos >= size || data[pos] == 0)
+    return false;
+  int length = 1;
+  while (length <= 4 && !(data[pos] & (0x80 >> (length - 1))))
+    ++length;
+  if (length > 4 || pos + length > size)
+    return false;
+  uint64 id = 0;
+  for (int i = 0; i < length; ++i)
+    id = (id << 8) | data[pos + i];
+  *ptr_pos = pos + length;
+  *ptr_id = id;
+  return true;
+}
+
+// Reads the EBML element size at |*ptr_pos| of |data| and advances
+// |*ptr_pos|. Unknown sizes are returned as -1.
+bool ReadSize(const uint8* data, size_t size, size_t* ptr_pos,
+              int64* ptr_size) {
+  size_t pos = *ptr_pos;
+  if (pos >= size || data[pos] == 0)
+    return false;
+  int length = 1;
+  while (!(data[pos] & (0x80 >> (length - 1))))
+    ++length;
+  if (pos + length > size)
+    return false;
+  uint64 value = data[pos] & (0xFF >> length);
+  bool all_ones = value == (0xFFU >> length);
+  for (int i = 1; i < length; ++i) {
+    value = (value << 8) | data[pos + i];
+    all_ones = all_ones && data[pos + i] == 0xFF;
+  }
+  *ptr_pos = pos + length;
+  *ptr_size = all_ones ? -1 : static_cast<int64>(value);
+  return true;
+}
+
+// Reads the Timecode of the Cluster starting the chunk made of |pieces|.
+bool ReadClusterTimecode(const WebMChunkPiece* pieces, size_t num_pieces,
+                         int64* ptr_timecode) {
+  uint8 header[kMaxClusterHeaderSize];
+  size_t size = 0;
+  for (size_t i = 0; i < num_pieces && size < sizeof(header); ++i) {
+    const size_t copy_size = std::min(pieces[i].size, sizeof(header) - size);
+    memcpy(header + size, pieces[i].data, copy_size);
+    size += copy_size;
+  }
+
+  size_t pos = 0;
+  uint64 id = 0;
+  int64 element_size = 0;
+  if (!ReadId(header, size, &pos, &id) || id != mkvmuxer::kMkvCluster ||
+      !ReadSize(header, size, &pos, &element_size)) {
+    return false;
+  }
+  while (ReadId(header, size, &pos, &id) &&
+         ReadSize(header, size, &pos, &element_size) && element_size >= 0) {
+    if (id == mkvmuxer::kMkvTimecode) {
+      if (element_size > 8 || pos + element_size > size)
+        return false;
+      uint64 timecode = 0;
+      for (int64 i = 0; i < element_size; ++i)
+        timecode = (timecode << 8) | header[pos + i];
+      *ptr_timecode = static_cast<int64>(timecode);
+      return true;
+    }
+    // Skip elements written before the Timecode, such as CRC-32 or Void.
+    pos += static_cast<size_t>(element_size);
+  }
+  return false;
+}
+
+// Returns |time| as an xs:dateTime in UTC.
+std::string FormatUtcTime(time_t time) {
+  struct tm utc;
+  char buffer[32];
+  if (!gmtime_r(&time, &utc) ||
+      !strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc)) {
+    return "1970-01-01T00:00:00Z";
+  }
+  return buffer;
+}
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMLiveDashPackager::RepresentationSink
+//
+
+// Writes the segment files of one Representation and reports each completed
+// segment to the packager.
+class WebMLiveDashPackager::RepresentationSink : public WebMChunkSink {
+ public:
+  RepresentationSink(WebMLiveDashPackager* packager, int index,
+                     const std::string& init_path,
+                     const std::string& media_template, int64 start_number)
+      : packager_(packager),
+        index_(index),
+        file_sink_(init_path, media_template, start_number),
+        segment_start_(-1),
+        segment_number_(start_number),
+        last_duration_(0) {
+  }
+  virtual ~RepresentationSink() {}
+
+  bool Init() { return file_sink_.Init(); }
+
+  // Closes the open segment and lists it with a duration running to
+  // |end_time|, or the duration of the previous segment.
+  bool Finish(int64 end_time) {
+    if (!file_sink_.Close())
+      return false;
+    if (segment_start_ < 0)
+      return true;
+    const int64 duration =
+        end_time > segment_start_ ? end_time - segment_start_ : last_duration_;
+    const int64 start = segment_start_;
+    segment_start_ = -1;
+    return packager_->AddSegment(index_, segment_number_, start, duration);
+  }
+
+  // WebMChunkSink methods
+  virtual bool WriteChunk(const WebMChunkPiece* pieces, size_t num_pieces,
+                          int flags) {
+    int64 cluster_start = -1;
+    if ((flags & WebMLiveMuxer::kChunkClusterStart) &&
+        !ReadClusterTimecode(pieces, num_pieces, &cluster_start)) {
+      fprintf(stderr, "Cannot read Cluster Timecode of representation %d.\n",
+              index_);
+      return false;
+    }
+    if (!file_sink_.WriteChunk(pieces, num_pieces, flags))
+      return false;
+    if (cluster_start < 0)
+      return true;
+
+    // The previous segment was closed by |file_sink_| and ends where this
+    // Cluster starts. |file_sink_| numbers every Cluster, so this one is the
+    // next segment. A Cluster that does not start after the previous one
+    // still closes a segment file, so the previous segment is listed with a
+    // duration of 1 rather than left out, which would shift the $Number$ of
+    // every later segment. The timeline then resumes after it.
+    bool listed = true;
+    if (segment_start_ >= 0) {
+      last_duration_ = std::max<int64>(cluster_start - segment_start_, 1);
+      listed = packager_->AddSegment(index_, segment_number_, segment_start_,
+                                     last_duration_);
+      ++segment_number_;
+      cluster_start = std::max(cluster_start, segment_start_ + last_duration_);
+    }
+    segment_start_ = cluster_start;
+    return listed;
+  }
+
+  void set_max_segments(int max_segments) {
+    file_sink_.set_max_segments(max_segments);
+  }
+
+ private:
+  WebMLiveDashPackager* const packager_;
+  const int index_;
+  WebMSegmentFileChunkSink file_sink_;
+
+  // Timecode and number of the open segment. |segment_start_| is -1 before
+  // the first Cluster.
+  int64 segment_start_;
+  int64 segment_number_;
+  int64 last_duration_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(RepresentationSink);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMLiveDashPackager
+//
+
+const char WebMLiveDashPackager::kLiveProfile[] =
+    "urn:mpeg:dash:profile:isoff-live:2011";
+
+WebMLiveDashPackager::WebMLiveDashPackager(const WebMLiveDashConfig& config)
+    : config_(config),
+      finished_(false),
+      manifest_updates_(0) {
+}
+
+WebMLiveDashPackager::~WebMLiveDashPackager() {
+}
+
+int WebMLiveDashPackager::AddRepresentation(
+    const WebMLiveDashRepresentationConfig& config) {
+  if (!representations_.empty()) {
+    fprintf(stderr, "Cannot AddRepresentation after Init.\n");
+    return -1;
+  }
+  if (config.id.empty() || config.init_name.empty() ||
+      config.media_template.empty()) {
+    fprintf(stderr, "Representation needs an id, init_name and "
+            "media_template.\n");
+    return -1;
+  }
+  representation_configs_.push_back(config);
+  return static_cast<int>(representation_configs_.size()) - 1;
+}
+
+bool WebMLiveDashPackager::Init() {
+  if (representation_configs_.empty() || !representations_.empty()) {
+    fprintf(stderr, "Cannot Init, no representations or already "
+            "initialized.\n");
+    return false;
+  }
+  if (config_.timecode_scale == 0 ||
+      kNanosecondsPerSecond % config_.timecode_scale != 0) {
+    fprintf(stderr, "Unsupported timecode scale %llu.\n",
+            static_cast<unsigned long long>(config_.timecode_scale));
+    return false;
+  }
+
+  for (size_t i = 0; i < representation_configs_.size(); ++i) {
+    const WebMLiveDashRepresentationConfig& rep = representation_configs_[i];
+    std::unique_ptr<RepresentationSink> sink(
+        new (std::nothrow) RepresentationSink(  // NOLINT
+            this, static_cast<int>(i),
+            JoinPath(config_.directory, rep.init_name),
+            JoinPath(config_.directory, rep.media_template),
+            config_.start_number));
+    if (!sink.get()) {
+      fprintf(stderr, "Cannot construct RepresentationSink.\n");
+      representations_.clear();
+      return false;
+    }
+    if (!sink->Init()) {
+      representations_.clear();
+      return false;
+    }
+    // A segment is listed once the next one starts, so the files keep one
+    // more segment than the MPD lists.
+    if (config_.max_segments > 0)
+      sink->set_max_segments(config_.max_segments + 1);
+    representations_.push_back(std::move(sink));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  segments_.assign(representations_.size(), std::deque<Segment>());
+  availability_start_time_ = FormatUtcTime(
+      config_.availability_start_time > 0 ?
+          static_cast<time_t>(config_.availability_start_time) :
+          time(NULL));
+  finished_ = false;
+  return WriteManifest();
+}
+
+WebMChunkSink* WebMLiveDashPackager::sink(int representation) const {
+  if (representation < 0 ||
+      representation >= static_cast<int>(representations_.size())) {
+    return NULL;
+  }
+  return representations_[representation].get();
+}
+
+bool WebMLiveDashPackager::Finish(int64 end_time) {
+  bool finished = true;
+  for (size_t i = 0; i < representations_.size(); ++i) {
+    if (!representations_[i]->Finish(end_time))
+      finished = false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  finished_ = true;
+  return WriteManifest() && finished;
+}
+
+std::string WebMLiveDashPackager::ManifestXml() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return BuildManifest();
+}
+
+std::string WebMLiveDashPackager::mpd_path() const {
+  return JoinPath(config_.directory, config_.mpd_name);
+}
+
+int64 WebMLiveDashPackager::manifest_updates() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return manifest_updates_;
+}
+
+bool WebMLiveDashPackager::AddSegment(int representation, int64 number,
+                                      int64 start, int64 duration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::deque<Segment>& segments = segments_[representation];
+  const Segment segment = { number, start, duration };
+  segments.push_back(segment);
+  while (config_.max_segments > 0 &&
+         segments.size() > static_cast<size_t>(config_.max_segments)) {
+    segments.pop_front();
+  }
+  return WriteManifest();
+}
+
+std::string WebMLiveDashPackager::BuildManifest() const {
+  const uint64 timescale = kNanosecondsPerSecond / config_.timecode_scale;
+  char buffer[512];
+  XmlWriter writer;
+  writer.Write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  writer.Write("<MPD\n");
+  writer.Write("  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
+  writer.Write("  xmlns=\"urn:mpeg:DASH:schema:MPD:2011\"\n");
+  writer.Write("  xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011\"\n");
+  writer.Write("  type=\"dynamic\"\n");
+  writer.Write("  availabilityStartTime=\"" + availability_start_time_ +
+               "\"\n");
+  writer.Write("  publishTime=\"" + FormatUtcTime(time(NULL)) + "\"\n");
+
+  // The presentation ends with the latest segment, and the time shift
+  // buffer spans the shortest window of the Representations.
+  int64 end_time = 0;
+  int64 window = -1;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    if (segments_[i].empty())
+      continue;
+    const Segment& last = segments_[i].back();
+    end_time = std::max(end_time, last.start + last.duration);
+    const int64 span = last.start + last.duration - segments_[i].front().start;
+    window = window < 0 ? span : std::min(window, span);
+  }
+  if (finished_) {
+    snprintf(buffer, sizeof(buffer), "  mediaPresentationDuration=\"PT%gS\"\n",
+             static_cast<double>(end_time) / timescale);
+    writer.Write(buffer);
+  } else {
+    snprintf(buffer, sizeof(buffer), "  minimumUpdatePeriod=\"PT%gS\"\n",
+             config_.minimum_update_period);
+    writer.Write(buffer);
+  }
+  if (config_.max_segments > 0 && window > 0) {
+    snprintf(buffer, sizeof(buffer), "  timeShiftBufferDepth=\"PT%gS\"\n",
+             static_cast<double>(window) / timescale);
+    writer.Write(buffer);
+  }
+  snprintf(buffer, sizeof(buffer), "  minBufferTime=\"PT%gS\"\n",
+           config_.min_buffer_time);
+  writer.Write(buffer);
+  writer.Write("  profiles=\"");
+  writer.Write(kLiveProfile);
+  writer.Write("\">\n");
+
+  writer.Adjust(kIncreaseIndent);
+  writer.StartElement("Period");
+  writer.Attribute("id", "0");
+  writer.Attribute("start", "PT0S");
+  writer.EndStartTag();
+
+  // AdaptationSets in the order of their first Representation.
+  std::vector<std::string> set_ids;
+  for (size_t i = 0; i < representation_configs_.size(); ++i) {
+    const std::string& id = representation_configs_[i].adaptation_set_id;
+    if (std::find(set_ids.begin(), set_ids.end(), id) == set_ids.end())
+      set_ids.push_back(id);
+  }
+  writer.Adjust(kIncreaseIndent);
+  for (size_t set = 0; set < set_ids.size(); ++set) {
+    writer.StartElement("AdaptationSet");
+    writer.Attribute("id", set_ids[set]);
+    writer.Attribute("segmentAlignment", "true");
+    writer.Attribute("startWithSAP", 1);
+    writer.EndStartTag();
+
+    writer.Adjust(kIncreaseIndent);
+    for (size_t i = 0; i < representation_configs_.size(); ++i) {
+      const WebMLiveDashRepresentationConfig& rep =
+          representation_configs_[i];
+      if (rep.adaptation_set_id != set_ids[set])
+        continue;
+      writer.StartElement("Representation");
+      writer.Attribute("id", rep.id);
+      writer.Attribute("mimeType", rep.mime_type);
+      if (!rep.codecs.empty())
+        writer.Attribute("codecs", rep.codecs);
+      if (rep.bandwidth > 0)
+        writer.Attribute("bandwidth", rep.bandwidth);
+      if (rep.width > 0)
+        writer.Attribute("width", rep.width);
+      if (rep.height > 0)
+        writer.Attribute("height", rep.height);
+      if (rep.audio_sampling_rate > 0)
+        writer.Attribute("audioSamplingRate", rep.audio_sampling_rate);
+      writer.EndStartTag();
+
+      const std::deque<Segment>& segments = segments_[i];
+      writer.Adjust(kIncreaseIndent);
+      writer.StartElement("SegmentTemplate");
+      writer.Attribute("timescale", static_cast<int64>(timescale));
+      writer.Attribute("initialization", rep.init_name);
+      writer.Attribute("media", rep.media_template);
+      writer.Attribute("startNumber", segments.empty() ?
+                                      config_.start_number :
+                                      segments.front().number);
+      writer.EndStartTag();
+
+      writer.Adjust(kIncreaseIndent);
+      writer.StartElement("SegmentTimeline");
+      writer.EndStartTag();
+      // Contiguous segments of the same duration share one S element.
+      writer.Adjust(kIncreaseIndent);
+      for (size_t s = 0; s < segments.size();) {
+        size_t repeat = 0;
+        while (s + repeat + 1 < segments.size() &&
+               segments[s + repeat + 1].duration == segments[s].duration &&
+               segments[s + repeat + 1].start ==
+                   segments[s + repeat].start + segments[s].duration) {
+          ++repeat;
+        }
+        writer.StartElement("S");
+        writer.Attribute("t", segments[s].start);
+        writer.Attribute("d", segments[s].duration);
+        if (repeat > 0)
+          writer.Attribute("r", static_cast<int64>(repeat));
+        writer.EndEmptyElement();
+        s += repeat + 1;
+      }
+      writer.Adjust(kDecreaseIndent);
+      writer.EndElement("SegmentTimeline");
+      writer.Adjust(kDecreaseIndent);
+      writer.EndElement("SegmentTemplate");
+      writer.Adjust(kDecreaseIndent);
+      writer.EndElement("Representation");
+    }
+    writer.Adjust(kDecreaseIndent);
+    writer.EndElement("AdaptationSet");
+  }
+  writer.Adjust(kDecreaseIndent);
+  writer.EndElement("Period");
+  writer.Adjust(kDecreaseIndent);
+  writer.Write("</MPD>\n");
+
+  std::string mpd;
+  writer.Release(&mpd);
+  return mpd;
+}
+
+bool WebMLiveDashPackager::WriteManifest() {
+  const std::string mpd = BuildManifest();
+  if (!WriteFileAtomically(mpd_path(), mpd.data(), mpd.size()))
+    return false;
+  ++manifest_updates_;
+  return true;
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,189 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_LIVE_DASH_PACKAGER_H_
+#define SHARED_WEBM_LIVE_DASH_PACKAGER_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "webm_chunk_sink.h"
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Settings of one live DASH Representation.
+struct WebMLiveDashRepresentationConfig {
+  WebMLiveDashRepresentationConfig()
+      : adaptation_set_id("0"),
+        mime_type("video/webm"),
+        bandwidth(0),
+        width(0),
+        height(0),
+        audio_sampling_rate(0) {
+  }
+
+  std::string id;
+
+  // Representations with the same |adaptation_set_id| are listed in one
+  // AdaptationSet, in the order they were added.
+  std::string adaptation_set_id;
+
+  std::string mime_type;
+
+  // RFC 6381 codecs of the stream, for instance "vp9,opus".
+  std::string codecs;
+
+  // Attributes written when greater than 0.
+  int64 bandwidth;
+  int width;
+  int height;
+  int audio_sampling_rate;
+
+  // Names of the initialization segment and the media segments, relative
+  // to |WebMLiveDashConfig::directory|. |media_template| must hold a
+  // "$Number$" or "$Number%0<width>d$" identifier.
+  std::string init_name;
+  std::string media_template;
+};
+
+// Settings of a |WebMLiveDashPackager|.
+struct WebMLiveDashConfig {
+  WebMLiveDashConfig()
+      : mpd_name("manifest.mpd"),
+        timecode_scale(1000000),
+        start_number(1),
+        max_segments(0),
+        min_buffer_time(2.0),
+        minimum_update_period(2.0),
+        availability_start_time(0) {
+  }
+
+  // Directory receiving the MPD and the segments. Empty for the current
+  // directory.
+  std::string directory;
+  std::string mpd_name;
+
+  // TimecodeScale of the muxed streams, in nanoseconds. 1000000000 must be
+  // a multiple of it. The SegmentTemplate timescale is in the same units as
+  // the Cluster timecodes.
+  uint64 timecode_scale;
+
+  // Number of the first segment.
+  int64 start_number;
+
+  // Segments kept on disk and in the MPD for each Representation. 0 keeps
+  // every segment.
+  int max_segments;
+
+  // MPD attributes, in seconds.
+  double min_buffer_time;
+  double minimum_update_period;
+
+  // availabilityStartTime in seconds since the epoch. 0 uses the time of
+  // |Init()|.
+  int64 availability_start_time;
+};
+
+// Live DASH packager writing the chunks of |WebMLiveMuxer|s to a directory
+// that can be served by any HTTP server: an initialization segment and
+// numbered media segments per Representation, one segment per Cluster, and
+// a type="dynamic" MPD using SegmentTemplate and SegmentTimeline.
+//
+// Notes:
+// - Chunks of Representation |i| are written to |sink(i)|, for instance
+//   with |WebMLiveMuxer::WriteChunk(packager.sink(i))|. Partial chunks of low
+//   latency muxers are appended to the open segment.
+//
+// - A segment is added to the MPD when the next Cluster starts, since its
+//   duration runs to the next Cluster timecode. Each update rewrites the MPD
+//   to a temporary file renamed over the previous MPD, so clients never read
+//   a partial MPD. Runs of segments with the same duration are written as
+//   one S element.
+//
+// - The sinks of different Representations may be called from different
+//   threads. Each sink must only be called from one thread at a time.
+class WebMLiveDashPackager {
+ public:
+  // DASH live profile.
+  static const char kLiveProfile[];
+
+  explicit WebMLiveDashPackager(const WebMLiveDashConfig& config);
+  ~WebMLiveDashPackager();
+
+  // Adds a Representation. Must be called before |Init()|. Returns the index
+  // of the Representation, or -1 on error.
+  int AddRepresentation(const WebMLiveDashRepresentationConfig& config);
+
+  // Checks the configuration and writes the first MPD. Returns true when
+  // successful.
+  bool Init();
+
+  // Returns the sink receiving the chunks of Representation
+  // |representation|, or NULL if it does not exist or |Init()| was not
+  // called.
+  WebMChunkSink* sink(int representation) const;
+
+  // Closes the open segments and writes the final MPD, which lists every
+  // segment in the window and has a mediaPresentationDuration. The last
+  // segment of each Representation ends at |end_time|, in timecode scale
+  // units, or lasts as long as the previous segment when |end_time| is
+  // before its start. Returns true when successful.
+  bool Finish(int64 end_time);
+
+  // Returns the current MPD.
+  std::string ManifestXml() const;
+
+  // Accessors.
+  std::string mpd_path() const;
+  int num_representations() const {
+    return static_cast<int>(representations_.size());
+  }
+  int64 manifest_updates() const;
+
+ private:
+  class RepresentationSink;
+
+  // Segment listed in the SegmentTimeline, in timecode scale units.
+  struct Segment {
+    int64 number;
+    int64 start;
+    int64 duration;
+  };
+
+  // Lists segment |number| of Representation |representation| and writes
+  // the MPD. Called by the sinks.
+  bool AddSegment(int representation, int64 number, int64 start,
+                  int64 duration);
+
+  // Returns the MPD. |mutex_| must be held.
+  std::string BuildManifest() const;
+
+  // Writes the MPD. |mutex_| must be held.
+  bool WriteManifest();
+
+  const WebMLiveDashConfig config_;
+  std::vector<WebMLiveDashRepresentationConfig> representation_configs_;
+  std::vector<std::unique_ptr<RepresentationSink> > representations_;
+
+  // Guards the members below.
+  mutable std::mutex mutex_;
+  std::vector<std::deque<Segment> > segments_;
+  std::string availability_start_time_;
+  bool finished_;
+  int64 manifest_updates_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMLiveDashPackager);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_LIVE_DASH_PACKAGER_H_
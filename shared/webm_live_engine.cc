@@ -0,0 +1,481 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_live_engine.h"
+
+#include <cstdio>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "webm_bounded_queue.h"
+
+namespace webm_tools {
+
+namespace {
+
+// Adds the audio track described by |config| to |muxer|. Returns true on
+// success.
+bool AddAudioTrack(const WebMLiveChannelConfig& config,
+                   WebMLiveMuxer* muxer) {
+  const uint8* const private_data = config.audio_private_data.empty() ?
+      NULL : &config.audio_private_data[0];
+  const size_t private_size = config.audio_private_data.size();
+  const int status = config.audio_codec_id.empty() ?
+      muxer->AddAudioTrack(config.audio_sample_rate, config.audio_channels,
+                           private_data, private_size) :
+      muxer->AddAudioTrack(config.audio_sample_rate, config.audio_channels,
+                           private_data, private_size,
+                           config.audio_codec_id);
+  return status > 0;
+}
+
+}  // namespace
+
+// Muxers of one channel. Only the worker thread of the channel uses the
+// muxers once the channel has been added.
+struct WebMLiveEngine::Channel {
+  Channel()
+      : id(0),
+        worker(0),
+        has_audio(false),
+        separate_audio(false),
+        closed(false),
+        finalize_queued(false),
+        queued_tasks(0) {
+  }
+
+  int id;
+
+  // Index of the worker muxing the channel.
+  int worker;
+
+  bool has_audio;
+  bool separate_audio;
+  std::vector<std::unique_ptr<WebMLiveMuxer> > renditions;
+
+  // Audio only muxer. NULL unless |separate_audio| is true.
+  std::unique_ptr<WebMLiveMuxer> audio;
+
+  // Set by the worker once the channel is finalized or has failed.
+  std::atomic<bool> closed;
+
+  // Set when the finalize task of the channel has been queued.
+  std::atomic<bool> finalize_queued;
+
+  // Number of tasks of the channel queued or running. Incremented before a
+  // task is pushed, and decremented once the worker is done with it.
+  std::atomic<int> queued_tasks;
+};
+
+// Channel slot. |users| counts the threads using the channel they loaded from
+// the slot, so a finalized channel is only freed once no thread can still
+// reach it.
+struct WebMLiveEngine::ChannelSlot {
+  ChannelSlot() : channel(NULL), users(0) {}
+
+  std::atomic<Channel*> channel;
+  std::atomic<int> users;
+};
+
+// Frame or finalize request queued for the worker of |channel|.
+struct WebMLiveEngine::Task {
+  Task()
+      : channel(NULL),
+        stream(0),
+        timestamp_ns(0),
+        is_key(false),
+        finalize(false) {
+  }
+
+  Channel* channel;
+
+  // Rendition index or |kAudioStream|.
+  int stream;
+
+  // Frame data, in a buffer of |frame_pool_|.
+  WebMFramePool::Buffer frame;
+  uint64 timestamp_ns;
+  bool is_key;
+
+  // Finalize the channel instead of muxing a frame.
+  bool finalize;
+};
+
+struct WebMLiveEngine::Worker {
+  explicit Worker(size_t capacity) : queue(capacity) {}
+
+  BoundedQueue<Task> queue;
+  std::thread thread;
+
+  // Chunks passed to the callback, reused for every task of the worker.
+  std::vector<WebMLiveEngineChunk> chunks;
+};
+
+WebMLiveEngine::WebMLiveEngine(int num_threads, int max_channels,
+                               size_t queue_capacity)
+    : num_threads_(num_threads),
+      max_channels_(max_channels),
+      queue_capacity_(queue_capacity),
+      running_(false),
+      failed_(false),
+      frame_pool_(queue_capacity * (num_threads > 0 ? num_threads : 1)) {
+}
+
+WebMLiveEngine::~WebMLiveEngine() {
+  if (running_)
+    Finalize();
+}
+
+int WebMLiveEngine::Init(const ChunkCallback& callback) {
+  if (running_ || !workers_.empty() || !callback || num_threads_ < 1 ||
+      max_channels_ < 1) {
+    fprintf(stderr, "Cannot Init WebMLiveEngine, invalid arg.\n");
+    return kInvalidArg;
+  }
+  callback_ = callback;
+
+  if (!frame_pool_.Init()) {
+    fprintf(stderr, "Cannot Init frame pool.\n");
+    return kNoMemory;
+  }
+  channel_slots_.reset(
+      new (std::nothrow) ChannelSlot[max_channels_]);  // NOLINT
+  if (!channel_slots_.get()) {
+    fprintf(stderr, "Cannot construct channel slots.\n");
+    return kNoMemory;
+  }
+  // Slots are taken from the back, lowest index first.
+  channels_.reserve(max_channels_);
+  free_slots_.reserve(max_channels_);
+  for (int i = max_channels_ - 1; i >= 0; --i)
+    free_slots_.push_back(i);
+
+  // All the workers are constructed before any thread starts, so a failure
+  // leaves no thread running.
+  for (int i = 0; i < num_threads_; ++i) {
+    std::unique_ptr<Worker> worker(
+        new (std::nothrow) Worker(queue_capacity_));  // NOLINT
+    if (!worker.get()) {
+      fprintf(stderr, "Cannot construct worker.\n");
+      workers_.clear();
+      return kNoMemory;
+    }
+    workers_.push_back(std::move(worker));
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    Worker* const worker = workers_[i].get();
+    worker->thread = std::thread([this, worker]() {
+      Task task;
+      while (worker->queue.Pop(&task)) {
+        RunTask(task, worker);
+        frame_pool_.Release(&task.frame);
+        // The channel may be reclaimed from now on.
+        task.channel->queued_tasks.fetch_sub(1, std::memory_order_release);
+      }
+    });
+  }
+
+  running_ = true;
+  return kSuccess;
+}
+
+int WebMLiveEngine::AddChannel(const WebMLiveChannelConfig& config) {
+  if (!running_)
+    return kNotRunning;
+  if (config.renditions.empty() && !config.has_audio) {
+    fprintf(stderr, "Cannot add channel without streams.\n");
+    return kInvalidArg;
+  }
+
+  std::unique_ptr<Channel> channel(new (std::nothrow) Channel());  // NOLINT
+  if (!channel.get()) {
+    fprintf(stderr, "Cannot construct channel.\n");
+    return kNoMemory;
+  }
+  channel->has_audio = config.has_audio;
+  // A channel without renditions can only carry audio on its own.
+  channel->separate_audio =
+      config.has_audio && (config.separate_audio || config.renditions.empty());
+
+  for (size_t i = 0; i < config.renditions.size(); ++i) {
+    const WebMLiveRenditionConfig& rendition = config.renditions[i];
+    std::unique_ptr<WebMLiveMuxer> muxer(
+        new (std::nothrow) WebMLiveMuxer());  // NOLINT
+    if (!muxer.get()) {
+      fprintf(stderr, "Cannot construct rendition muxer.\n");
+      return kNoMemory;
+    }
+    if (muxer->Init() != WebMLiveMuxer::kSuccess) {
+      fprintf(stderr, "Cannot Init rendition muxer.\n");
+      return kMuxerError;
+    }
+    muxer->set_partial_chunk_frames(config.partial_chunk_frames);
+    muxer->set_partial_chunk_bytes(config.partial_chunk_bytes);
+
+    const int track_num = rendition.codec_id.empty() ?
+        muxer->AddVideoTrack(rendition.width, rendition.height) :
+        muxer->AddVideoTrack(rendition.width, rendition.height,
+                             rendition.codec_id);
+    if (track_num <= 0) {
+      fprintf(stderr, "Cannot add video track to rendition %zu.\n", i);
+      return kMuxerError;
+    }
+
+    if (config.has_audio && !channel->separate_audio &&
+        !AddAudioTrack(config, muxer.get())) {
+      fprintf(stderr, "Cannot add audio track to rendition %zu.\n", i);
+      return kMuxerError;
+    }
+    channel->renditions.push_back(std::move(muxer));
+  }
+
+  if (channel->separate_audio) {
+    channel->audio.reset(new (std::nothrow) WebMLiveMuxer());  // NOLINT
+    if (!channel->audio.get()) {
+      fprintf(stderr, "Cannot construct audio muxer.\n");
+      return kNoMemory;
+    }
+    if (channel->audio->Init() != WebMLiveMuxer::kSuccess ||
+        !AddAudioTrack(config, channel->audio.get())) {
+      fprintf(stderr, "Cannot Init audio muxer.\n");
+      return kMuxerError;
+    }
+    channel->audio->set_partial_chunk_frames(config.partial_chunk_frames);
+    channel->audio->set_partial_chunk_bytes(config.partial_chunk_bytes);
+  }
+
+  std::lock_guard<std::mutex> lock(channels_mutex_);
+  ReclaimChannels();
+  if (free_slots_.empty()) {
+    fprintf(stderr, "Cannot add channel, all channel slots are in use.\n");
+    return kTooManyChannels;
+  }
+  const int channel_id = free_slots_.back();
+  free_slots_.pop_back();
+  channel->id = channel_id;
+  channel->worker = channel_id % num_threads_;
+  channel_slots_[channel_id].channel.store(channel.get());
+  channels_.push_back(std::move(channel));
+  return channel_id;
+}
+
+int WebMLiveEngine::WriteVideoFrame(int channel_id, int rendition,
+                                    const uint8* data, size_t size,
+                                    uint64 timestamp_ns, bool is_key) {
+  if (rendition < 0)
+    return kInvalidArg;
+  return QueueFrame(channel_id, rendition, data, size, timestamp_ns, is_key);
+}
+
+int WebMLiveEngine::WriteAudioFrame(int channel_id,
+                                    const uint8* data, size_t size,
+                                    uint64 timestamp_ns, bool is_key) {
+  return QueueFrame(channel_id, kAudioStream, data, size, timestamp_ns,
+                    is_key);
+}
+
+int WebMLiveEngine::FinalizeChannel(int channel_id) {
+  if (!running_)
+    return kNotRunning;
+
+  int status = kSuccess;
+  Channel* const channel = AcquireChannel(channel_id);
+  if (!channel) {
+    status = kInvalidArg;
+  } else if (channel->finalize_queued.exchange(true)) {
+    status = kChannelClosed;
+  } else {
+    Task task;
+    task.channel = channel;
+    task.finalize = true;
+    ++channel->queued_tasks;
+    if (!workers_[channel->worker]->queue.Push(std::move(task))) {
+      --channel->queued_tasks;
+      status = kNotRunning;
+    }
+    // Later lookups find no channel, and the channel is reclaimed once its
+    // queued tasks have run.
+    channel_slots_[channel_id].channel.store(NULL);
+  }
+  ReleaseChannel(channel_id);
+  return status;
+}
+
+int WebMLiveEngine::Finalize() {
+  if (!running_)
+    return kNotRunning;
+
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    for (size_t i = 0; i < channels_.size(); ++i) {
+      Channel* const channel = channels_[i].get();
+      if (channel->finalize_queued.exchange(true))
+        continue;
+      Task task;
+      task.channel = channel;
+      task.finalize = true;
+      ++channel->queued_tasks;
+      if (!workers_[channel->worker]->queue.Push(std::move(task)))
+        --channel->queued_tasks;
+    }
+  }
+  running_ = false;
+
+  // Workers mux the queued tasks before |Pop()| fails on the closed queues.
+  for (size_t i = 0; i < workers_.size(); ++i)
+    workers_[i]->queue.Close();
+  for (size_t i = 0; i < workers_.size(); ++i)
+    workers_[i]->thread.join();
+
+  return failed_ ? kMuxerError : kSuccess;
+}
+
+WebMLiveEngine::Channel* WebMLiveEngine::AcquireChannel(int channel_id) {
+  if (channel_id < 0 || channel_id >= max_channels_ || !channel_slots_.get())
+    return NULL;
+  ChannelSlot& slot = channel_slots_[channel_id];
+  // The user is counted before the channel is loaded, so |ReclaimChannels()|
+  // either sees the user or the channel was cleared before the load.
+  ++slot.users;
+  return slot.channel.load();
+}
+
+void WebMLiveEngine::ReleaseChannel(int channel_id) {
+  if (channel_id < 0 || channel_id >= max_channels_ || !channel_slots_.get())
+    return;
+  --channel_slots_[channel_id].users;
+}
+
+void WebMLiveEngine::ReclaimChannels() {
+  size_t i = 0;
+  while (i < channels_.size()) {
+    Channel* const channel = channels_[i].get();
+    const ChannelSlot& slot = channel_slots_[channel->id];
+    // A thread still using the channel may queue one more task, so the
+    // tasks are counted after the users.
+    if (slot.channel.load() == channel || slot.users.load() != 0 ||
+        channel->queued_tasks.load(std::memory_order_acquire) != 0) {
+      ++i;
+      continue;
+    }
+    free_slots_.push_back(channel->id);
+    channels_[i] = std::move(channels_.back());
+    channels_.pop_back();
+  }
+}
+
+int WebMLiveEngine::QueueFrame(int channel_id, int stream,
+                               const uint8* data, size_t size,
+                               uint64 timestamp_ns, bool is_key) {
+  if (!running_)
+    return kNotRunning;
+  if (!data || size == 0)
+    return kInvalidArg;
+
+  int status = kSuccess;
+  Channel* const channel = AcquireChannel(channel_id);
+  if (!channel) {
+    status = kInvalidArg;
+  } else if (stream == kAudioStream ? !channel->has_audio :
+             stream >= static_cast<int>(channel->renditions.size())) {
+    status = kInvalidArg;
+  } else if (channel->closed || channel->finalize_queued) {
+    status = kChannelClosed;
+  } else {
+    Task task;
+    task.channel = channel;
+    task.stream = stream;
+    frame_pool_.Copy(data, size, &task.frame);
+    task.timestamp_ns = timestamp_ns;
+    task.is_key = is_key;
+    ++channel->queued_tasks;
+    if (!workers_[channel->worker]->queue.Push(std::move(task))) {
+      --channel->queued_tasks;
+      frame_pool_.Release(&task.frame);
+      status = kNotRunning;
+    }
+  }
+  ReleaseChannel(channel_id);
+  return status;
+}
+
+void WebMLiveEngine::RunTask(const Task& task, Worker* worker) {
+  Channel* const channel = task.channel;
+  if (channel->closed)
+    return;
+
+  bool ok = true;
+  if (task.finalize) {
+    for (size_t i = 0; i < channel->renditions.size(); ++i) {
+      if (channel->renditions[i]->Finalize() != WebMLiveMuxer::kSuccess)
+        ok = false;
+    }
+    if (channel->audio.get() &&
+        channel->audio->Finalize() != WebMLiveMuxer::kSuccess) {
+      ok = false;
+    }
+  } else {
+    const uint8* const data = &task.frame[0];
+    const size_t size = task.frame.size();
+    if (task.stream != kAudioStream) {
+      ok = channel->renditions[task.stream]->WriteVideoFrame(
+          data, size, task.timestamp_ns, task.is_key) ==
+          WebMLiveMuxer::kSuccess;
+    } else if (channel->separate_audio) {
+      ok = channel->audio->WriteAudioFrame(
+          data, size, task.timestamp_ns, task.is_key) ==
+          WebMLiveMuxer::kSuccess;
+    } else {
+      for (size_t i = 0; ok && i < channel->renditions.size(); ++i) {
+        ok = channel->renditions[i]->WriteAudioFrame(
+            data, size, task.timestamp_ns, task.is_key) ==
+            WebMLiveMuxer::kSuccess;
+      }
+    }
+  }
+
+  if (ok)
+    ok = DeliverChunks(channel, &worker->chunks);
+
+  if (!ok) {
+    fprintf(stderr, "Channel %d failed, closing it.\n", channel->id);
+    failed_ = true;
+    channel->closed = true;
+  } else if (task.finalize) {
+    channel->closed = true;
+  }
+}
+
+bool WebMLiveEngine::DeliverChunks(Channel* channel,
+                                   std::vector<WebMLiveEngineChunk>* chunks) {
+  bool ok = true;
+  int32 chunk_length = 0;
+  const int num_streams = static_cast<int>(channel->renditions.size());
+  for (int stream = 0; ok && stream <= num_streams; ++stream) {
+    // The audio only muxer follows the renditions.
+    WebMLiveMuxer* const muxer = stream < num_streams ?
+        channel->renditions[stream].get() : channel->audio.get();
+    while (ok && muxer && muxer->ChunkReady(&chunk_length)) {
+      chunks->push_back(WebMLiveEngineChunk());
+      WebMLiveEngineChunk& chunk = chunks->back();
+      chunk.stream = stream < num_streams ? stream : kAudioStream;
+      chunk.flags = muxer->chunk_flags();
+      ok = muxer->ReadChunk(&chunk.data) == WebMLiveMuxer::kSuccess;
+    }
+  }
+
+  if (ok && !chunks->empty())
+    callback_(channel->id, *chunks);
+  // Drop the chunk references and keep the storage for the next task.
+  chunks->clear();
+  return ok;
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,229 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_LIVE_ENGINE_H_
+#define SHARED_WEBM_LIVE_ENGINE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "webm_frame_pool.h"
+#include "webm_live_muxer.h"
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Describes one video rendition of a channel.
+struct WebMLiveRenditionConfig {
+  WebMLiveRenditionConfig() : width(0), height(0) {}
+
+  int width;
+  int height;
+
+  // Matroska codec ID of the video track. Defaults to the libwebm default
+  // when empty.
+  std::string codec_id;
+};
+
+// Describes the renditions and audio track of a channel.
+struct WebMLiveChannelConfig {
+  WebMLiveChannelConfig()
+      : has_audio(false),
+        audio_sample_rate(0),
+        audio_channels(0),
+        separate_audio(false),
+        partial_chunk_frames(0),
+        partial_chunk_bytes(0) {
+  }
+
+  std::vector<WebMLiveRenditionConfig> renditions;
+
+  // Audio track settings. Only used if |has_audio| is true.
+  bool has_audio;
+  int audio_sample_rate;
+  int audio_channels;
+  std::vector<uint8> audio_private_data;
+  std::string audio_codec_id;
+
+  // If true audio is muxed once into an audio only stream shared by all the
+  // renditions. Otherwise audio is muxed into every rendition.
+  bool separate_audio;
+
+  // Low latency limits applied to every muxer of the channel. See
+  // |WebMLiveMuxer::set_partial_chunk_frames()| and
+  // |WebMLiveMuxer::set_partial_chunk_bytes()|.
+  int partial_chunk_frames;
+  int64 partial_chunk_bytes;
+};
+
+// Chunk produced by one stream of a channel.
+struct WebMLiveEngineChunk {
+  WebMLiveEngineChunk() : stream(0), flags(0) {}
+
+  // Index of the rendition, or |WebMLiveEngine::kAudioStream| for the audio
+  // only stream.
+  int stream;
+
+  // |WebMLiveMuxer::ChunkFlags| of the chunk.
+  int flags;
+  WebMLiveMuxer::SharedChunk data;
+};
+
+// Live muxing engine driving the |WebMLiveMuxer|s of many channels, each with
+// several video renditions and one audio track, from a pool of threads.
+//
+// Notes:
+// - Every channel is bound to one worker thread, so the muxers of a channel
+//   need no locking and frames of a channel are muxed in the order they were
+//   written.
+//
+// - Frames are copied once when written, into buffers of a |WebMFramePool|
+//   recycled once the frame is muxed. Audio frames are muxed into all the
+//   renditions of their channel from the same copy.
+//
+// - Chunks are delivered through the |ChunkCallback| passed to |Init()|.
+//   The callback runs on the worker threads and receives all the chunks of a
+//   channel that became ready after one frame in one call.
+//
+// - Writes block while the queue of the channel's worker is full.
+//
+// - The muxers of a finalized channel are freed once its queued tasks have
+//   run, and its channel slot and ID are reused by a later |AddChannel()|.
+class WebMLiveEngine {
+ public:
+  // Status codes returned by class methods.
+  enum {
+    // |Init()| has not been called, or |Finalize()| has been called.
+    kNotRunning = -6,
+
+    // The channel has been finalized, or failed to mux an earlier frame.
+    kChannelClosed = -5,
+
+    // Every channel slot is in use.
+    kTooManyChannels = -4,
+
+    // Something failed while interacting with |WebMLiveMuxer|.
+    kMuxerError = -3,
+
+    kNoMemory = -2,
+    kInvalidArg = -1,
+    kSuccess = 0,
+  };
+
+  // Stream index of the audio only stream of a channel.
+  static const int kAudioStream = -1;
+
+  // Default number of frames queued for each worker thread.
+  static const size_t kDefaultQueueCapacity = 256;
+
+  // Called with the ready chunks of channel |channel_id|; the chunks of each
+  // stream are in write order. Runs on a worker thread, and must be thread
+  // safe for calls on different channels. |chunks| is reused by the worker
+  // and is only valid during the call.
+  typedef std::function<void(int channel_id,
+                             const std::vector<WebMLiveEngineChunk>& chunks)>
+      ChunkCallback;
+
+  // |num_threads| worker threads mux at most |max_channels| channels. Each
+  // worker queues up to |queue_capacity| frames.
+  WebMLiveEngine(int num_threads, int max_channels, size_t queue_capacity);
+  ~WebMLiveEngine();
+
+  // Starts the worker threads. Returns |kSuccess| when successful.
+  int Init(const ChunkCallback& callback);
+
+  // Creates the muxers of a channel described by |config|. Returns the
+  // channel ID, or a status code < 0 on error. Thread safe.
+  int AddChannel(const WebMLiveChannelConfig& config);
+
+  // Queues |data| for rendition |rendition| of channel |channel_id|. Returns
+  // |kSuccess| when the frame was queued. Thread safe.
+  int WriteVideoFrame(int channel_id, int rendition,
+                      const uint8* data, size_t size,
+                      uint64 timestamp_ns, bool is_key);
+
+  // Queues |data| for the audio track of channel |channel_id|. Returns
+  // |kSuccess| when the frame was queued. Thread safe.
+  int WriteAudioFrame(int channel_id, const uint8* data, size_t size,
+                      uint64 timestamp_ns, bool is_key);
+
+  // Finalizes the muxers of channel |channel_id| and delivers its last
+  // chunks. Later writes to the channel fail until |channel_id| is returned
+  // again by |AddChannel()|. Thread safe.
+  int FinalizeChannel(int channel_id);
+
+  // Finalizes the remaining channels, waits for the queued frames to be
+  // muxed and stops the worker threads. Returns |kSuccess| if no channel
+  // failed.
+  int Finalize();
+
+ private:
+  struct Channel;
+  struct ChannelSlot;
+  struct Task;
+  struct Worker;
+
+  // Returns the channel |channel_id|, or NULL if it does not exist. The
+  // channel is not freed before |ReleaseChannel()| is called with
+  // |channel_id|, which must be called whatever the result.
+  Channel* AcquireChannel(int channel_id);
+  void ReleaseChannel(int channel_id);
+
+  // Frees the finalized channels no thread uses anymore and returns their
+  // slots to |free_slots_|. |channels_mutex_| must be held.
+  void ReclaimChannels();
+
+  // Copies |data| and queues it for |stream| of |channel_id|.
+  int QueueFrame(int channel_id, int stream, const uint8* data, size_t size,
+                 uint64 timestamp_ns, bool is_key);
+
+  // Muxes |task| on |worker|, the worker thread of its channel.
+  void RunTask(const Task& task, Worker* worker);
+
+  // Reads the ready chunks of |channel| into |chunks| and passes them to
+  // |callback_|. Returns false on error.
+  bool DeliverChunks(Channel* channel,
+                     std::vector<WebMLiveEngineChunk>* chunks);
+
+  const int num_threads_;
+  const int max_channels_;
+  const size_t queue_capacity_;
+  ChunkCallback callback_;
+  std::atomic<bool> running_;
+
+  // Set if any channel failed.
+  std::atomic<bool> failed_;
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+
+  // Copies of the queued frames.
+  WebMFramePool frame_pool_;
+
+  // Channel slots. A slot is published once its channel is initialized, so
+  // writes look up channels without locking, and cleared when the channel is
+  // finalized.
+  std::unique_ptr<ChannelSlot[]> channel_slots_;
+
+  // Channels not reclaimed yet, including the finalized ones still in use,
+  // and the indexes of the slots without a channel. Guarded by
+  // |channels_mutex_|.
+  std::vector<std::unique_ptr<Channel> > channels_;
+  std::vector<int> free_slots_;
+  std::mutex channels_mutex_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMLiveEngine);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_LIVE_ENGINE_H_
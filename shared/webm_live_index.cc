@@ -0,0 +1,273 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_live_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "webm_file_util.h"
+
+namespace webm_tools {
+
+namespace {
+
+const char kBinaryMagic[] = "WLIX";
+const size_t kBinaryHeaderSize = 12;
+const size_t kBinaryEntrySize =
+    4 * 8 + 4 + WebMLiveIndexEntry::kNumTracks * 2 * 8;
+
+void PutUInt32(uint32 value, std::vector<uint8>* ptr_data) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    ptr_data->push_back(static_cast<uint8>(value >> shift));
+}
+
+void PutInt64(int64 value, std::vector<uint8>* ptr_data) {
+  const uint64 bits = static_cast<uint64>(value);
+  for (int shift = 56; shift >= 0; shift -= 8)
+    ptr_data->push_back(static_cast<uint8>(bits >> shift));
+}
+
+uint32 GetUInt32(const uint8* data) {
+  uint32 value = 0;
+  for (int i = 0; i < 4; ++i)
+    value = (value << 8) | data[i];
+  return value;
+}
+
+int64 GetInt64(const uint8* data) {
+  uint64 value = 0;
+  for (int i = 0; i < 8; ++i)
+    value = (value << 8) | data[i];
+  return static_cast<int64>(value);
+}
+
+bool StartsBefore(int64 time_ns, const WebMLiveIndexEntry& entry) {
+  return time_ns < entry.start_time_ns;
+}
+
+bool ChunkNumberLess(const WebMLiveIndexEntry& entry, int64 chunk_number) {
+  return entry.chunk_number < chunk_number;
+}
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMLiveIndexEntry
+//
+
+void WebMLiveIndexEntry::AddFrame(int track, int64 timestamp_ns,
+                                  bool is_key) {
+  if (track < 0 || track >= kNumTracks || timestamp_ns < 0)
+    return;
+  if (start_time_ns < 0 || timestamp_ns < start_time_ns)
+    start_time_ns = timestamp_ns;
+  if (is_key)
+    key_frame = true;
+
+  TrackTiming& timing = tracks[track];
+  if (timing.start_ns < 0) {
+    timing.start_ns = timestamp_ns;
+  } else if (timestamp_ns < timing.start_ns) {
+    timing.duration_ns += timing.start_ns - timestamp_ns;
+    timing.start_ns = timestamp_ns;
+  } else if (timestamp_ns - timing.start_ns > timing.duration_ns) {
+    timing.duration_ns = timestamp_ns - timing.start_ns;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WebMLiveIndex
+//
+
+WebMLiveIndex::WebMLiveIndex(size_t max_entries)
+    : max_entries_(max_entries) {
+}
+
+void WebMLiveIndex::Clear() {
+  entries_.clear();
+}
+
+bool WebMLiveIndex::AddEntry(const WebMLiveIndexEntry& entry) {
+  WebMLiveIndexEntry new_entry = entry;
+  if (!entries_.empty()) {
+    WebMLiveIndexEntry& last = entries_.back();
+    if (entry.chunk_number <= last.chunk_number ||
+        entry.offset < last.offset + last.size) {
+      fprintf(stderr, "Index entry does not follow the newest entry.\n");
+      return false;
+    }
+    if (new_entry.start_time_ns < last.start_time_ns)
+      new_entry.start_time_ns = last.start_time_ns;
+    for (int i = 0; i < WebMLiveIndexEntry::kNumTracks; ++i) {
+      WebMLiveIndexEntry::TrackTiming& timing = last.tracks[i];
+      const int64 next_start_ns = entry.tracks[i].start_ns;
+      if (timing.start_ns >= 0 && next_start_ns > timing.start_ns)
+        timing.duration_ns = next_start_ns - timing.start_ns;
+    }
+  }
+
+  entries_.push_back(new_entry);
+  while (max_entries_ > 0 && entries_.size() > max_entries_)
+    entries_.pop_front();
+  return true;
+}
+
+bool WebMLiveIndex::FindByTime(int64 time_ns, bool key_frame_only,
+                               WebMLiveIndexEntry* ptr_entry) const {
+  if (!ptr_entry)
+    return false;
+
+  std::deque<WebMLiveIndexEntry>::const_iterator it =
+      std::upper_bound(entries_.begin(), entries_.end(), time_ns,
+                       StartsBefore);
+  // Key frames start Clusters, so with partial chunks the walk back covers
+  // at most the chunks of one Cluster.
+  while (it != entries_.begin()) {
+    --it;
+    if (!key_frame_only || it->key_frame) {
+      *ptr_entry = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WebMLiveIndex::FindByChunkNumber(int64 chunk_number,
+                                      WebMLiveIndexEntry* ptr_entry) const {
+  if (!ptr_entry)
+    return false;
+
+  std::deque<WebMLiveIndexEntry>::const_iterator it =
+      std::lower_bound(entries_.begin(), entries_.end(), chunk_number,
+                       ChunkNumberLess);
+  if (it == entries_.end() || it->chunk_number != chunk_number)
+    return false;
+  *ptr_entry = *it;
+  return true;
+}
+
+void WebMLiveIndex::ToBinary(std::vector<uint8>* ptr_data) const {
+  if (!ptr_data)
+    return;
+
+  ptr_data->clear();
+  ptr_data->reserve(kBinaryHeaderSize + entries_.size() * kBinaryEntrySize);
+  ptr_data->insert(ptr_data->end(), kBinaryMagic, kBinaryMagic + 4);
+  PutUInt32(kBinaryVersion, ptr_data);
+  PutUInt32(static_cast<uint32>(entries_.size()), ptr_data);
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const WebMLiveIndexEntry& entry = entries_[i];
+    PutInt64(entry.chunk_number, ptr_data);
+    PutInt64(entry.offset, ptr_data);
+    PutInt64(entry.size, ptr_data);
+    PutInt64(entry.start_time_ns, ptr_data);
+    PutUInt32(entry.key_frame ? 1 : 0, ptr_data);
+    for (int track = 0; track < WebMLiveIndexEntry::kNumTracks; ++track) {
+      PutInt64(entry.tracks[track].start_ns, ptr_data);
+      PutInt64(entry.tracks[track].duration_ns, ptr_data);
+    }
+  }
+}
+
+bool WebMLiveIndex::ParseBinary(const uint8* data, size_t size) {
+  if (!data || size < kBinaryHeaderSize || memcmp(data, kBinaryMagic, 4)) {
+    fprintf(stderr, "Not a live index.\n");
+    return false;
+  }
+  if (GetUInt32(data + 4) != kBinaryVersion) {
+    fprintf(stderr, "Unsupported live index version %u.\n",
+            GetUInt32(data + 4));
+    return false;
+  }
+  const uint32 num_entries = GetUInt32(data + 8);
+  if ((size - kBinaryHeaderSize) / kBinaryEntrySize < num_entries) {
+    fprintf(stderr, "Truncated live index.\n");
+    return false;
+  }
+
+  // Lookups are binary searches, so unsorted entries are rejected.
+  std::deque<WebMLiveIndexEntry> entries;
+  const uint8* ptr = data + kBinaryHeaderSize;
+  for (uint32 i = 0; i < num_entries; ++i) {
+    WebMLiveIndexEntry entry;
+    entry.chunk_number = GetInt64(ptr);
+    entry.offset = GetInt64(ptr + 8);
+    entry.size = GetInt64(ptr + 16);
+    entry.start_time_ns = GetInt64(ptr + 24);
+    entry.key_frame = (GetUInt32(ptr + 32) & 1) != 0;
+    ptr += 36;
+    for (int track = 0; track < WebMLiveIndexEntry::kNumTracks; ++track) {
+      entry.tracks[track].start_ns = GetInt64(ptr);
+      entry.tracks[track].duration_ns = GetInt64(ptr + 8);
+      ptr += 16;
+    }
+    if (!entries.empty() &&
+        (entry.chunk_number <= entries.back().chunk_number ||
+         entry.start_time_ns < entries.back().start_time_ns)) {
+      fprintf(stderr, "Live index entries are not sorted.\n");
+      return false;
+    }
+    entries.push_back(entry);
+  }
+  entries_.swap(entries);
+  return true;
+}
+
+std::string WebMLiveIndex::ToJson() const {
+  static const char* const kTrackNames[WebMLiveIndexEntry::kNumTracks] = {
+    "video", "audio"
+  };
+
+  std::string json = "{\"entries\":[";
+  char buffer[256];
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const WebMLiveIndexEntry& entry = entries_[i];
+    snprintf(buffer, sizeof(buffer),
+             "%s{\"chunk\":%lld,\"offset\":%lld,\"size\":%lld,"
+             "\"start_ns\":%lld,\"key_frame\":%s",
+             i > 0 ? "," : "",
+             static_cast<long long>(entry.chunk_number),
+             static_cast<long long>(entry.offset),
+             static_cast<long long>(entry.size),
+             static_cast<long long>(entry.start_time_ns),
+             entry.key_frame ? "true" : "false");
+    json += buffer;
+    for (int track = 0; track < WebMLiveIndexEntry::kNumTracks; ++track) {
+      const WebMLiveIndexEntry::TrackTiming& timing = entry.tracks[track];
+      if (timing.start_ns < 0)
+        continue;
+      snprintf(buffer, sizeof(buffer),
+               ",\"%s\":{\"start_ns\":%lld,\"duration_ns\":%lld}",
+               kTrackNames[track], static_cast<long long>(timing.start_ns),
+               static_cast<long long>(timing.duration_ns));
+      json += buffer;
+    }
+    json += "}";
+  }
+  json += "]}\n";
+  return json;
+}
+
+bool WebMLiveIndex::WriteBinaryFile(const std::string& path) const {
+  std::vector<uint8> data;
+  ToBinary(&data);
+  return WriteFileAtomically(path, &data[0], data.size());
+}
+
+bool WebMLiveIndex::WriteJsonFile(const std::string& path) const {
+  const std::string json = ToJson();
+  return WriteFileAtomically(path, json.data(), json.size());
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,162 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_LIVE_INDEX_H_
+#define SHARED_WEBM_LIVE_INDEX_H_
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Index entry describing one chunk of a live stream.
+//
+// |offset| and |size| are exact, but the frames are credited to the chunk
+// open when they are passed to the muxer. libwebm holds audio frames back
+// until a video frame with a later timestamp arrives, so an audio frame passed
+// just before a Cluster starts is credited to the chunk before the one holding
+// its bytes. The audio |TrackTiming| of a chunk may then run up to one video
+// frame interval into the next chunk, which may hold audio from before its
+// |start_time_ns|. Lookups by time land on the earlier chunk, so playback
+// started from the entry found still gets every frame.
+struct WebMLiveIndexEntry {
+  // Tracks of a |WebMLiveMuxer| stream.
+  enum {
+    kVideo = 0,
+    kAudio = 1,
+    kNumTracks = 2,
+  };
+
+  // Timing of the frames of one track in the chunk. |start_ns| is -1 when the
+  // chunk has no frame of the track. |duration_ns| runs to the first frame of
+  // the track in the next indexed chunk, or to the last frame of the track in
+  // the chunk for the newest chunk.
+  struct TrackTiming {
+    TrackTiming() : start_ns(-1), duration_ns(0) {}
+    int64 start_ns;
+    int64 duration_ns;
+  };
+
+  WebMLiveIndexEntry()
+      : chunk_number(0),
+        offset(0),
+        size(0),
+        start_time_ns(-1),
+        key_frame(false) {
+  }
+
+  // Returns true when a frame was indexed in the chunk.
+  bool has_frames() const { return start_time_ns >= 0; }
+
+  // Adds a frame of |track| with |timestamp_ns| to the entry.
+  void AddFrame(int track, int64 timestamp_ns, bool is_key);
+
+  // Number of the chunk in the stream. The first chunk, holding the
+  // EBML header, Segment Info and Tracks, is chunk 0.
+  int64 chunk_number;
+
+  // Byte offset of the chunk from the start of the stream, and its size.
+  int64 offset;
+  int64 size;
+
+  // Timestamp of the earliest frame of the chunk, -1 for chunks without
+  // frames.
+  int64 start_time_ns;
+
+  // True when a key frame was written in the chunk.
+  bool key_frame;
+
+  TrackTiming tracks[kNumTracks];
+};
+
+// Rolling index of the chunks of a live stream, bounded to the most recent
+// |max_entries| chunks. Live WebM streams have no Cues, so the index lets
+// players and origins map times to chunks without parsing media.
+//
+// Notes:
+// - Entries are ordered by chunk number and start time. Lookups are binary
+//   searches.
+//
+// - |ToBinary()| and |ParseBinary()| use a compact big endian format:
+//     "WLIX", uint32 version, uint32 entry count,
+//     then per entry: int64 chunk number, int64 offset, int64 size,
+//     int64 start time, uint32 flags (1: key frame),
+//     int64 start and int64 duration of each track (video, audio).
+class WebMLiveIndex {
+ public:
+  enum {
+    kBinaryVersion = 1,
+  };
+
+  // |max_entries| of 0 keeps every entry.
+  explicit WebMLiveIndex(size_t max_entries);
+  ~WebMLiveIndex() {}
+
+  // Removes every entry.
+  void Clear();
+
+  // Appends |entry|, removing the oldest entry when the window is full.
+  // Extends the track durations of the previous entry to the starts of the
+  // tracks in |entry|. A start time before the start of the newest entry,
+  // which late audio frames can cause, is raised to it so the entries stay
+  // sorted. Returns false if |entry| does not follow the newest entry.
+  bool AddEntry(const WebMLiveIndexEntry& entry);
+
+  // Finds the newest entry starting at or before |time_ns|. When
+  // |key_frame_only| is true the entry must hold a key frame. Returns false
+  // when no entry matches.
+  bool FindByTime(int64 time_ns, bool key_frame_only,
+                  WebMLiveIndexEntry* ptr_entry) const;
+
+  // Finds the entry of chunk |chunk_number|. Returns false when the chunk is
+  // not in the index.
+  bool FindByChunkNumber(int64 chunk_number,
+                         WebMLiveIndexEntry* ptr_entry) const;
+
+  // Serializes the index to |ptr_data| in the binary format.
+  void ToBinary(std::vector<uint8>* ptr_data) const;
+
+  // Replaces the entries with the entries of the binary index |data|.
+  // Returns false, leaving the entries unchanged, when |data| is not a valid
+  // binary index or its entries are not sorted by chunk number and start
+  // time.
+  bool ParseBinary(const uint8* data, size_t size);
+
+  // Returns the index as a JSON object: {"entries": [...]}.
+  std::string ToJson() const;
+
+  // Writes the binary or JSON index to |path|. The index is written to a
+  // temporary file renamed to |path|, so readers never see a partial index.
+  // Returns true when successful.
+  bool WriteBinaryFile(const std::string& path) const;
+  bool WriteJsonFile(const std::string& path) const;
+
+  // Sets the window size. |max_entries| of 0 keeps every entry. Entries
+  // out of the window are removed by the next |AddEntry()|.
+  void set_max_entries(size_t max_entries) { max_entries_ = max_entries; }
+
+  // Accessors.
+  size_t max_entries() const { return max_entries_; }
+  size_t size() const { return entries_.size(); }
+  const WebMLiveIndexEntry& entry(size_t index) const {
+    return entries_[index];
+  }
+
+ private:
+  size_t max_entries_;
+  std::deque<WebMLiveIndexEntry> entries_;
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMLiveIndex);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_LIVE_INDEX_H_
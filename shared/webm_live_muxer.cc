@@ -10,6 +10,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include <new>
 #include <string>
 #include <vector>
@@ -17,6 +18,7 @@
 #include "mkvmuxer.hpp"
 #include "webmids.hpp"
 #include "webm_chunk_writer.h"
+#include "webm_log.h"
 
 namespace mkvmuxer {
 class AudioTrack;
@@ -34,7 +36,13 @@ namespace webm_tools {
 WebMLiveMuxer::WebMLiveMuxer()
     : audio_track_num_(0),
       video_track_num_(0),
-      initialized_(false) {
+      initialized_(false),
+      partial_chunk_frames_(0),
+      partial_chunk_bytes_(0),
+      frames_in_open_chunk_(0),
+      chunks_completed_(0),
+      index_enabled_(false),
+      index_(0) {
 }
 
 WebMLiveMuxer::~WebMLiveMuxer() {
@@ -48,10 +56,14 @@ int WebMLiveMuxer::Init() {
     fprintf(stderr, "Cannot construct WebmWriteBuffer.\n");
     return kNoMemory;
   }
-  if (ptr_writer_->Init(&buffer_)) {
+  if (ptr_writer_->Init()) {
     fprintf(stderr, "Cannot Init WebmWriteBuffer.\n");
     return kMuxerError;
   }
+  index_.Clear();
+  open_index_entry_ = WebMLiveIndexEntry();
+  ptr_audio_encryptor_.reset();
+  ptr_video_encryptor_.reset();
 
   // Construct and Init |ptr_segment_|, then enable live mode.
   ptr_segment_.reset(new (std::nothrow) mkvmuxer::Segment());  // NOLINT
@@ -166,6 +178,60 @@ bool WebMLiveMuxer::AddContentEncKeyId(uint64 track_num,
   return true;
 }
 
+int WebMLiveMuxer::SetTrackEncryption(uint64 track_num,
+                                      const WebMEncryptionConfig& config) {
+  std::unique_ptr<WebMFrameEncryptor>* ptr_encryptor = NULL;
+  const WebMFrameEncryptor* other_encryptor = NULL;
+  if (track_num != 0 && track_num == audio_track_num_) {
+    ptr_encryptor = &ptr_audio_encryptor_;
+    other_encryptor = ptr_video_encryptor_.get();
+  } else if (track_num != 0 && track_num == video_track_num_) {
+    ptr_encryptor = &ptr_video_encryptor_;
+    other_encryptor = ptr_audio_encryptor_.get();
+  } else {
+    fprintf(stderr, "Cannot SetTrackEncryption, unknown track %llu.\n",
+            static_cast<unsigned long long>(track_num));
+    return kInvalidArg;
+  }
+  if (config.key_id.empty()) {
+    fprintf(stderr, "Cannot SetTrackEncryption with empty key_id.\n");
+    return kInvalidArg;
+  }
+
+  uint64 initial_iv = config.initial_iv;
+  if (!config.has_initial_iv &&
+      !WebMFrameEncryptor::GenerateInitialIV(&initial_iv)) {
+    return kEncryptionError;
+  }
+
+  // Tracks encrypted with the same key from the same IV would share the
+  // AES-CTR keystream.
+  if (other_encryptor && other_encryptor->key() == config.key &&
+      other_encryptor->initial_iv() == initial_iv) {
+    fprintf(stderr, "Cannot SetTrackEncryption, the other track uses the "
+            "same key and IV.\n");
+    return kInvalidArg;
+  }
+
+  std::unique_ptr<WebMFrameEncryptor> encryptor(
+      new (std::nothrow) WebMFrameEncryptor());  // NOLINT
+  if (!encryptor.get()) {
+    fprintf(stderr, "Cannot construct WebMFrameEncryptor.\n");
+    return kNoMemory;
+  }
+  if (!encryptor->Init(config.key, initial_iv)) {
+    fprintf(stderr, "Cannot Init WebMFrameEncryptor.\n");
+    return kEncryptionError;
+  }
+  if (!AddContentEncKeyId(
+          track_num, reinterpret_cast<const uint8*>(config.key_id.data()),
+          config.key_id.size())) {
+    return kEncryptionError;
+  }
+  ptr_encryptor->swap(encryptor);
+  return kSuccess;
+}
+
 int WebMLiveMuxer::AddVideoTrack(int width, int height) {
   if (video_track_num_ != 0) {
     fprintf(stderr, "Cannot add video track: it already exists.\n");
@@ -259,8 +325,8 @@ int WebMLiveMuxer::Finalize() {
     return kMuxerError;
   }
 
-  if (buffer_.size() > 0) {
-    // When data is in |buffer_| after the |mkvmuxer::Segment::Finalize()|
+  if (ptr_writer_->bytes_buffered() > 0) {
+    // When data is buffered after the |mkvmuxer::Segment::Finalize()|
     // call, make the last chunk available to the user by forcing
     // |ChunkReady()| to return true one final time. This last chunk will
     // contain any data passed to |mkvmuxer::Segment::AddFrame()| since the
@@ -269,6 +335,8 @@ int WebMLiveMuxer::Finalize() {
                                     ptr_writer_->bytes_written());
   }
 
+  if (index_enabled_)
+    CloseIndexEntry();
   return kSuccess;
 }
 
@@ -293,6 +361,19 @@ int WebMLiveMuxer::WriteVideoFrame(const uint8* data, size_t size,
 int WebMLiveMuxer::WriteFrame(const uint8* data, size_t size,
                               uint64 timestamp_ns, uint64 track_num,
                               bool is_key) {
+  WebMFrameEncryptor* const encryptor =
+      track_num == video_track_num_ ? ptr_video_encryptor_.get() :
+      track_num == audio_track_num_ ? ptr_audio_encryptor_.get() : NULL;
+  if (encryptor) {
+    // libwebm copies the frame, so |encrypted_frame_| is reused.
+    if (!encryptor->EncryptFrame(data, size, &encrypted_frame_)) {
+      fprintf(stderr, "Cannot encrypt frame.\n");
+      return kEncryptionError;
+    }
+    data = &encrypted_frame_[0];
+    size = encrypted_frame_.size();
+  }
+
   if (!ptr_segment_->AddFrame(data,
                               size,
                               track_num,
@@ -301,6 +382,29 @@ int WebMLiveMuxer::WriteFrame(const uint8* data, size_t size,
     fprintf(stderr, "AddFrame failed.\n");
     return kVideoWriteError;
   }
+
+  if (index_enabled_)
+    IndexFrame(track_num, timestamp_ns, is_key);
+
+  if (partial_chunk_frames_ > 0 || partial_chunk_bytes_ > 0) {
+    // A Cluster start during |AddFrame()| leaves the frame in a new chunk.
+    if (ptr_writer_->chunks_completed() != chunks_completed_)
+      frames_in_open_chunk_ = 0;
+    ++frames_in_open_chunk_;
+
+    if ((partial_chunk_frames_ > 0 &&
+         frames_in_open_chunk_ >= partial_chunk_frames_) ||
+        (partial_chunk_bytes_ > 0 &&
+         ptr_writer_->open_chunk_bytes() >= partial_chunk_bytes_)) {
+      // Frames queued by libwebm for interleaving are not in the open chunk
+      // yet, so the partial chunk may hold fewer frames.
+      ptr_writer_->EndPartialChunk();
+      frames_in_open_chunk_ = 0;
+      if (index_enabled_)
+        CloseIndexEntry();
+    }
+    chunks_completed_ = ptr_writer_->chunks_completed();
+  }
   return kSuccess;
 }
 
@@ -317,8 +421,9 @@ bool WebMLiveMuxer::ChunkReady(int32* ptr_chunk_length) {
   return false;
 }
 
-// Copies the buffered chunk data into |ptr_buf|, erases it from |buffer_|, and
-// calls |WebMChunkWriter::ResetChunkEnd()| to zero the chunk end position.
+// Copies the ready chunk into |ptr_buf|, and calls
+// |WebMChunkWriter::EraseChunk()| to release its buffer and make the next
+// completed chunk ready.
 int WebMLiveMuxer::ReadChunk(int32 buffer_capacity, uint8* ptr_buf) {
   if (!ptr_buf) {
     fprintf(stderr, "NULL buffer pointer.\n");
@@ -338,11 +443,134 @@ int WebMLiveMuxer::ReadChunk(int32 buffer_capacity, uint8* ptr_buf) {
     return kUserBufferTooSmall;
   }
 
-  fprintf(stdout, "ReadChunk capacity=%d length=%d total buffered=%zd\n",
-          buffer_capacity, chunk_length, buffer_.size());
+  WEBM_TRACE("ReadChunk capacity=%d length=%d total buffered=%lld\n",
+             buffer_capacity, chunk_length, ptr_writer_->bytes_buffered());
+
+  // Copy chunk to user buffer, and erase it from the writer.
+  if (ptr_writer_->CopyChunk(ptr_buf)) {
+    fprintf(stderr, "Could not copy chunk.\n");
+    return kMuxerError;
+  }
+  ptr_writer_->EraseChunk();
+  return kSuccess;
+}
+
+int WebMLiveMuxer::chunk_flags() const {
+  int flags = 0;
+  if (ptr_writer_.get()) {
+    if (ptr_writer_->chunk_starts_cluster())
+      flags |= kChunkClusterStart;
+    if (ptr_writer_->chunk_ends_cluster())
+      flags |= kChunkClusterEnd;
+  }
+  return flags;
+}
+
+WebMChunkStats WebMLiveMuxer::chunk_stats() const {
+  WebMChunkStats stats;
+  if (ptr_writer_.get()) {
+    stats.chunks_emitted = ptr_writer_->chunks_emitted();
+    stats.bytes_emitted = ptr_writer_->bytes_emitted();
+    stats.bytes_buffered = ptr_writer_->bytes_buffered();
+    stats.max_bytes_buffered = ptr_writer_->max_bytes_buffered();
+  }
+  return stats;
+}
+
+int WebMLiveMuxer::ReadChunk(ChunkBuffer* ptr_chunk) {
+  if (!ptr_chunk) {
+    fprintf(stderr, "NULL chunk pointer.\n");
+    return kInvalidArg;
+  }
 
-  // Copy chunk to user buffer, and erase it from |buffer_|.
-  memcpy(ptr_buf, &buffer_[0], chunk_length);
+  int32 chunk_length = 0;
+  if (!ChunkReady(&chunk_length)) {
+    fprintf(stderr, "No chunk ready.\n");
+    return kNoChunkReady;
+  }
+
+  if (ptr_writer_->ReadChunk(ptr_chunk)) {
+    fprintf(stderr, "Could not read chunk.\n");
+    return kMuxerError;
+  }
+  return kSuccess;
+}
+
+int WebMLiveMuxer::ReadChunk(SharedChunk* ptr_chunk) {
+  if (!ptr_chunk) {
+    fprintf(stderr, "NULL chunk pointer.\n");
+    return kInvalidArg;
+  }
+
+  std::shared_ptr<ChunkBuffer> chunk(
+      new (std::nothrow) ChunkBuffer());  // NOLINT
+  if (!chunk.get()) {
+    fprintf(stderr, "Cannot construct chunk buffer.\n");
+    return kNoMemory;
+  }
+
+  const int status = ReadChunk(chunk.get());
+  if (status != kSuccess)
+    return status;
+
+  *ptr_chunk = chunk;
+  return kSuccess;
+}
+
+void WebMLiveMuxer::set_index_window(size_t chunks) {
+  index_enabled_ = chunks > 0;
+  index_.set_max_entries(chunks);
+}
+
+void WebMLiveMuxer::IndexFrame(uint64 track_num, uint64 timestamp_ns,
+                               bool is_key) {
+  if (ptr_writer_->chunks_completed() != open_index_entry_.chunk_number)
+    CloseIndexEntry();
+
+  // Audio key frames only mark chunks of audio only streams: with video,
+  // decoding starts at a video key frame.
+  if (track_num == video_track_num_) {
+    open_index_entry_.AddFrame(WebMLiveIndexEntry::kVideo,
+                               static_cast<int64>(timestamp_ns), is_key);
+  } else if (track_num == audio_track_num_) {
+    open_index_entry_.AddFrame(WebMLiveIndexEntry::kAudio,
+                               static_cast<int64>(timestamp_ns),
+                               is_key && video_track_num_ == 0);
+  }
+}
+
+void WebMLiveMuxer::CloseIndexEntry() {
+  const int64 open_chunk_offset =
+      ptr_writer_->bytes_written() - ptr_writer_->open_chunk_bytes();
+  open_index_entry_.size = open_chunk_offset - open_index_entry_.offset;
+  if (open_index_entry_.has_frames() && open_index_entry_.size > 0)
+    index_.AddEntry(open_index_entry_);
+
+  open_index_entry_ = WebMLiveIndexEntry();
+  open_index_entry_.chunk_number = ptr_writer_->chunks_completed();
+  open_index_entry_.offset = open_chunk_offset;
+}
+
+int WebMLiveMuxer::WriteChunk(WebMChunkSink* ptr_sink) {
+  if (!ptr_sink) {
+    fprintf(stderr, "NULL chunk sink pointer.\n");
+    return kInvalidArg;
+  }
+
+  int32 chunk_length = 0;
+  if (!ChunkReady(&chunk_length)) {
+    fprintf(stderr, "No chunk ready.\n");
+    return kNoChunkReady;
+  }
+
+  const WebMChunkWriter::WriteBuffer& chunk = ptr_writer_->ready_chunk();
+  const WebMChunkPiece piece = { &chunk[0], chunk.size() };
+
+  WEBM_TRACE("WriteChunk length=%d\n", chunk_length);
+  if (!ptr_sink->WriteChunk(&piece, 1, chunk_flags())) {
+    fprintf(stderr, "Could not write chunk to sink.\n");
+    return kChunkSinkError;
+  }
   ptr_writer_->EraseChunk();
   return kSuccess;
 }
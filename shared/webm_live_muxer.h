@@ -15,6 +15,9 @@
 #include <vector>
 
 #include "mkvmuxer.hpp"
+#include "webm_chunk_sink.h"
+#include "webm_frame_encryptor.h"
+#include "webm_live_index.h"
 #include "webm_tools_types.h"
 
 // Forward declarations of libwebm muxer types used by |WebMLiveMuxer|.
@@ -27,6 +30,24 @@ namespace webm_tools {
 // Forward declaration of class implementing IMkvWriter interface for libwebm.
 class WebMChunkWriter;
 
+// Counters describing the chunks produced by a |WebMLiveMuxer|.
+struct WebMChunkStats {
+  WebMChunkStats()
+      : chunks_emitted(0),
+        bytes_emitted(0),
+        bytes_buffered(0),
+        max_bytes_buffered(0) {
+  }
+
+  // Number and total size of the chunks read from the muxer.
+  int64 chunks_emitted;
+  int64 bytes_emitted;
+
+  // Bytes currently buffered, and the largest number of bytes buffered.
+  int64 bytes_buffered;
+  int64 max_bytes_buffered;
+};
+
 // WebM muxing class built atop libwebm. Provides buffers containing WebM
 // "chunks". Chunks will be comprised of one or more full level 1 WebM
 // Elements. The first chunk will include EBMLHeader, Segment, SegmentInfo,
@@ -44,16 +65,53 @@ class WebMChunkWriter;
 //
 // - Users are responsible for keeping memory usage reasonable by calling
 //   |ChunkReady()| periodically-- when |ChunkReady| returns true,
-//   |ReadChunk()| will return the complete chunk and discard it from the
-//   buffer.
+//   |ReadChunk()| will return the oldest complete chunk and discard it from
+//   the buffer.
+//
+// - In low latency mode, enabled with |set_partial_chunk_frames()| or
+//   |set_partial_chunk_bytes()|, chunks may end inside a Cluster. Clusters
+//   have unknown sizes in live mode, so the partial chunks can be sent to
+//   clients as soon as they are read. |chunk_flags()| tells where the
+//   Clusters start and end.
+//
+// - Live streams have no Cues. With |set_index_window()| the muxer keeps a
+//   rolling |WebMLiveIndex| of its chunks for time to chunk lookups.
+//
+// - Tracks configured with |SetTrackEncryption()| are encrypted as their
+//   frames are written, so encrypted live streams need no webm_crypt pass.
 //
 class WebMLiveMuxer {
  public:
+  // Buffer holding one WebM chunk.
+  typedef std::vector<uint8> ChunkBuffer;
+
+  // Immutable chunk that can be shared by several consumers. The chunk data
+  // is released with the last reference.
+  typedef std::shared_ptr<const ChunkBuffer> SharedChunk;
+
+  // Flags describing the ready chunk, returned by |chunk_flags()|.
+  enum ChunkFlags {
+    // The chunk starts with a Cluster element.
+    kChunkClusterStart = 1,
+
+    // The chunk ends where a Cluster starts, or at the end of the stream.
+    // Chunks without this flag end inside a Cluster. When a Cluster ends
+    // right after a partial chunk was read, the next chunk having
+    // |kChunkClusterStart| is the only signal of the Cluster end.
+    kChunkClusterEnd = 2,
+  };
+
   // Status codes returned by class methods.
   enum {
     // Temporary return code for unimplemented operations.
     kNotImplemented = -200,
 
+    // |SetTrackEncryption()| failed, or a frame could not be encrypted.
+    kEncryptionError = -15,
+
+    // The |WebMChunkSink| passed to |WriteChunk()| failed.
+    kChunkSinkError = -14,
+
     // Unable to write audio buffer.
     kAudioWriteError = -13,
 
@@ -125,6 +183,15 @@ class WebMLiveMuxer {
   bool AddContentEncKeyId(uint64 track_num,
                           const uint8* enc_key_id, size_t enc_key_id_size);
 
+  // Encrypts the frames of |track_num| as they are written, in the WebM
+  // encryption format of |WebMFrameEncryptor|. |config.key_id| is added to
+  // the Track with |AddContentEncKeyId()|. Without |config.has_initial_iv|
+  // the first IV is random. Must be called after the track is added and
+  // before any frames are written. Returns |kInvalidArg| when the other
+  // track is encrypted with the same key and initial IV, and |kSuccess| when
+  // successful.
+  int SetTrackEncryption(uint64 track_num, const WebMEncryptionConfig& config);
+
   // Adds a video track to |ptr_segment_|, and returns the track number [1-127].
   // Returns |kVideoTrackAlreadyExists| when the video track has already been
   // added. Returns |kVideoTrackError| when adding the track to the segment
@@ -174,25 +241,97 @@ class WebMLiveMuxer {
   int WriteFrame(const uint8* data, size_t size,
                  uint64 timestamp_ns, uint64 track_num, bool is_key);
 
-  // Returns true and writes chunk length to |ptr_chunk_length| when |buffer_|
-  // contains a complete WebM chunk.
+  // Returns true and writes chunk length to |ptr_chunk_length| when the writer
+  // holds a complete WebM chunk. Completed chunks are returned one at a time,
+  // oldest first, so a chunk never spans a Cluster start; call
+  // |ChunkReady()| again after reading a chunk.
   bool ChunkReady(int32* ptr_chunk_length);
 
-  // Moves WebM chunk data into |ptr_buf|. The data has been from removed from
-  // |buffer_| when |kSuccess| is returned.  Returns |kUserBufferTooSmall| if
+  // Moves WebM chunk data into |ptr_buf|. The data has been removed from the
+  // writer when |kSuccess| is returned.  Returns |kUserBufferTooSmall| if
   // |buffer_capacity| is less than |chunk_length|.
   int ReadChunk(int32 buffer_capacity, uint8* ptr_buf);
 
+  // Moves WebM chunk data into |ptr_chunk| without copying it. The previous
+  // contents of |ptr_chunk| are discarded and its storage is reused for later
+  // chunks, so callers reading every chunk into the same |ChunkBuffer| do not
+  // allocate once the buffers have grown to the chunk size. Returns
+  // |kNoChunkReady| when no chunk is ready.
+  int ReadChunk(ChunkBuffer* ptr_chunk);
+
+  // Moves WebM chunk data into a new |SharedChunk| stored in |ptr_chunk|
+  // without copying it. Returns |kNoChunkReady| when no chunk is ready.
+  int ReadChunk(SharedChunk* ptr_chunk);
+
+  // Passes the ready chunk to |ptr_sink| in place, without copying it, and
+  // erases it from the writer. The chunk is passed as one piece. Returns
+  // |kNoChunkReady| when no chunk is ready, and |kChunkSinkError| when
+  // |ptr_sink| fails, in which case the chunk stays ready.
+  int WriteChunk(WebMChunkSink* ptr_sink);
+
+  // Returns the chunk counters of the muxer. Must not be called before
+  // |Init()|.
+  WebMChunkStats chunk_stats() const;
+
+  // Returns the |ChunkFlags| of the ready chunk. Only valid when
+  // |ChunkReady()| returns true.
+  int chunk_flags() const;
+
+  // Enables low latency mode: a chunk is completed once |frames| frames
+  // were written to the open chunk, without waiting for the next Cluster.
+  // 0 disables the limit.
+  void set_partial_chunk_frames(int frames) { partial_chunk_frames_ = frames; }
+
+  // Enables low latency mode: a chunk is completed once |bytes| bytes were
+  // written to the open chunk, without waiting for the next Cluster. 0
+  // disables the limit.
+  void set_partial_chunk_bytes(int64 bytes) { partial_chunk_bytes_ = bytes; }
+
+  // Enables the chunk index, keeping the entries of the |chunks| most recent
+  // chunks holding frames. 0, the default, disables the index. Frames
+  // queued by libwebm for interleaving are indexed in the chunk open when
+  // they were written to the muxer, see |WebMLiveIndexEntry|.
+  void set_index_window(size_t chunks);
+
   // Accessors.
   bool initialized() const { return initialized_; }
+  const WebMLiveIndex& index() const { return index_; }
 
  private:
+  // Adds a frame written to |track_num| to |open_index_entry_|, first
+  // indexing the chunk completed by |mkvmuxer::Segment::AddFrame()| if a
+  // Cluster started.
+  void IndexFrame(uint64 track_num, uint64 timestamp_ns, bool is_key);
+
+  // Adds |open_index_entry_| to |index_| and opens the entry of the chunk
+  // being written.
+  void CloseIndexEntry();
+
   std::unique_ptr<WebMChunkWriter> ptr_writer_;
   std::unique_ptr<mkvmuxer::Segment> ptr_segment_;
   uint64 audio_track_num_;
   uint64 video_track_num_;
-  std::vector<uint8> buffer_;
   bool initialized_;
+
+  // Low latency mode limits. 0 when disabled.
+  int partial_chunk_frames_;
+  int64 partial_chunk_bytes_;
+
+  // Frames written since the open chunk started, and the writer's completed
+  // chunk count when the last frame was written.
+  int frames_in_open_chunk_;
+  int64 chunks_completed_;
+
+  // Chunk index, and the entry of the chunk being written.
+  bool index_enabled_;
+  WebMLiveIndex index_;
+  WebMLiveIndexEntry open_index_entry_;
+
+  // Encryptors of the tracks configured with |SetTrackEncryption()|, and the
+  // encrypted frame passed to libwebm, reused for every frame.
+  std::unique_ptr<WebMFrameEncryptor> ptr_audio_encryptor_;
+  std::unique_ptr<WebMFrameEncryptor> ptr_video_encryptor_;
+  std::vector<uint8> encrypted_frame_;
   WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMLiveMuxer);
 };
 
@@ -0,0 +1,61 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webm_log.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace webm_tools {
+
+namespace {
+
+std::atomic<int> g_log_level(kLogWarning);
+
+const char* LogLevelName(LogLevel level) {
+  switch (level) {
+    case kLogError:
+      return "error";
+    case kLogWarning:
+      return "warning";
+    case kLogInfo:
+      return "info";
+    case kLogDebug:
+      return "debug";
+    case kLogTrace:
+      return "trace";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+void SetLogLevel(LogLevel level) {
+  g_log_level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel GetLogLevel() {
+  return static_cast<LogLevel>(g_log_level.load(std::memory_order_relaxed));
+}
+
+bool LogEnabled(LogLevel level) {
+  return level <= g_log_level.load(std::memory_order_relaxed);
+}
+
+void LogMessage(LogLevel level, const char* format, ...) {
+  // Messages longer than the buffer are truncated.
+  char message[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  fprintf(stderr, "[webm_tools %s] %s", LogLevelName(level), message);
+}
+
+}  // namespace webm_tools
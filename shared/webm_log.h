@@ -0,0 +1,69 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_LOG_H_
+#define SHARED_WEBM_LOG_H_
+
+namespace webm_tools {
+
+// Severity of a log message. Messages are written to stderr when their level
+// is not more verbose than the level set with |SetLogLevel()|.
+enum LogLevel {
+  kLogError = 0,
+  kLogWarning = 1,
+  kLogInfo = 2,
+  kLogDebug = 3,
+
+  // Per chunk and per frame messages. Only compiled in when
+  // WEBM_TOOLS_ENABLE_TRACE is defined, see |WEBM_TRACE()|.
+  kLogTrace = 4,
+};
+
+// Sets the most verbose level written. The default is |kLogWarning|. Thread
+// safe.
+void SetLogLevel(LogLevel level);
+LogLevel GetLogLevel();
+
+// Returns true when messages of |level| are written.
+bool LogEnabled(LogLevel level);
+
+// Writes the printf style |format| message to stderr with a prefix naming
+// |level|. The message is written with one call, so messages of different
+// threads are not interleaved. Use |WEBM_LOG()|, which does not format
+// messages of disabled levels.
+void LogMessage(LogLevel level, const char* format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+}  // namespace webm_tools
+
+// Writes a message when |level| is enabled. Arguments are only evaluated
+// when the message is written.
+#define WEBM_LOG(level, ...)                                      \
+  do {                                                            \
+    if (webm_tools::LogEnabled(level))                            \
+      webm_tools::LogMessage(level, __VA_ARGS__);                 \
+  } while (0)
+
+// Writes a |kLogTrace| message. Trace messages are removed at compile time
+// unless WEBM_TOOLS_ENABLE_TRACE is defined, so the default build pays
+// nothing for them. Disabled trace statements are still type checked, but
+// their arguments are never evaluated.
+#if defined(WEBM_TOOLS_ENABLE_TRACE)
+#define WEBM_TRACE(...) WEBM_LOG(webm_tools::kLogTrace, __VA_ARGS__)
+#else
+#define WEBM_TRACE(...)                                           \
+  do {                                                            \
+    if (false)                                                    \
+      webm_tools::LogMessage(webm_tools::kLogTrace, __VA_ARGS__); \
+  } while (0)
+#endif
+
+#endif  // SHARED_WEBM_LOG_H_
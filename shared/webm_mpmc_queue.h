@@ -0,0 +1,156 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_WEBM_MPMC_QUEUE_H_
+#define SHARED_WEBM_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+// Lock free FIFO queue for any number of producer and consumer threads,
+// holding at most |capacity()| items. Neither |TryPush()| nor |TryPop()|
+// block: they fail when the queue is full or empty, and callers choose how
+// to wait.
+//
+// Notes:
+// - Items are swapped in and out of the queue slots instead of being copied,
+//   so buffers owned by |T| are handed between threads without copies, and
+//   the storage an item held before |TryPop()| is returned to the next
+//   |TryPush()| of the slot.
+//
+// - The capacity is rounded up to a power of two.
+//
+// - Each slot has a sequence number telling producers and consumers whose
+//   turn it is, so threads only contend on the two position counters.
+template <typename T>
+class MpmcQueue {
+ public:
+  explicit MpmcQueue(size_t capacity)
+      : capacity_(RoundUpToPowerOfTwo(capacity)),
+        mask_(capacity_ - 1),
+        enqueue_pos_(),
+        dequeue_pos_() {
+  }
+  ~MpmcQueue() {}
+
+  // Allocates the queue slots. Returns false when out of memory.
+  bool Init() {
+    cells_.reset(new (std::nothrow) Cell[capacity_]);  // NOLINT
+    if (!cells_.get())
+      return false;
+    for (size_t i = 0; i < capacity_; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Swaps |item| into the back of the queue. Returns false if the queue is
+  // full, in which case |item| is unchanged.
+  bool TryPush(T* item) {
+    if (!item || !cells_.get())
+      return false;
+
+    size_t pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                  static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.value.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          using std::swap;
+          swap(cell.data, *item);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Swaps the item at the front of the queue into |item|. Returns false if
+  // the queue is empty, in which case |item| is unchanged.
+  bool TryPop(T* item) {
+    if (!item || !cells_.get())
+      return false;
+
+    size_t pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                  static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.value.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          using std::swap;
+          swap(cell.data, *item);
+          cell.sequence.store(pos + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns true if the queue looked empty. Other threads may change the
+  // queue before the caller acts on the result.
+  bool Empty() const {
+    return enqueue_pos_.value.load(std::memory_order_acquire) ==
+           dequeue_pos_.value.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // Position counter padded to its own cache line, so producers and
+  // consumers do not invalidate each other's line.
+  struct Position {
+    Position() : value(0) {}
+    std::atomic<size_t> value;
+    char padding[64];
+  };
+
+  Position enqueue_pos_;
+  Position dequeue_pos_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(MpmcQueue);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_WEBM_MPMC_QUEUE_H_
@@ -0,0 +1,187 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "xml_writer.h"
+
+#include <cstring>
+#include <string>
+
+namespace webm_tools {
+
+namespace {
+
+// Initial capacity of the buffer, which holds a typical manifest.
+const size_t kInitialCapacity = 16 * 1024;
+
+}  // namespace
+
+const size_t XmlWriter::kFlushSize;
+
+XmlWriter::XmlWriter()
+    : file_(NULL),
+      buffer_(),
+      indent_(0),
+      write_error_(false) {
+  buffer_.reserve(kInitialCapacity);
+}
+
+XmlWriter::XmlWriter(FILE* file)
+    : file_(file),
+      buffer_(),
+      indent_(0),
+      write_error_(false) {
+  buffer_.reserve(kFlushSize + kInitialCapacity);
+}
+
+XmlWriter::~XmlWriter() {
+}
+
+void XmlWriter::Adjust(int indent) {
+  indent_ += indent;
+  if (indent_ < 0)
+    indent_ = 0;
+}
+
+void XmlWriter::StartElement(const char* name) {
+  buffer_.append(indent_, ' ');
+  buffer_ += '<';
+  buffer_ += name;
+}
+
+void XmlWriter::Attribute(const char* name, const std::string& value) {
+  buffer_ += ' ';
+  buffer_ += name;
+  buffer_ += "=\"";
+  AppendEscaped(value);
+  buffer_ += '"';
+}
+
+void XmlWriter::Attribute(const char* name, int64 value) {
+  char str[32];
+  snprintf(str, sizeof(str), "%lld", value);
+  buffer_ += ' ';
+  buffer_ += name;
+  buffer_ += "=\"";
+  buffer_ += str;
+  buffer_ += '"';
+}
+
+void XmlWriter::DoubleAttribute(const char* name, double value) {
+  char str[64];
+  snprintf(str, sizeof(str), "%g", value);
+  buffer_ += ' ';
+  buffer_ += name;
+  buffer_ += "=\"";
+  buffer_ += str;
+  buffer_ += '"';
+}
+
+void XmlWriter::DurationAttribute(const char* name, double seconds) {
+  char str[64];
+  snprintf(str, sizeof(str), "PT%gS", seconds);
+  buffer_ += ' ';
+  buffer_ += name;
+  buffer_ += "=\"";
+  buffer_ += str;
+  buffer_ += '"';
+}
+
+void XmlWriter::RangeAttribute(const char* name, int64 start, int64 end) {
+  char str[64];
+  snprintf(str, sizeof(str), "%lld-%lld", start, end);
+  buffer_ += ' ';
+  buffer_ += name;
+  buffer_ += "=\"";
+  buffer_ += str;
+  buffer_ += '"';
+}
+
+void XmlWriter::EndStartTag() {
+  buffer_ += ">\n";
+  MaybeFlush();
+}
+
+void XmlWriter::EndEmptyElement() {
+  buffer_ += " />\n";
+  MaybeFlush();
+}
+
+void XmlWriter::EndElement(const char* name) {
+  buffer_.append(indent_, ' ');
+  buffer_ += "</";
+  buffer_ += name;
+  buffer_ += ">\n";
+  MaybeFlush();
+}
+
+void XmlWriter::TextElement(const char* name, const std::string& text) {
+  buffer_.append(indent_, ' ');
+  buffer_ += '<';
+  buffer_ += name;
+  buffer_ += '>';
+  AppendEscaped(text);
+  buffer_ += "</";
+  buffer_ += name;
+  buffer_ += ">\n";
+  MaybeFlush();
+}
+
+void XmlWriter::Write(const char* str) {
+  buffer_ += str;
+  MaybeFlush();
+}
+
+void XmlWriter::Write(const std::string& str) {
+  buffer_ += str;
+  MaybeFlush();
+}
+
+bool XmlWriter::Flush() {
+  if (!file_)
+    return true;
+
+  if (!buffer_.empty()) {
+    if (fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size())
+      write_error_ = true;
+    buffer_.clear();
+  }
+  return !write_error_;
+}
+
+void XmlWriter::Release(std::string* output) {
+  if (!output)
+    return;
+  output->swap(buffer_);
+  buffer_.clear();
+}
+
+void XmlWriter::AppendEscaped(const std::string& str) {
+  size_t start = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    const char* escaped = NULL;
+    switch (str[i]) {
+      case '&': escaped = "&amp;"; break;
+      case '<': escaped = "&lt;"; break;
+      case '>': escaped = "&gt;"; break;
+      case '"': escaped = "&quot;"; break;
+      case '\'': escaped = "&apos;"; break;
+      default: continue;
+    }
+    buffer_.append(str, start, i - start);
+    buffer_ += escaped;
+    start = i + 1;
+  }
+  buffer_.append(str, start, std::string::npos);
+}
+
+void XmlWriter::MaybeFlush() {
+  if (file_ && buffer_.size() >= kFlushSize)
+    Flush();
+}
+
+}  // namespace webm_tools
@@ -0,0 +1,121 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef SHARED_XML_WRITER_H_
+#define SHARED_XML_WRITER_H_
+
+#include <cstdio>
+#include <string>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+
+const int kIncreaseIndent = 2;
+const int kDecreaseIndent = -2;
+
+// Streaming XML writer. Output is appended to one growable buffer, which is
+// either kept in memory or written to a FILE each time it grows past
+// |kFlushSize| bytes. Objects only have to keep track of the indentation
+// within their scope.
+//
+// Usage:
+//   XmlWriter writer(file);
+//   writer.Adjust(kIncreaseIndent);
+//   writer.StartElement("Period");
+//   writer.Attribute("id", id);
+//   writer.EndStartTag();
+//   ...
+//   writer.EndElement("Period");
+//   writer.Adjust(kDecreaseIndent);
+//   if (!writer.Flush())
+//     return false;
+class XmlWriter {
+ public:
+  // Buffer size that triggers a write when writing to a FILE.
+  static const size_t kFlushSize = 64 * 1024;
+
+  // Constructs a writer keeping the output in memory.
+  XmlWriter();
+
+  // Constructs a writer writing the output to |file|. The caller owns
+  // |file| and must call |Flush()| before closing it.
+  explicit XmlWriter(FILE* file);
+
+  ~XmlWriter();
+
+  // Changes the number of spaces output before elements. The value adjusted
+  // is relative to the current indentation.
+  void Adjust(int indent);
+
+  // Writes the indentation and "<|name|".
+  void StartElement(const char* name);
+
+  // Writes ' |name|="|value|"'. Characters of |value| that cannot appear in
+  // an attribute value are escaped.
+  void Attribute(const char* name, const std::string& value);
+  void Attribute(const char* name, int64 value);
+
+  // Writes a floating point value formatted with "%g".
+  void DoubleAttribute(const char* name, double value);
+
+  // Writes an xs:duration of |seconds|, formatted as "PT%gS".
+  void DurationAttribute(const char* name, double seconds);
+
+  // Writes an RFC 2616 byte range. |start| and |end| are inclusive.
+  void RangeAttribute(const char* name, int64 start, int64 end);
+
+  // Writes ">" and a newline, ending the start tag of an element with
+  // children.
+  void EndStartTag();
+
+  // Writes " />" and a newline, ending an element without children.
+  void EndEmptyElement();
+
+  // Writes the indentation, "</|name|>" and a newline.
+  void EndElement(const char* name);
+
+  // Writes the indentation and an element holding |text|, escaped, followed
+  // by a newline.
+  void TextElement(const char* name, const std::string& text);
+
+  // Writes |str| without escaping or indentation.
+  void Write(const char* str);
+  void Write(const std::string& str);
+
+  // Writes the buffered output to the FILE. Returns false if a write failed.
+  // Does nothing for a memory writer.
+  bool Flush();
+
+  // Returns the output of a memory writer, or the output not yet flushed to
+  // the FILE.
+  const std::string& buffer() const { return buffer_; }
+
+  // Moves the output of a memory writer to |output| and clears the buffer.
+  void Release(std::string* output);
+
+ private:
+  // Appends |str| with the XML special characters escaped.
+  void AppendEscaped(const std::string& str);
+
+  // Flushes |buffer_| to |file_| once it reaches |kFlushSize|.
+  void MaybeFlush();
+
+  FILE* const file_;
+  std::string buffer_;
+  int indent_;
+
+  // Set when a write to |file_| failed.
+  bool write_error_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(XmlWriter);
+};
+
+}  // namespace webm_tools
+
+#endif  // SHARED_XML_WRITER_H_
@@ -6,6 +6,9 @@
 // in the file PATENTS.  All contributing project authors may
 // be found in the AUTHORS file in the root of the source tree.
 
+#ifndef WEBM_CRYPT_AES_CTR_H_
+#define WEBM_CRYPT_AES_CTR_H_
+
 #include <stdint.h>
 #include <cstdlib>
 #include <cstring>
@@ -26,6 +29,14 @@ using namespace std;
 // Vector is supported in this class.
 class AesCtr128Encryptor {
  public:
+  // CTR state of one key stream. Passing the same state to several Encrypt()
+  // calls encrypts discontiguous ranges as one continuous key stream.
+  struct CounterState {
+    uint8_t ivec[AES_BLOCK_SIZE];
+    uint8_t ecount_buf[AES_BLOCK_SIZE];
+    unsigned int block_offset;
+  };
+
   AesCtr128Encryptor() {}
   ~AesCtr128Encryptor() {}
 
@@ -49,18 +60,47 @@ class AesCtr128Encryptor {
       return false;
     }
 
-    uint8_t ivec[AES_BLOCK_SIZE] = { 0 };
-    uint8_t ecount_buf[AES_BLOCK_SIZE] = { 0 };
-    unsigned int block_offset = 0;
+    return Encrypt(reinterpret_cast<const uint8_t*>(counter_.data()),
+                   input, size, output);
+  }
+
+  // Encrypts |size| bytes of |input| into |output| starting from the
+  // AES_BLOCK_SIZE byte |counter_block|. Does not use or modify the counter
+  // set by SetCounter(), so the key may be shared by several callers.
+  bool Encrypt(const uint8_t* counter_block, const uint8_t* input, size_t size,
+               uint8_t* output) const {
+    if (!counter_block)
+      return false;
 
-    memcpy(ivec, counter_.c_str(), AES_BLOCK_SIZE);
-    AES_ctr128_encrypt(input, output, size, &aes_key_, ivec, ecount_buf,
-                       &block_offset);
+    CounterState state;
+    InitCounterState(counter_block, &state);
+    return Encrypt(&state, input, size, output);
+  }
 
+  // Encrypts |size| bytes of |input| into |output| continuing the key stream
+  // of |state|.
+  bool Encrypt(CounterState* state, const uint8_t* input, size_t size,
+               uint8_t* output) const {
+    if (!state)
+      return false;
+
+    AES_ctr128_encrypt(input, output, size, &aes_key_, state->ivec,
+                       state->ecount_buf, &state->block_offset);
     return true;
   }
 
+  // Sets |state| to the start of the key stream of the AES_BLOCK_SIZE byte
+  // |counter_block|.
+  static void InitCounterState(const uint8_t* counter_block,
+                               CounterState* state) {
+    memcpy(state->ivec, counter_block, AES_BLOCK_SIZE);
+    memset(state->ecount_buf, 0, AES_BLOCK_SIZE);
+    state->block_offset = 0;
+  }
+
  private:
   string counter_;
   AES_KEY aes_key_;
 };
+
+#endif  // WEBM_CRYPT_AES_CTR_H_
@@ -0,0 +1,414 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "encrypt_module.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace webm_crypt {
+
+using std::string;
+
+namespace {
+
+// Encrypts or decrypts |size| bytes of |source| into |destination| using the
+// WebM partitioned encryption layout. |offsets| holds |num_offsets| partition
+// offsets. Partitions alternate between clear and encrypted starting with a
+// clear partition, and the encrypted partitions form one key stream starting
+// at |counter_block|. Returns false if the offsets are not in increasing
+// order or are past |size|.
+bool CryptPartitions(const AesCtr128Encryptor& encryptor,
+                     const uint8_t* counter_block,
+                     const uint8_t* source, size_t size,
+                     const uint32_t* offsets, size_t num_offsets,
+                     uint8_t* destination) {
+  AesCtr128Encryptor::CounterState state;
+  AesCtr128Encryptor::InitCounterState(counter_block, &state);
+
+  size_t start = 0;
+  for (size_t i = 0; i <= num_offsets; ++i) {
+    const size_t end = i < num_offsets ? offsets[i] : size;
+    if (end < start || end > size)
+      return false;
+
+    const bool encrypted = (i & 1) != 0;
+    if (encrypted) {
+      if (!encryptor.Encrypt(&state, source + start, end - start,
+                             destination + start)) {
+        return false;
+      }
+    } else {
+      memcpy(destination + start, source + start, end - start);
+    }
+    start = end;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool HasKeyRotation(const EncryptionSettings& enc) {
+  return enc.key_rotation > 0 || enc.key_rotation_clusters > 0;
+}
+
+size_t KeyPeriodForFrame(const EncryptionSettings& enc, int64_t time_ms,
+                         int64_t cluster_index) {
+  if (enc.key_rotation_clusters > 0) {
+    if (cluster_index < 0)
+      return 0;
+    return static_cast<size_t>(cluster_index / enc.key_rotation_clusters);
+  }
+  if (enc.key_rotation <= 0 || time_ms < 0)
+    return 0;
+  return static_cast<size_t>(time_ms / enc.key_rotation);
+}
+
+size_t NumKeyPeriods(const EncryptionSettings& enc, int64_t duration_ms) {
+  if (enc.key_rotation_clusters > 0)
+    return 1;
+  return KeyPeriodForFrame(enc, duration_ms, 0) + 1;
+}
+
+bool DeriveKeyPeriodKey(const string& base_secret, size_t period,
+                        string* key) {
+  if (!key || base_secret.empty())
+    return false;
+
+  uint8_t period_data[8];
+  const uint64_t period_value = period;
+  for (int i = 0; i < 8; ++i)
+    period_data[i] = static_cast<uint8_t>(period_value >> (56 - i * 8));
+
+  uint8_t digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_size = 0;
+  if (!HMAC(EVP_sha1(), base_secret.data(),
+            static_cast<int>(base_secret.size()), period_data,
+            sizeof(period_data), digest, &digest_size) ||
+      digest_size < EncryptModule::kKeySize) {
+    return false;
+  }
+
+  key->assign(reinterpret_cast<const char*>(digest), EncryptModule::kKeySize);
+  return true;
+}
+
+bool KeySchedules::Init(const EncryptionSettings& enc, const string& secret) {
+  key_rotation_ = HasKeyRotation(enc);
+  secret_ = secret;
+  encryptors_.clear();
+  num_key_periods_ = 0;
+  last_key_period_ = 0;
+  last_encryptor_ = NULL;
+
+  string key = secret;
+  if (key_rotation_ && !DeriveKeyPeriodKey(secret, 0, &key))
+    return false;
+  if (!encryptors_[0].InitKey(key)) {
+    encryptors_.clear();
+    return false;
+  }
+  num_key_periods_ = 1;
+  return true;
+}
+
+const AesCtr128Encryptor* KeySchedules::Get(size_t key_period) {
+  if (last_encryptor_ && key_period == last_key_period_)
+    return last_encryptor_;
+
+  const AesCtr128Encryptor* const encryptor = Find(key_period);
+  if (!encryptor)
+    return NULL;
+
+  // Set up the next key period now, so its first frame does not wait for the
+  // key derivation.
+  if (key_rotation_ && !Find(key_period + 1))
+    return NULL;
+
+  if (key_period >= num_key_periods_)
+    num_key_periods_ = key_period + 1;
+  last_key_period_ = key_period;
+  last_encryptor_ = encryptor;
+  return encryptor;
+}
+
+const AesCtr128Encryptor* KeySchedules::Find(size_t key_period) {
+  const std::map<size_t, AesCtr128Encryptor>::const_iterator iter =
+      encryptors_.find(key_period);
+  if (iter != encryptors_.end())
+    return &iter->second;
+  if (!key_rotation_ || encryptors_.empty())
+    return NULL;
+
+  string key;
+  AesCtr128Encryptor encryptor;
+  if (!DeriveKeyPeriodKey(secret_, key_period, &key) ||
+      !encryptor.InitKey(key)) {
+    return NULL;
+  }
+  return &encryptors_.insert(
+      std::make_pair(key_period, encryptor)).first->second;
+}
+
+// Returns the number of bytes in the encrypted partitions of a frame of
+// |size| bytes split at |offsets|.
+size_t EncryptedPartitionsSize(const std::vector<uint32_t>& offsets,
+                               size_t size) {
+  size_t encrypted_size = 0;
+  for (size_t i = 0; i < offsets.size(); i += 2) {
+    const size_t end = i + 1 < offsets.size() ? offsets[i + 1] : size;
+    encrypted_size += end - offsets[i];
+  }
+  return encrypted_size;
+}
+
+EncryptModule::EncryptModule(const EncryptionSettings& enc,
+                             const string& secret)
+    : do_not_encrypt_(false),
+      enc_(enc),
+      next_iv_(enc.initial_iv),
+      key_period_(0) {
+  key_.assign(secret);
+}
+
+bool EncryptModule::Init() {
+  if (key_.size() == 0) {
+    fprintf(stderr, "Error creating encryption key.\n");
+    return false;
+  }
+
+  if (!do_not_encrypt_) {
+    if (!key_schedules_.Init(enc_, key_)) {
+      fprintf(stderr, "Could not initialize encryptor.\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EncryptModule::ProcessData(const uint8_t* source, size_t size,
+                                bool encrypt_frame,
+                                uint8_t* destination,
+                                size_t* destination_size) {
+  const uint64_t iv = ReserveIV(encrypt_frame);
+  const std::vector<uint32_t> no_partitions;
+  const bool encrypt_the_frame = encrypt_frame && !do_not_encrypt_;
+  const AesCtr128Encryptor* const key_schedule =
+      encrypt_the_frame ? KeySchedule(key_period_) : NULL;
+  if (encrypt_the_frame && !key_schedule)
+    return false;
+  return ProcessDataWithIV(source, size, encrypt_frame, iv, key_schedule,
+                           no_partitions, destination, destination_size);
+}
+
+bool EncryptModule::ProcessDataWithIV(const uint8_t* source, size_t size,
+                                      bool encrypt_frame, uint64_t iv,
+                                      const AesCtr128Encryptor* key_schedule,
+                                      const std::vector<uint32_t>& partitions,
+                                      uint8_t* destination,
+                                      size_t* destination_size) const {
+  if (!source || size <= 0 || !destination || !destination_size)
+    return false;
+
+  const bool encrypt_the_frame = do_not_encrypt_ ? false : encrypt_frame;
+  const bool partitioned = encrypt_the_frame && !partitions.empty();
+  size_t offset = kSignalByteSize;
+
+  if (encrypt_the_frame) {
+    if (!key_schedule) {
+      fprintf(stderr, "No key schedule to encrypt the frame.\n");
+      return false;
+    }
+
+    // Prepend the IV.
+    memcpy(destination + offset, &iv, sizeof(iv));
+
+    uint8_t counter_block[kKeySize];
+    GenerateCounterBlock(destination + offset, counter_block);
+    offset += sizeof(iv);
+
+    if (partitioned) {
+      if (partitions.size() > kMaxPartitions) {
+        fprintf(stderr, "Too many partitions. count:%zu\n",
+                partitions.size());
+        return false;
+      }
+
+      // Partition offsets are written big endian.
+      destination[offset++] = static_cast<uint8_t>(partitions.size());
+      for (size_t i = 0; i < partitions.size(); ++i) {
+        const uint32_t partition_offset = partitions[i];
+        destination[offset++] = static_cast<uint8_t>(partition_offset >> 24);
+        destination[offset++] = static_cast<uint8_t>(partition_offset >> 16);
+        destination[offset++] = static_cast<uint8_t>(partition_offset >> 8);
+        destination[offset++] = static_cast<uint8_t>(partition_offset);
+      }
+
+      if (!CryptPartitions(*key_schedule, counter_block, source, size,
+                           &partitions[0], partitions.size(),
+                           destination + offset)) {
+        fprintf(stderr, "Could not encrypt partitioned data.\n");
+        return false;
+      }
+    } else if (!key_schedule->Encrypt(counter_block, source, size,
+                                     destination + offset)) {
+      fprintf(stderr, "Could not encrypt data.\n");
+      return false;
+    }
+  } else {
+    memcpy(destination + offset, source, size);
+  }
+
+  uint8_t signal_byte = encrypt_the_frame ? kEncryptedFrame : 0;
+  if (partitioned)
+    signal_byte |= kPartitionedFrame;
+  destination[0] = signal_byte;
+  *destination_size = offset + size;
+  return true;
+}
+
+const AesCtr128Encryptor* EncryptModule::KeySchedule(size_t key_period) {
+  if (do_not_encrypt_)
+    return NULL;
+  const AesCtr128Encryptor* const key_schedule =
+      key_schedules_.Get(key_period);
+  if (!key_schedule)
+    fprintf(stderr, "Could not set up key period:%zu\n", key_period);
+  return key_schedule;
+}
+
+uint64_t EncryptModule::ReserveIV(bool encrypt_frame) {
+  const uint64_t iv = next_iv_;
+  if (encrypt_frame && !do_not_encrypt_)
+    ++next_iv_;
+  return iv;
+}
+
+void EncryptModule::GenerateCounterBlock(const uint8_t* iv,
+                                         uint8_t* counter_block) {
+  memcpy(counter_block, iv, kIVSize);
+  memset(counter_block + kIVSize, 0, kKeySize - kIVSize);
+}
+
+DecryptModule::DecryptModule(const EncryptionSettings& enc,
+                             const string& secret,
+                             bool no_decrypt)
+    : do_not_decrypt_(no_decrypt),
+      enc_(enc) {
+  key_.assign(secret);
+}
+
+bool DecryptModule::Init() {
+  if (key_.size() == 0) {
+    fprintf(stderr, "Error creating encryption key.\n");
+    return false;
+  }
+
+  if (!do_not_decrypt_) {
+    if (!key_schedules_.Init(enc_, key_)) {
+      fprintf(stderr, "Could not initialize decryptor.\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+const AesCtr128Encryptor* DecryptModule::KeySchedule(size_t key_period) {
+  if (do_not_decrypt_)
+    return NULL;
+  const AesCtr128Encryptor* const key_schedule =
+      key_schedules_.Get(key_period);
+  if (!key_schedule)
+    fprintf(stderr, "Could not set up key period:%zu\n", key_period);
+  return key_schedule;
+}
+
+bool DecryptModule::DecryptData(const uint8_t* source, size_t length,
+                                const AesCtr128Encryptor* key_schedule,
+                                uint8_t* destination,
+                                size_t *destination_size) const {
+  if (!source || length <= 0)
+    return false;
+
+  size_t offset = 0;
+
+  if (!do_not_decrypt_) {
+    if (length == 0) {
+      fprintf(stderr, "Length of encrypted data is 0.\n");
+      return false;
+    }
+    const uint8_t signal_byte = source[0];
+
+    if (signal_byte & EncryptModule::kEncryptedFrame) {
+      if (length < EncryptModule::kSignalByteSize + EncryptModule::kIVSize) {
+        fprintf(stderr, "Not enough data to read IV.\n");
+        return false;
+      }
+      if (!key_schedule) {
+        fprintf(stderr, "No key schedule to decrypt the frame.\n");
+        return false;
+      }
+
+      uint8_t counter_block[EncryptModule::kKeySize];
+      EncryptModule::GenerateCounterBlock(
+          source + EncryptModule::kSignalByteSize, counter_block);
+
+      offset = EncryptModule::kSignalByteSize + EncryptModule::kIVSize;
+
+      if (signal_byte & EncryptModule::kPartitionedFrame) {
+        if (length < offset + EncryptModule::kNumPartitionsSize) {
+          fprintf(stderr, "Not enough data to read partition count.\n");
+          return false;
+        }
+        const size_t num_partitions = source[offset];
+        offset += EncryptModule::kNumPartitionsSize;
+
+        if (length - offset <
+            num_partitions * EncryptModule::kPartitionOffsetSize) {
+          fprintf(stderr, "Not enough data to read partition offsets.\n");
+          return false;
+        }
+        uint32_t partitions[EncryptModule::kMaxPartitions];
+        for (size_t i = 0; i < num_partitions; ++i) {
+          const uint8_t* const p = source + offset;
+          partitions[i] = (static_cast<uint32_t>(p[0]) << 24) |
+                          (static_cast<uint32_t>(p[1]) << 16) |
+                          (static_cast<uint32_t>(p[2]) << 8) |
+                          static_cast<uint32_t>(p[3]);
+          offset += EncryptModule::kPartitionOffsetSize;
+        }
+
+        if (!CryptPartitions(*key_schedule, counter_block, source + offset,
+                             length - offset, partitions, num_partitions,
+                             destination)) {
+          fprintf(stderr, "Could not decrypt partitioned data.\n");
+          return false;
+        }
+      } else if (!key_schedule->Encrypt(counter_block, source + offset,
+                                       length - offset, destination)) {
+        fprintf(stderr, "Could not decrypt data.\n");
+        return false;
+      }
+    } else {
+      offset = EncryptModule::kSignalByteSize;
+      memcpy(destination, source + offset, length - offset);
+    }
+  } else {
+    offset = EncryptModule::kSignalByteSize;
+    memcpy(destination, source + offset, length - offset);
+  }
+
+  *destination_size = length - offset;
+  return true;
+}
+
+}  // namespace webm_crypt
@@ -0,0 +1,295 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef WEBM_CRYPT_ENCRYPT_MODULE_H_
+#define WEBM_CRYPT_ENCRYPT_MODULE_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "aes_ctr.h"
+
+namespace webm_crypt {
+
+// Struct to hold encryption settings for a single WebM stream.
+struct EncryptionSettings {
+  EncryptionSettings()
+      : base_secret_file(),
+        cipher_mode("CTR"),
+        content_id(),
+        initial_iv(0),
+        partitioned(false),
+        unencrypted_range(0),
+        key_rotation(0),
+        key_rotation_clusters(0),
+        key_period_file() {
+  }
+
+  // Path to a file which holds the base secret.
+  std::string base_secret_file;
+
+  // AES encryption algorithm. Currently only "CTR" is supported.
+  std::string cipher_mode;
+
+  // WebM Content ID element.
+  std::string content_id;
+
+  // Initial Initialization Vector for encryption.
+  uint64_t initial_iv;
+
+  // Flag telling if VP8 and VP9 frames should use partitioned encryption,
+  // which leaves the uncompressed frame headers in the clear.
+  bool partitioned;
+
+  // Do not encrypt frames that have a start time less than
+  // |unencrypted_range| in milliseconds.
+  int64_t unencrypted_range;
+
+  // Length of a key period in milliseconds. If > 0 each key period of the
+  // stream is encrypted with its own key derived from the base secret.
+  int64_t key_rotation;
+
+  // Length of a key period in Clusters, counted in file order. Used instead
+  // of |key_rotation| when > 0.
+  int64_t key_rotation_clusters;
+
+  // Path to the file that receives the key ID and key of each key period.
+  std::string key_period_file;
+};
+
+// Returns true if |enc| has key rotation by time or by Clusters.
+bool HasKeyRotation(const EncryptionSettings& enc);
+
+// Returns the key period of a frame starting at |time_ms| in the Cluster
+// |cluster_index|, counted from 0 in file order. Always 0 if |enc| does not
+// have key rotation.
+size_t KeyPeriodForFrame(const EncryptionSettings& enc, int64_t time_ms,
+                         int64_t cluster_index);
+
+// Returns the number of key periods of a stream of |duration_ms|
+// milliseconds. Returns 1 with |enc.key_rotation_clusters|, as the number of
+// Clusters is only known once they are read.
+size_t NumKeyPeriods(const EncryptionSettings& enc, int64_t duration_ms);
+
+// Key schedules of the key periods of one stream. Without key rotation the
+// only key period uses the base secret. With key rotation the key of a period
+// is derived the first time the period is used, together with the key of the
+// next period so it is ready before the next period starts. Get() is not
+// thread safe: one stage resolves the key schedule of each frame and passes
+// it to the threads encrypting or decrypting the frames.
+class KeySchedules {
+ public:
+  KeySchedules()
+      : key_rotation_(false),
+        num_key_periods_(0),
+        last_key_period_(0),
+        last_encryptor_(NULL) {
+  }
+  ~KeySchedules() {}
+
+  // Sets up the key schedule of the first key period of a stream encrypted
+  // with |enc| and |secret|. Returns true on success.
+  bool Init(const EncryptionSettings& enc, const std::string& secret);
+
+  // Returns the key schedule of |key_period|, or NULL if its key could not
+  // be set up. The schedule is valid until the next Init() call.
+  const AesCtr128Encryptor* Get(size_t key_period);
+
+  // Returns the number of key periods up to the last one used.
+  size_t num_key_periods() const { return num_key_periods_; }
+
+ private:
+  // Returns the key schedule of |key_period|, deriving its key if it was not
+  // set up yet. Returns NULL on failure.
+  const AesCtr128Encryptor* Find(size_t key_period);
+
+  bool key_rotation_;
+  std::string secret_;
+
+  // Key schedules keyed by key period. Entries are never removed, so the
+  // pointers returned by Get() stay valid.
+  std::map<size_t, AesCtr128Encryptor> encryptors_;
+  size_t num_key_periods_;
+
+  // Key period and key schedule returned by the last Get() call. Consecutive
+  // frames share a key period, so most calls skip the map lookup.
+  size_t last_key_period_;
+  const AesCtr128Encryptor* last_encryptor_;
+};
+
+// Derives the key of key period |period| from |base_secret|. The key is the
+// first kKeySize bytes of HMAC-SHA1(|base_secret|, big endian 64 bit
+// |period|). Returns true on success.
+bool DeriveKeyPeriodKey(const std::string& base_secret, size_t period,
+                        std::string* key);
+
+// Returns the number of bytes in the encrypted partitions of a frame of
+// |size| bytes split at |offsets|.
+size_t EncryptedPartitionsSize(const std::vector<uint32_t>& offsets,
+                               size_t size);
+
+// Class to encrypt data for one WebM stream according to the WebM encryption
+// RFC specification.
+// http://wiki.webmproject.org/encryption/webm-encryption-rfc
+class EncryptModule {
+ public:
+  static const size_t kDefaultContentIDSize = 16;
+  static const size_t kIVSize = 8;
+  static const size_t kKeySize = 16;
+  static const size_t kSHA1DigestSize = 20;
+  static const size_t kSignalByteSize = 1;
+  static const size_t kNumPartitionsSize = 1;
+  static const size_t kPartitionOffsetSize = 4;
+  static const size_t kMaxPartitions = 255;
+  static const uint8_t kEncryptedFrame = 0x1;
+  static const uint8_t kPartitionedFrame = 0x2;
+
+  // |enc| Encryption settings for a stream. |secret| Encryption key for a
+  // stream.
+  EncryptModule(const EncryptionSettings& enc, const std::string& secret);
+  ~EncryptModule() {}
+
+  // Initializes encryption key. Returns true on success.
+  bool Init();
+
+  // Processes |source| according to the encryption settings,
+  // |encrypt_frame|, and |key_|. |size| is the size of |source| in bytes.
+  // |encrypt_frame| tells the encryptor whether to encrypt the frame or just
+  // add a signal byte to the unencrypted frame. |destination| is a caller
+  // owned buffer that must hold at least MaxProcessedSize(|size|, 0) bytes.
+  // It receives signal byte + IV + encrypted |source| if |encrypt_frame| is
+  // true and signal byte + |source| if |encrypt_frame| is false.
+  // |destination_size| is the number of bytes written to |destination|.
+  // Returns true if |source| was processed and passed back through
+  // |destination|.
+  bool ProcessData(const uint8_t* source, size_t size,
+                   bool encrypt_frame,
+                   uint8_t* destination, size_t* destination_size);
+
+  // Same as ProcessData() except the frame is encrypted with |iv|, which must
+  // have been returned by ReserveIV(), and |key_schedule|, which must have
+  // been returned by KeySchedule() if the frame is encrypted. If |partitions|
+  // is not empty an encrypted frame is written in the partitioned format:
+  // signal byte + IV + partition count + partition offsets + partially
+  // encrypted |source|, and |destination| must hold
+  // MaxProcessedSize(|size|, |partitions.size()|) bytes. Does not modify the
+  // object, so frames may be processed concurrently and out of order.
+  bool ProcessDataWithIV(const uint8_t* source, size_t size,
+                         bool encrypt_frame, uint64_t iv,
+                         const AesCtr128Encryptor* key_schedule,
+                         const std::vector<uint32_t>& partitions,
+                         uint8_t* destination, size_t* destination_size) const;
+
+  // Returns the key schedule of |key_period| for ProcessDataWithIV(), or
+  // NULL on error or if the stream is not encrypted. Not thread safe; the
+  // key schedule is valid for the life of the object.
+  const AesCtr128Encryptor* KeySchedule(size_t key_period);
+
+  // Returns the IV ProcessData() would use for the next frame. The IV is
+  // consumed only if the frame will be encrypted. |encrypt_frame| is the
+  // value that will be passed to ProcessDataWithIV().
+  uint64_t ReserveIV(bool encrypt_frame);
+
+  void set_do_not_encrypt(bool flag) { do_not_encrypt_ = flag; }
+
+  // Returns the number of key periods up to the last one used.
+  size_t num_key_periods() const { return key_schedules_.num_key_periods(); }
+
+  // Sets the key period used by ProcessData().
+  void set_key_period(size_t period) { key_period_ = period; }
+
+  // Returns the largest number of bytes ProcessData() will write for a frame
+  // of |size| bytes split into |num_partitions| partition offsets.
+  static size_t MaxProcessedSize(size_t size, size_t num_partitions) {
+    const size_t partitions_size =
+        num_partitions > 0 ?
+        kNumPartitionsSize + num_partitions * kPartitionOffsetSize : 0;
+    return kSignalByteSize + kIVSize + partitions_size + size;
+  }
+
+  // Generates a 16 byte CTR Counter Block. The format is
+  // | iv | block counter |. |iv| is an 8 byte CTR IV. |counter_block| is an
+  // output buffer of kKeySize bytes that receives the Counter Block.
+  static void GenerateCounterBlock(const uint8_t* iv, uint8_t* counter_block);
+
+ private:
+  // Flag telling if the class should not encrypt the data. This should
+  // only be used for testing.
+  bool do_not_encrypt_;
+
+  // Encryption settings for the stream.
+  const EncryptionSettings enc_;
+
+  // Encryption key for the stream.
+  std::string key_;
+
+  // The next IV.
+  uint64_t next_iv_;
+
+  // Key period used by ProcessData().
+  size_t key_period_;
+
+  // Encryption class for each key period used.
+  KeySchedules key_schedules_;
+};
+
+// Class to decrypt data for one WebM stream according to the WebM encryption
+// RFC specification.
+class DecryptModule {
+ public:
+  // TODO(fgalligan) Remove the no_decrypt parameter.
+  // |enc| Encryption settings for a stream. |secret| Decryption key for a
+  // stream. |no_decrypt| If true do not decrypt the stream.
+  DecryptModule(const EncryptionSettings& enc,
+                const std::string& secret,
+                bool no_decrypt);
+  ~DecryptModule() {}
+
+  // Initializes and Checks the one time decryption data. Returns true on
+  // success.
+  bool Init();
+
+  // Decrypts |source| according to the encryption settings and encryption key.
+  // |length| is the size of |source| in bytes. |destination| is a caller
+  // owned buffer of at least |length| bytes that receives the decrypted data
+  // if |source| was decrypted. If data was unencrypted then |destination| is
+  // the original data. Returns true if |data| was decrypted and passed back
+  // through |destination|. |key_schedule| is the key schedule of the frame's
+  // key period returned by KeySchedule(); it is only used if the frame is
+  // encrypted.
+  // Does not modify the object, so frames may be decrypted concurrently.
+  bool DecryptData(const uint8_t* data, size_t length,
+                   const AesCtr128Encryptor* key_schedule,
+                   uint8_t* destination, size_t *destination_size) const;
+
+  // Returns the key schedule of |key_period| for DecryptData(), or NULL on
+  // error or if the stream is not decrypted. Not thread safe; the key
+  // schedule is valid for the life of the object.
+  const AesCtr128Encryptor* KeySchedule(size_t key_period);
+
+ private:
+  // Flag telling if the class should not decrypt the data. This should
+  // only be used for testing.
+  const bool do_not_decrypt_;
+
+  // Encryption settings for the stream.
+  const EncryptionSettings enc_;
+
+  // Encryption key for the stream.
+  std::string key_;
+
+  // Decryption class for each key period used.
+  KeySchedules key_schedules_;
+};
+
+}  // namespace webm_crypt
+
+#endif  // WEBM_CRYPT_ENCRYPT_MODULE_H_
@@ -0,0 +1,385 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vpx_frame_partitions.h"
+
+#include <cstring>
+
+namespace webm_crypt {
+
+namespace {
+
+const int kVp8InterFrameHeaderSize = 3;
+const int kVp8KeyFrameHeaderSize = 10;
+const uint8_t kVp8StartCode[] = { 0x9d, 0x01, 0x2a };
+
+const int kVp9FrameMarker = 2;
+const int kVp9SyncCode = 0x498342;
+const int kVp9CsRgb = 7;
+const int kVp9MaxTileWidthB64 = 64;
+const int kVp9MinTileWidthB64 = 4;
+const int kVp9SegLvlMax = 4;
+const int kVp9SegmentFeatureBits[kVp9SegLvlMax] = { 8, 6, 2, 0 };
+const bool kVp9SegmentFeatureSigned[kVp9SegLvlMax] = { true, true, false,
+                                                       false };
+
+// Class to read bits MSB first from a buffer. Reads past the end of the
+// buffer return 0 and set the overrun flag, so callers only check for errors
+// once.
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t size)
+      : data_(data),
+        size_(size),
+        bit_offset_(0),
+        overrun_(false) {
+  }
+
+  // Returns the next |num_bits| bits. |num_bits| must be <= 24.
+  int ReadBits(int num_bits) {
+    int value = 0;
+    for (int i = 0; i < num_bits; ++i) {
+      const size_t byte_offset = bit_offset_ >> 3;
+      if (byte_offset >= size_) {
+        overrun_ = true;
+        return 0;
+      }
+      const int bit = (data_[byte_offset] >> (7 - (bit_offset_ & 7))) & 1;
+      value = (value << 1) | bit;
+      ++bit_offset_;
+    }
+    return value;
+  }
+
+  // Returns the number of bytes read, including a partially read byte.
+  size_t bytes_read() const { return (bit_offset_ + 7) >> 3; }
+  bool overrun() const { return overrun_; }
+
+ private:
+  const uint8_t* const data_;
+  const size_t size_;
+  size_t bit_offset_;
+  bool overrun_;
+};
+
+void ReadVp9ColorConfig(int profile, BitReader* reader) {
+  if (profile >= 2)
+    reader->ReadBits(1);  // ten_or_twelve_bit
+  const int color_space = reader->ReadBits(3);
+  if (color_space != kVp9CsRgb) {
+    reader->ReadBits(1);  // color_range
+    if (profile == 1 || profile == 3)
+      reader->ReadBits(3);  // subsampling_x, subsampling_y, reserved_zero
+  } else if (profile == 1 || profile == 3) {
+    reader->ReadBits(1);  // reserved_zero
+  }
+}
+
+// Returns the frame width.
+int ReadVp9FrameSize(BitReader* reader) {
+  const int width = reader->ReadBits(16) + 1;
+  reader->ReadBits(16);  // frame_height_minus_1
+  return width;
+}
+
+void ReadVp9RenderSize(BitReader* reader) {
+  if (reader->ReadBits(1)) {
+    reader->ReadBits(16);  // render_width_minus_1
+    reader->ReadBits(16);  // render_height_minus_1
+  }
+}
+
+void ReadVp9LoopFilterParams(BitReader* reader) {
+  reader->ReadBits(6);  // filter_level
+  reader->ReadBits(3);  // sharpness
+  if (reader->ReadBits(1) && reader->ReadBits(1)) {
+    // loop_filter_ref_deltas
+    for (int i = 0; i < 4; ++i) {
+      if (reader->ReadBits(1))
+        reader->ReadBits(7);
+    }
+    // loop_filter_mode_deltas
+    for (int i = 0; i < 2; ++i) {
+      if (reader->ReadBits(1))
+        reader->ReadBits(7);
+    }
+  }
+}
+
+void ReadVp9QuantizationParams(BitReader* reader) {
+  reader->ReadBits(8);  // base_q_idx
+  // delta_q_y_dc, delta_q_uv_dc and delta_q_uv_ac.
+  for (int i = 0; i < 3; ++i) {
+    if (reader->ReadBits(1))
+      reader->ReadBits(5);
+  }
+}
+
+void ReadVp9SegmentationParams(BitReader* reader) {
+  if (!reader->ReadBits(1))
+    return;
+
+  if (reader->ReadBits(1)) {
+    // segmentation_tree_probs
+    for (int i = 0; i < 7; ++i) {
+      if (reader->ReadBits(1))
+        reader->ReadBits(8);
+    }
+    // segmentation_pred_prob
+    if (reader->ReadBits(1)) {
+      for (int i = 0; i < 3; ++i) {
+        if (reader->ReadBits(1))
+          reader->ReadBits(8);
+      }
+    }
+  }
+
+  if (reader->ReadBits(1)) {
+    reader->ReadBits(1);  // segmentation_abs_or_delta_update
+    for (int i = 0; i < 8; ++i) {
+      for (int j = 0; j < kVp9SegLvlMax; ++j) {
+        if (reader->ReadBits(1)) {
+          reader->ReadBits(kVp9SegmentFeatureBits[j]);
+          if (kVp9SegmentFeatureSigned[j])
+            reader->ReadBits(1);
+        }
+      }
+    }
+  }
+}
+
+void ReadVp9TileInfo(int width, BitReader* reader) {
+  const int mi_cols = (width + 7) >> 3;
+  const int sb64_cols = (mi_cols + 7) >> 3;
+
+  int min_log2_tile_cols = 0;
+  while ((kVp9MaxTileWidthB64 << min_log2_tile_cols) < sb64_cols)
+    ++min_log2_tile_cols;
+  int max_log2_tile_cols = 1;
+  while ((sb64_cols >> max_log2_tile_cols) >= kVp9MinTileWidthB64)
+    ++max_log2_tile_cols;
+  --max_log2_tile_cols;
+
+  int tile_cols_log2 = min_log2_tile_cols;
+  while (tile_cols_log2 < max_log2_tile_cols && reader->ReadBits(1))
+    ++tile_cols_log2;
+
+  if (reader->ReadBits(1))
+    reader->ReadBits(1);  // increment_tile_rows_log2
+}
+
+// Adds the partition boundary |offset| to |offsets|. An offset equal to the
+// previous one would leave an empty partition, so the two partitions around
+// it are merged instead.
+void AddPartitionOffset(uint32_t offset, std::vector<uint32_t>* offsets) {
+  if (!offsets->empty() && offsets->back() == offset)
+    offsets->pop_back();
+  else
+    offsets->push_back(offset);
+}
+
+}  // namespace
+
+VpxFramePartitioner::VpxFramePartitioner(Codec codec) : codec_(codec) {
+  memset(ref_frame_width_, 0, sizeof(ref_frame_width_));
+}
+
+VpxFramePartitioner::Codec VpxFramePartitioner::CodecFromId(
+    const std::string& codec_id) {
+  if (codec_id == "V_VP8")
+    return kVP8;
+  if (codec_id == "V_VP9")
+    return kVP9;
+  return kUnknown;
+}
+
+bool VpxFramePartitioner::GetPartitions(const uint8_t* frame, size_t size,
+                                        std::vector<uint32_t>* offsets) {
+  if (!frame || size == 0 || !offsets || size > UINT32_MAX)
+    return false;
+  offsets->clear();
+
+  if (codec_ == kVP8) {
+    size_t header_size = 0;
+    if (!GetVp8HeaderSize(frame, size, &header_size))
+      return false;
+    AddPartitionOffset(static_cast<uint32_t>(header_size), offsets);
+  } else if (codec_ == kVP9) {
+    // A superframe holds several frames followed by an index of the frame
+    // sizes. The index is left in the clear.
+    size_t frame_sizes[8];
+    int num_frames = 0;
+    size_t frames_size = size;
+    const uint8_t marker = frame[size - 1];
+    if ((marker & 0xe0) == 0xc0) {
+      const int frames_in_index = (marker & 0x7) + 1;
+      const int size_bytes = ((marker >> 3) & 0x3) + 1;
+      const size_t index_size = 2 + size_bytes * frames_in_index;
+      if (size >= index_size && frame[size - index_size] == marker) {
+        const uint8_t* index = frame + size - index_size + 1;
+        size_t total_size = 0;
+        for (int i = 0; i < frames_in_index; ++i) {
+          size_t frame_size = 0;
+          for (int j = 0; j < size_bytes; ++j)
+            frame_size |= static_cast<size_t>(*index++) << (j * 8);
+          frame_sizes[num_frames++] = frame_size;
+          total_size += frame_size;
+        }
+        if (total_size > size - index_size)
+          return false;
+        frames_size = size - index_size;
+      }
+    }
+    if (num_frames == 0)
+      frame_sizes[num_frames++] = size;
+
+    size_t frame_offset = 0;
+    for (int i = 0; i < num_frames; ++i) {
+      size_t header_size = 0;
+      if (frame_sizes[i] > 0 &&
+          !GetVp9HeaderSize(frame + frame_offset, frame_sizes[i],
+                            &header_size)) {
+        offsets->clear();
+        return false;
+      }
+      AddPartitionOffset(static_cast<uint32_t>(frame_offset + header_size),
+                         offsets);
+      frame_offset += frame_sizes[i];
+      AddPartitionOffset(static_cast<uint32_t>(frame_offset), offsets);
+    }
+    if (frame_offset < frames_size)
+      AddPartitionOffset(static_cast<uint32_t>(frames_size), offsets);
+  } else {
+    return false;
+  }
+
+  // Drop a trailing empty clear partition.
+  if (!offsets->empty() && offsets->back() == size)
+    offsets->pop_back();
+  return true;
+}
+
+bool VpxFramePartitioner::GetVp8HeaderSize(const uint8_t* frame, size_t size,
+                                           size_t* header_size) const {
+  const bool key_frame = !(frame[0] & 0x1);
+  if (key_frame) {
+    if (size < kVp8KeyFrameHeaderSize ||
+        memcmp(frame + kVp8InterFrameHeaderSize, kVp8StartCode,
+               sizeof(kVp8StartCode))) {
+      return false;
+    }
+    *header_size = kVp8KeyFrameHeaderSize;
+  } else {
+    if (size < kVp8InterFrameHeaderSize)
+      return false;
+    *header_size = kVp8InterFrameHeaderSize;
+  }
+  return true;
+}
+
+bool VpxFramePartitioner::GetVp9HeaderSize(const uint8_t* frame, size_t size,
+                                           size_t* header_size) {
+  BitReader reader(frame, size);
+  if (reader.ReadBits(2) != kVp9FrameMarker)
+    return false;
+
+  const int profile_low_bit = reader.ReadBits(1);
+  const int profile = (reader.ReadBits(1) << 1) | profile_low_bit;
+  if (profile == 3)
+    reader.ReadBits(1);  // reserved_zero
+
+  if (reader.ReadBits(1)) {
+    // show_existing_frame. The frame is only a header.
+    reader.ReadBits(3);  // frame_to_show_map_idx
+    if (reader.overrun())
+      return false;
+    *header_size = size;
+    return true;
+  }
+
+  const bool key_frame = reader.ReadBits(1) == 0;
+  const int show_frame = reader.ReadBits(1);
+  const int error_resilient_mode = reader.ReadBits(1);
+
+  int width = 0;
+  int refresh_frame_flags = 0;
+  if (key_frame) {
+    if (reader.ReadBits(24) != kVp9SyncCode)
+      return false;
+    ReadVp9ColorConfig(profile, &reader);
+    width = ReadVp9FrameSize(&reader);
+    ReadVp9RenderSize(&reader);
+    refresh_frame_flags = 0xff;
+  } else {
+    const int intra_only = show_frame ? 0 : reader.ReadBits(1);
+    if (!error_resilient_mode)
+      reader.ReadBits(2);  // reset_frame_context
+
+    if (intra_only) {
+      if (reader.ReadBits(24) != kVp9SyncCode)
+        return false;
+      if (profile > 0)
+        ReadVp9ColorConfig(profile, &reader);
+      refresh_frame_flags = reader.ReadBits(8);
+      width = ReadVp9FrameSize(&reader);
+      ReadVp9RenderSize(&reader);
+    } else {
+      refresh_frame_flags = reader.ReadBits(8);
+      int ref_frame_idx[3];
+      for (int i = 0; i < 3; ++i) {
+        ref_frame_idx[i] = reader.ReadBits(3);
+        reader.ReadBits(1);  // ref_frame_sign_bias
+      }
+
+      // frame_size_with_refs
+      bool found_ref = false;
+      for (int i = 0; i < 3 && !found_ref; ++i) {
+        if (reader.ReadBits(1)) {
+          width = ref_frame_width_[ref_frame_idx[i]];
+          found_ref = true;
+        }
+      }
+      if (!found_ref)
+        width = ReadVp9FrameSize(&reader);
+      else if (width == 0)
+        return false;  // The reference frame was not seen.
+      ReadVp9RenderSize(&reader);
+
+      reader.ReadBits(1);  // allow_high_precision_mv
+      if (!reader.ReadBits(1))
+        reader.ReadBits(2);  // raw_interpolation_filter
+    }
+  }
+
+  if (!error_resilient_mode) {
+    reader.ReadBits(1);  // refresh_frame_context
+    reader.ReadBits(1);  // frame_parallel_decoding_mode
+  }
+  reader.ReadBits(2);  // frame_context_idx
+
+  ReadVp9LoopFilterParams(&reader);
+  ReadVp9QuantizationParams(&reader);
+  ReadVp9SegmentationParams(&reader);
+  ReadVp9TileInfo(width, &reader);
+
+  const size_t compressed_header_size = reader.ReadBits(16);
+  if (reader.overrun() || compressed_header_size == 0)
+    return false;
+  if (reader.bytes_read() + compressed_header_size > size)
+    return false;
+
+  for (int i = 0; i < kNumRefFrames; ++i) {
+    if (refresh_frame_flags & (1 << i))
+      ref_frame_width_[i] = width;
+  }
+
+  *header_size = reader.bytes_read();
+  return true;
+}
+
+}  // namespace webm_crypt
@@ -0,0 +1,80 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef WEBM_CRYPT_VPX_FRAME_PARTITIONS_H_
+#define WEBM_CRYPT_VPX_FRAME_PARTITIONS_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "webm_tools_types.h"
+
+namespace webm_crypt {
+
+// Class to compute the partitions of a VP8 or VP9 frame for partitioned
+// encryption. The uncompressed frame headers are left in the clear, so they
+// can be inspected without decrypting, and the rest of the frame is
+// encrypted.
+//
+// Partitions are returned as the list of offsets written in the WebM
+// partitioned encryption format. Partitions alternate between clear and
+// encrypted starting with a clear partition, so offsets |{ 10 }| mean bytes
+// [0, 10) are clear and bytes [10, frame size) are encrypted.
+//
+// VP9 headers depend on the frame sizes of the reference frames, so frames
+// must be passed to GetPartitions() in decode order.
+class VpxFramePartitioner {
+ public:
+  enum Codec {
+    kUnknown,
+    kVP8,
+    kVP9,
+  };
+
+  explicit VpxFramePartitioner(Codec codec);
+  ~VpxFramePartitioner() {}
+
+  // Returns the codec of the Matroska |codec_id|.
+  static Codec CodecFromId(const std::string& codec_id);
+
+  // Computes the partitions of |frame|. |size| is the size of |frame| in
+  // bytes. |offsets| is cleared and receives the partition offsets. Returns
+  // false if |frame| could not be parsed, in which case the frame should be
+  // encrypted whole.
+  bool GetPartitions(const uint8_t* frame, size_t size,
+                     std::vector<uint32_t>* offsets);
+
+  Codec codec() const { return codec_; }
+
+ private:
+  static const int kNumRefFrames = 8;
+
+  // Sets |header_size| to the size of the VP8 uncompressed data chunk.
+  bool GetVp8HeaderSize(const uint8_t* frame, size_t size,
+                        size_t* header_size) const;
+
+  // Sets |header_size| to the size in bytes of the VP9 uncompressed header
+  // of |frame| and updates |ref_frame_width_|. |header_size| is equal to
+  // |size| for frames that only show an existing frame.
+  bool GetVp9HeaderSize(const uint8_t* frame, size_t size,
+                        size_t* header_size);
+
+  const Codec codec_;
+
+  // Frame width of each VP9 reference frame slot. The width sets the
+  // number of tile column bits in the uncompressed header.
+  int ref_frame_width_[kNumRefFrames];
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(VpxFramePartitioner);
+};
+
+}  // namespace webm_crypt
+
+#endif  // WEBM_CRYPT_VPX_FRAME_PARTITIONS_H_
@@ -6,18 +6,32 @@
 // in the file PATENTS.  All contributing project authors may
 // be found in the AUTHORS file in the root of the source tree.
 
+#include <inttypes.h>
 #include <stdint.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "aes_ctr.h"
+#include "encrypt_module.h"
 #include "mkvmuxer/mkvmuxer.h"
 #include "mkvmuxer/mkvmuxerutil.h"
 #include "mkvmuxer/mkvwriter.h"
 #include "mkvparser/mkvparser.h"
 #include "mkvparser/mkvreader.h"
+#include "vpx_frame_partitions.h"
+#include "webm_bounded_queue.h"
 #include "webm_constants.h"
 #include "webm_endian.h"
 
@@ -29,36 +43,14 @@ namespace {
 using mkvparser::ContentEncoding;
 using std::string;
 using std::unique_ptr;
+using webm_crypt::DecryptModule;
+using webm_crypt::EncryptionSettings;
+using webm_crypt::EncryptModule;
+using webm_crypt::EncryptedPartitionsSize;
+using webm_crypt::KeyPeriodForFrame;
 
 const char WEBM_CRYPT_VERSION_STRING[] = "0.3.1.0";
 
-// Struct to hold encryption settings for a single WebM stream.
-struct EncryptionSettings {
-  EncryptionSettings()
-      : base_secret_file(),
-        cipher_mode("CTR"),
-        content_id(),
-        initial_iv(0),
-        unencrypted_range(0) {
-  }
-
-  // Path to a file which holds the base secret.
-  string base_secret_file;
-
-  // AES encryption algorithm. Currently only "CTR" is supported.
-  string cipher_mode;
-
-  // WebM Content ID element.
-  string content_id;
-
-  // Initial Initialization Vector for encryption.
-  uint64_t initial_iv;
-
-  // Do not encrypt frames that have a start time less than
-  // |unencrypted_range| in milliseconds.
-  int64_t unencrypted_range;
-};
-
 // Struct to hold file wide encryption settings.
 struct WebMCryptSettings {
   WebMCryptSettings()
@@ -68,6 +60,9 @@ struct WebMCryptSettings {
         audio(false),
         no_encryption(false),
         match_src_clusters(false),
+        decrypt(false),
+        verify_source(),
+        num_threads(1),
         aud_enc(),
         vid_enc() {
   }
@@ -91,6 +86,18 @@ struct WebMCryptSettings {
   // Flag telling app to match the placement of the source WebM Clusters.
   bool match_src_clusters;
 
+  // Flag telling if the file should be decrypted instead of encrypted.
+  bool decrypt;
+
+  // Path to the source file of an encrypted input. If set the input is
+  // decrypted and compared with the source instead of writing an output
+  // file.
+  string verify_source;
+
+  // Number of threads used to encrypt or decrypt frames. Output does not
+  // depend on the number of threads.
+  int num_threads;
+
   // Encryption settings for the audio stream.
   EncryptionSettings aud_enc;
 
@@ -98,266 +105,483 @@ struct WebMCryptSettings {
   EncryptionSettings vid_enc;
 };
 
-// Class to encrypt data for one WebM stream according to the WebM encryption
-// RFC specification.
-// http://wiki.webmproject.org/encryption/webm-encryption-rfc
-class EncryptModule {
+// Growable byte buffer that keeps its capacity across frames. Used by the
+// frame loops so that memory is only allocated when a frame is larger than
+// every frame processed before it.
+class FrameBuffer {
  public:
-  static const size_t kDefaultContentIDSize = 16;
-  static const size_t kIVSize = 8;
-  static const size_t kKeySize = 16;
-  static const size_t kSHA1DigestSize = 20;
-  static const size_t kSignalByteSize = 1;
-  static const uint8_t kEncryptedFrame = 0x1;
-
-  // |enc| Encryption settings for a stream. |secret| Encryption key for a
-  // stream.
-  EncryptModule(const EncryptionSettings& enc, const string& secret);
-  ~EncryptModule() {}
-
-  // Initializes encryption key. Returns true on success.
-  bool Init();
-
-  // Processes |source| according to the encryption settings,
-  // |encrypt_frame|, and |key_|. |length| is the size of |source| in bytes.
-  // |encrypt_frame| tells the encryptor whether to encrypt the frame or just
-  // add a signal byte to the unencrypted frame. |destination| is the returned
-  // encrypted data if |encrypt_frame| is true and signal byte + |source|
-  // if |encrypt_frame| is false. |destination_size| is the size of |destination|
-  // in bytes. Returns true if |source| was processed and passed back
-  // through |destination|.
-  bool ProcessData(const uint8_t* source, size_t size,
-                   bool encrypt_frame,
-                   uint8_t** destination, size_t* destination_size);
-
-  void set_do_not_encrypt(bool flag) { do_not_encrypt_ = flag; }
-
-  // Generates a 16 byte CTR Counter Block. The format is
-  // | iv | block counter |. |iv| is an 8 byte CTR IV. |counter_block| is an
-  // output string containing the Counter Block. Returns true on success.
-  static bool GenerateCounterBlock(const string& iv, string* counter_block);
-
- private:
-  // Flag telling if the class should not encrypt the data. This should
-  // only be used for testing.
-  bool do_not_encrypt_;
-
-  // Encryption settings for the stream.
-  const EncryptionSettings enc_;
+  FrameBuffer() : capacity_(0) {}
+  ~FrameBuffer() {}
+
+  // Makes sure the buffer can hold at least |size| bytes. The contents of the
+  // buffer are not preserved when it grows. Returns false on allocation
+  // failure.
+  bool Reserve(size_t size);
+
+  // Exchanges the memory of this buffer and |other| without copying.
+  void Swap(FrameBuffer* other) {
+    data_.swap(other->data_);
+    std::swap(capacity_, other->capacity_);
+  }
 
-  // Encryption key for the stream.
-  string key_;
+  uint8_t* data() const { return data_.get(); }
+  size_t capacity() const { return capacity_; }
 
-  // The next IV.
-  uint64_t next_iv_;
+ private:
+  unique_ptr<uint8_t[]> data_;
+  size_t capacity_;
 };
 
-EncryptModule::EncryptModule(const EncryptionSettings& enc,
-                             const string& secret)
-    : do_not_encrypt_(false),
-      enc_(enc),
-      next_iv_(enc.initial_iv) {
-  key_.assign(secret);
-}
+bool FrameBuffer::Reserve(size_t size) {
+  if (size <= capacity_)
+    return true;
 
-bool EncryptModule::Init() {
-  if (key_.size() == 0) {
-    fprintf(stderr, "Error creating encryption key.\n");
+  data_.reset(new (std::nothrow) uint8_t[size]);  // NOLINT
+  if (!data_.get()) {
+    capacity_ = 0;
     return false;
   }
+  capacity_ = size;
   return true;
 }
 
-bool EncryptModule::ProcessData(const uint8_t* source, size_t size,
-                                bool encrypt_frame,
-                                uint8_t** destination,
-                                size_t* destination_size) {
-  if (!source || size <= 0)
-    return false;
+// One audio or video frame moving through the read, process and mux stages of
+// a FramePipeline.
+struct FrameJob {
+  FrameJob()
+      : input_data(NULL),
+        input_size(0),
+        output_size(0),
+        cluster(NULL),
+        cluster_index(0),
+        track_type(0),
+        track_num(0),
+        time_ns(0),
+        is_key(false),
+        new_cluster(false),
+        process(false),
+        encrypt(false),
+        iv(0),
+        key_schedule(NULL),
+        reference_size(0),
+        verified(false),
+        sequence(0) {
+  }
 
-  const bool encrypt_the_frame = do_not_encrypt_ ? false : encrypt_frame;
-  unique_ptr<uint8_t[]> cipher_temp;
-  size_t cipher_temp_size = size + kSignalByteSize;
+  // Frame data read from the source file. |input_data| points into |input|,
+  // or into |cluster_data| if the source Cluster was read whole.
+  FrameBuffer input;
+  const uint8_t* input_data;
+  size_t input_size;
 
-  if (encrypt_the_frame) {
-    AesCtr128Encryptor encryptor;
-    if (!encryptor.InitKey(key_)) {
-      fprintf(stderr, "Could not initialize encryptor.\n");
-      return false;
-    }
+  // Source Cluster data shared by the frames of the Cluster. Keeps
+  // |input_data| valid until the frame is reused.
+  std::shared_ptr<const FrameBuffer> cluster_data;
 
-    // Set the IV.
-    const uint64_t iv = next_iv_++;
-    const string iv_str(reinterpret_cast<const char*>(&iv), sizeof(iv));
-    string counter_block;
-    if (!GenerateCounterBlock(iv_str, &counter_block)) {
-      fprintf(stderr, "Could not generate counter block.\n");
-      return false;
-    }
+  // Frame data written by the process stage.
+  FrameBuffer output;
+  size_t output_size;
 
-    if (!encryptor.SetCounter(counter_block)) {
-      fprintf(stderr, "Could not set counter.\n");
-      return false;
-    }
+  // Source Cluster of the frame, and its index in file order.
+  const mkvparser::Cluster* cluster;
+  int64_t cluster_index;
 
-    // Prepend the IV.
-    cipher_temp_size += sizeof(iv);
-    cipher_temp.reset(new (std::nothrow) uint8_t[cipher_temp_size]);  // NOLINT
-    if (!cipher_temp.get())
-      return false;
+  // Source track type. mkvparser::Track::kVideo or mkvparser::Track::kAudio.
+  int64_t track_type;
 
-    memcpy(cipher_temp.get() + kSignalByteSize, &iv, sizeof(iv));
-    if (!encryptor.Encrypt(source, size,
-                           cipher_temp.get() + sizeof(iv) + kSignalByteSize)) {
-      fprintf(stderr, "Could not encrypt data.\n");
-      return false;
-    }
-  } else {
-    cipher_temp.reset(new (std::nothrow) uint8_t[cipher_temp_size]);  // NOLINT
-    if (!cipher_temp.get())
-      return false;
+  // Output track number.
+  uint64_t track_num;
 
-    memcpy(cipher_temp.get() + kSignalByteSize, source, size);
-  }
+  int64_t time_ns;
+  bool is_key;
 
-  const uint8_t signal_byte = encrypt_the_frame ? kEncryptedFrame : 0;
-  cipher_temp[0] = signal_byte;
-  *destination = cipher_temp.release();
-  *destination_size = cipher_temp_size;
-  return true;
-}
+  // Flag telling the mux stage to start a new Cluster with this frame.
+  bool new_cluster;
 
-bool EncryptModule::GenerateCounterBlock(const string& iv,
-                                         string* counter_block) {
-  if (!counter_block || iv.size() != kIVSize)
-    return false;
+  // Flag telling if the frame must go through the process stage. If false
+  // |input| is muxed as is.
+  bool process;
 
-  counter_block->reserve(kKeySize);
-  counter_block->append(iv);
-  counter_block->append(kKeySize - kIVSize, 0);
+  // Flag telling the process stage to encrypt the frame.
+  bool encrypt;
 
-  return true;
-}
+  // IV assigned to the frame by the read stage.
+  uint64_t iv;
+
+  // Key schedule of the frame's key period, set by the read stage so the
+  // process stage never sets up keys. NULL if the frame is not encrypted or
+  // decrypted.
+  const AesCtr128Encryptor* key_schedule;
+
+  // Partition offsets of the frame if it uses partitioned encryption. Empty
+  // if the whole frame is encrypted.
+  std::vector<uint32_t> partitions;
+
+  // Source frame the processed frame is compared against in verify mode.
+  FrameBuffer reference;
+  size_t reference_size;
 
-// Class to decrypt data for one WebM stream according to the WebM encryption
-// RFC specification.
-class DecryptModule {
+  // Flag telling if the frame matched |reference| in verify mode.
+  bool verified;
+
+  // Position of the frame in the source file. Set by FramePipeline.
+  uint64_t sequence;
+};
+
+// Iterates over the audio and video frames of a WebM file in file order.
+class FrameIterator {
  public:
-  // TODO(fgalligan) Remove the no_decrypt parameter.
-  // |enc| Encryption settings for a stream. |secret| Decryption key for a
-  // stream. |no_decrypt| If true do not decrypt the stream.
-  DecryptModule(const EncryptionSettings& enc,
-                const string& secret,
-                bool no_decrypt);
-  ~DecryptModule() {}
-
-  // Initializes and Checks the one time decryption data. Returns true on
-  // success.
-  bool Init();
-
-  // Decrypts |source| according to the encryption settings and encryption key.
-  // |length| is the size of |source| in bytes. |destination| is the returned
-  // decrypted data if |source| was decrypted. If data was unencrypted then
-  // |destination| is the original data. Returns true if |data| was decrypted
-  // and passed back through |destination|.
-  bool DecryptData(const uint8_t* data, size_t length, uint8_t* destination,
-                   size_t *destination_size);
+  // |reader| and |segment| must outlive the FrameIterator.
+  FrameIterator(mkvparser::IMkvReader* reader, mkvparser::Segment* segment);
+  ~FrameIterator() {}
+
+  // Reads the next audio or video frame into |job| and sets the |job| fields
+  // describing the source frame. Returns 1 if a frame was read, 0 at the end
+  // of the file and < 0 on error.
+  int Next(FrameJob* job);
+
+  // Only returns frames of |track_type| if it is not 0.
+  void set_track_type(int64_t track_type) { track_type_ = track_type; }
+
+  // Reads each Cluster with one read and points the frames into the Cluster
+  // data instead of reading every frame into its own buffer.
+  void set_read_clusters(bool read_clusters) {
+    read_clusters_ = read_clusters;
+  }
 
  private:
-  // Flag telling if the class should not decrypt the data. This should
-  // only be used for testing.
-  const bool do_not_decrypt_;
+  // Reads |cluster_| into |cluster_data_|. Leaves |cluster_data_| empty if
+  // the Cluster size is unknown. Returns false on error.
+  bool ReadCluster();
+
+  // Returns a buffer of |cluster_buffers_| no frame refers to anymore, or a
+  // new one added to |cluster_buffers_| if they are all in use. Returns an
+  // empty pointer on allocation failure.
+  std::shared_ptr<FrameBuffer> AcquireClusterBuffer();
+
+  mkvparser::IMkvReader* const reader_;
+  mkvparser::Segment* const segment_;
+
+  // Track type of the frames returned. 0 returns audio and video frames.
+  int64_t track_type_;
 
-  // Encryption settings for the stream.
-  const EncryptionSettings enc_;
+  // Flag telling if Clusters are read whole.
+  bool read_clusters_;
 
-  // Encryption key for the stream.
-  string key_;
+  // Data of |cluster_| if it was read whole.
+  std::shared_ptr<FrameBuffer> cluster_data_;
+  int64_t cluster_data_size_;
 
-  // Decryption class.
-  AesCtr128Encryptor encryptor_;
+  // Buffers Clusters are read into. A buffer is reused once the last frame
+  // of its Cluster has been muxed, so there are only as many buffers as
+  // Clusters with frames in flight.
+  std::vector<std::shared_ptr<FrameBuffer> > cluster_buffers_;
+
+  // Current Cluster. NULL before the first call to Next().
+  const mkvparser::Cluster* cluster_;
+
+  // Index of |cluster_| in file order.
+  int64_t cluster_index_;
+
+  // Current Block within |cluster_|.
+  const mkvparser::BlockEntry* block_entry_;
+
+  // Index of the next frame within |block_entry_|.
+  int frame_index_;
+
+  // Flag telling if all the Clusters have been read.
+  bool end_of_stream_;
 };
 
-DecryptModule::DecryptModule(const EncryptionSettings& enc,
-                             const string& secret,
-                             bool no_decrypt)
-    : do_not_decrypt_(no_decrypt),
-      enc_(enc) {
-  key_.assign(secret);
+FrameIterator::FrameIterator(mkvparser::IMkvReader* reader,
+                             mkvparser::Segment* segment)
+    : reader_(reader),
+      segment_(segment),
+      track_type_(0),
+      read_clusters_(false),
+      cluster_data_size_(0),
+      cluster_(NULL),
+      cluster_index_(-1),
+      block_entry_(NULL),
+      frame_index_(0),
+      end_of_stream_(false) {
 }
 
-bool DecryptModule::Init() {
-  if (key_.size() == 0) {
-    fprintf(stderr, "Error creating encryption key.\n");
-    return false;
-  }
+int FrameIterator::Next(FrameJob* job) {
+  if (!job || !reader_ || !segment_)
+    return -1;
 
-  if (!do_not_decrypt_) {
-    if (!encryptor_.InitKey(key_)) {
-      fprintf(stderr, "Could not initialize decryptor.\n");
-      return false;
+  const mkvparser::Tracks* const parser_tracks = segment_->GetTracks();
+  while (!end_of_stream_) {
+    if (block_entry_ && !block_entry_->EOS()) {
+      const mkvparser::Block* const block = block_entry_->GetBlock();
+      const int64_t trackNum = block->GetTrackNumber();
+      const mkvparser::Track* const parser_track =
+          parser_tracks->GetTrackByNumber(static_cast<uint32_t>(trackNum));
+      const int64_t track_type = parser_track ? parser_track->GetType() : 0;
+
+      if (((track_type == mkvparser::Track::kAudio) ||
+           (track_type == mkvparser::Track::kVideo)) &&
+          (track_type_ == 0 || track_type == track_type_) &&
+          frame_index_ < block->GetFrameCount()) {
+        const mkvparser::Block::Frame& frame = block->GetFrame(frame_index_++);
+
+        if (cluster_data_) {
+          const int64_t offset = frame.pos - cluster_->m_element_start;
+          if (offset < 0 || offset + frame.len > cluster_data_size_)
+            return -1;
+          job->cluster_data = cluster_data_;
+          job->input_data = cluster_data_->data() + offset;
+        } else {
+          job->cluster_data.reset();
+          if (!job->input.Reserve(frame.len))
+            return -1;
+
+          if (frame.Read(reader_, job->input.data()))
+            return -1;
+          job->input_data = job->input.data();
+        }
+
+        job->input_size = frame.len;
+        job->cluster = cluster_;
+        job->cluster_index = cluster_index_;
+        job->track_type = track_type;
+        job->time_ns = block->GetTime(cluster_);
+        job->is_key = block->IsKey();
+        return 1;
+      }
+
+      frame_index_ = 0;
+      if (cluster_->GetNext(block_entry_, block_entry_))
+        return -1;
+      continue;
+    }
+
+    cluster_ = cluster_ ? segment_->GetNext(cluster_) : segment_->GetFirst();
+    if ((cluster_ == NULL) || cluster_->EOS()) {
+      end_of_stream_ = true;
+      break;
     }
+    ++cluster_index_;
+
+    if (cluster_->GetFirst(block_entry_))
+      return -1;
+    frame_index_ = 0;
+
+    if (read_clusters_ && !ReadCluster())
+      return -1;
   }
-  return true;
+
+  return 0;
 }
 
-bool DecryptModule::DecryptData(const uint8_t* source, size_t length,
-                                uint8_t* destination, size_t *destination_size) {
-  if (!source || length <= 0)
+bool FrameIterator::ReadCluster() {
+  // Frames still in flight keep the previous Cluster data alive.
+  cluster_data_.reset();
+  cluster_data_size_ = 0;
+
+  // Parse the whole Cluster so its size is known.
+  const mkvparser::BlockEntry* last_entry = NULL;
+  if (cluster_->GetLast(last_entry) < 0)
     return false;
 
-  size_t offset = 0;
+  const int64_t size = cluster_->GetElementSize();
+  if (size <= 0)
+    return true;
 
-  if (!do_not_decrypt_) {
-    if (length == 0) {
-      fprintf(stderr, "Length of encrypted data is 0.\n");
-      return false;
+  const std::shared_ptr<FrameBuffer> data = AcquireClusterBuffer();
+  if (!data || !data->Reserve(static_cast<size_t>(size)))
+    return false;
+  if (reader_->Read(cluster_->m_element_start, static_cast<long>(size),  // NOLINT
+                    data->data())) {
+    return false;
+  }
+
+  cluster_data_ = data;
+  cluster_data_size_ = size;
+  return true;
+}
+
+std::shared_ptr<FrameBuffer> FrameIterator::AcquireClusterBuffer() {
+  // Only the iterator hands out references to its buffers, so a buffer it
+  // holds the only reference to stays unused.
+  for (size_t i = 0; i < cluster_buffers_.size(); ++i) {
+    if (cluster_buffers_[i].use_count() == 1) {
+      // Orders the reads of the threads that dropped the last frame
+      // references before the next Cluster is read into the buffer.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return cluster_buffers_[i];
     }
-    const uint8_t signal_byte = source[0];
+  }
 
-    if (signal_byte & EncryptModule::kEncryptedFrame) {
-      if (length < EncryptModule::kSignalByteSize + EncryptModule::kIVSize) {
-        fprintf(stderr, "Not enough data to read IV.\n");
-        return false;
-      }
+  std::shared_ptr<FrameBuffer> buffer(
+      new (std::nothrow) FrameBuffer());  // NOLINT
+  if (buffer)
+    cluster_buffers_.push_back(buffer);
+  return buffer;
+}
 
-      const char* iv_data =
-          reinterpret_cast<const char*>(source + EncryptModule::kSignalByteSize);
-      const string iv(iv_data, EncryptModule::kIVSize);
+// Runs frames through three stages: read, process and mux. With one thread
+// every stage runs inline on the calling thread. With more threads the read
+// stage runs on its own thread, frames are processed out of order by a pool
+// of worker threads, and the mux stage runs on the calling thread in source
+// order. The number of frames in flight is bounded, so a slow stage holds
+// back the stages in front of it.
+class FramePipeline {
+ public:
+  // Reads the next frame into |job|. Called from one thread only. Returns 1
+  // if a frame was read, 0 at the end of the stream and < 0 on error.
+  typedef std::function<int(FrameJob* job)> ReadFunc;
 
-      string counter_block;
-      if (!EncryptModule::GenerateCounterBlock(iv, &counter_block)) {
-        fprintf(stderr, "Could not generate counter block.\n");
-        return false;
-      }
+  // Processes |job|. Only called for jobs with |process| set. Must be safe to
+  // call from several threads at once. Returns true on success.
+  typedef std::function<bool(FrameJob* job)> ProcessFunc;
 
-      if (!encryptor_.SetCounter(counter_block)) {
-        fprintf(stderr, "Could not set counter.\n");
-        return false;
+  // Muxes |job|. Called in source order from the calling thread. Returns true
+  // on success.
+  typedef std::function<bool(const FrameJob& job)> MuxFunc;
+
+  // Number of frames in flight per worker thread.
+  static const int kFramesPerThread = 8;
+
+  // |num_threads| is the number of process stage threads.
+  explicit FramePipeline(int num_threads) : num_threads_(num_threads) {}
+  ~FramePipeline() {}
+
+  // Runs all the frames returned by |read| through |process| and |mux|.
+  // Returns true on success.
+  bool Run(const ReadFunc& read, const ProcessFunc& process,
+           const MuxFunc& mux);
+
+ private:
+  // Runs every stage on the calling thread.
+  bool RunSingleThreaded(const ReadFunc& read, const ProcessFunc& process,
+                         const MuxFunc& mux);
+
+  const int num_threads_;
+};
+
+bool FramePipeline::Run(const ReadFunc& read, const ProcessFunc& process,
+                        const MuxFunc& mux) {
+  if (num_threads_ <= 1)
+    return RunSingleThreaded(read, process, mux);
+
+  typedef webm_tools::BoundedQueue<FrameJob*> JobQueue;
+  const size_t queue_depth = num_threads_ * kFramesPerThread;
+  std::vector<FrameJob> jobs(queue_depth);
+  JobQueue free_jobs(queue_depth);
+  JobQueue work(queue_depth);
+  JobQueue done(queue_depth);
+  for (size_t i = 0; i < jobs.size(); ++i)
+    free_jobs.Push(&jobs[i]);
+
+  std::atomic<bool> failed(false);
+  const auto fail = [&]() {
+    failed = true;
+    free_jobs.Close();
+    work.Close();
+    done.Close();
+  };
+
+  // |done| is closed when the reader and all the workers have exited.
+  std::atomic<int> producers(num_threads_ + 1);
+  const auto producer_exit = [&]() {
+    if (--producers == 0)
+      done.Close();
+  };
+
+  std::thread reader([&]() {
+    uint64_t sequence = 0;
+    FrameJob* job = NULL;
+    while (free_jobs.Pop(&job)) {
+      const int status = read(job);
+      if (status < 0) {
+        fail();
+        break;
       }
+      if (status == 0)
+        break;
 
-      offset = EncryptModule::kSignalByteSize + EncryptModule::kIVSize;
+      job->sequence = sequence++;
+      JobQueue& next_stage = job->process ? work : done;
+      if (!next_stage.Push(job))
+        break;
+    }
+    work.Close();
+    producer_exit();
+  });
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_threads_; ++i) {
+    workers.push_back(std::thread([&]() {
+      FrameJob* job = NULL;
+      while (work.Pop(&job)) {
+        if (!process(job)) {
+          fail();
+          break;
+        }
+        if (!done.Push(job))
+          break;
+      }
+      producer_exit();
+    }));
+  }
 
-      if (!encryptor_.Encrypt(source + offset, length - offset, destination)) {
-        fprintf(stderr, "Could not decrypt data.\n");
-        return false;
+  // Mux stage. Frames can arrive out of order, but never more than
+  // |queue_depth| apart, so |pending| is indexed by sequence modulo its size.
+  std::vector<FrameJob*> pending(queue_depth, NULL);
+  uint64_t next_sequence = 0;
+  FrameJob* job = NULL;
+  while (!failed && done.Pop(&job)) {
+    pending[job->sequence % queue_depth] = job;
+
+    FrameJob* ready = pending[next_sequence % queue_depth];
+    while (ready && ready->sequence == next_sequence) {
+      pending[next_sequence % queue_depth] = NULL;
+      if (!mux(*ready)) {
+        fail();
+        break;
       }
-    } else {
-      offset = EncryptModule::kSignalByteSize;
-      memcpy(destination, source + offset, length - offset);
+      ++next_sequence;
+      free_jobs.Push(ready);
+      ready = pending[next_sequence % queue_depth];
     }
-  } else {
-    offset = EncryptModule::kSignalByteSize;
-    memcpy(destination, source + offset, length - offset);
   }
+  if (failed)
+    fail();
+
+  reader.join();
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+
+  return !failed;
+}
+
+bool FramePipeline::RunSingleThreaded(const ReadFunc& read,
+                                      const ProcessFunc& process,
+                                      const MuxFunc& mux) {
+  FrameJob job;
+  for (;;) {
+    const int status = read(&job);
+    if (status < 0)
+      return false;
+    if (status == 0)
+      break;
+
+    if (job.process && !process(&job))
+      return false;
 
-  *destination_size = length - offset;
+    if (!mux(job))
+      return false;
+  }
   return true;
 }
 
 void Usage() {
   printf("Usage: webm_crypt [-test] -i <input> -o <output> [Main options] "
          "[audio options] [video options]\n");
+  printf("       webm_crypt -batch <job file> [-jobs <int>] [Main options] "
+         "[audio options] [video options]\n");
   printf("\n");
   printf("Main options:\n");
   printf("  -h | -?               Show help.\n");
@@ -369,6 +593,19 @@ void Usage() {
   printf("  -no_encryption        Test flag which will not encrypt or\n");
   printf("                        decrypt the data. (Default false)\n");
   printf("  -match_src_clusters   Flag to match source WebM (Default false)\n");
+  printf("  -verify <string>      Path to the source of the encrypted\n");
+  printf("                        input. Decrypts the input and compares\n");
+  printf("                        every frame with the source. No output\n");
+  printf("                        file is written.\n");
+  printf("  -threads <int>        Number of threads used to encrypt or\n");
+  printf("                        decrypt frames. (Default 1)\n");
+  printf("  -batch <string>       Path to a job file. Each line holds the\n");
+  printf("                        -i, -o and other options of one file.\n");
+  printf("                        Options on the command line are the\n");
+  printf("                        defaults of every job. Files sharing a\n");
+  printf("                        base_file share the base secret.\n");
+  printf("  -jobs <int>           Number of batch files processed at the\n");
+  printf("                        same time. (Default 1)\n");
   printf("  \n");
   printf("-audio_options <string> Comma separated name value pair.\n");
   printf("  content_id=<string>   Encryption content ID. (Default empty)\n");
@@ -377,6 +614,19 @@ void Usage() {
   printf("                        empty)\n");
   printf("  unencrypted_range=<int64> Do not encrypt frames from\n");
   printf("                        [0, value) milliseconds (Default value=0)\n");
+  printf("  key_rotation=<int64>  Encrypt each period of value milliseconds\n");
+  printf("                        with its own key derived from the base\n");
+  printf("                        secret. Must also be passed to -decrypt\n");
+  printf("                        and -verify. (Default value=0)\n");
+  printf("  key_rotation_clusters=<int64> Encrypt each period of value\n");
+  printf("                        Clusters with its own key, instead of\n");
+  printf("                        key_rotation. Requires\n");
+  printf("                        -match_src_clusters when encrypting. Must\n");
+  printf("                        also be passed to -decrypt and -verify.\n");
+  printf("                        (Default value=0)\n");
+  printf("  key_period_file=<string> Path to the file receiving the key ID\n");
+  printf("                        and key of each key period. (Default\n");
+  printf("                        output path + .aud_key_periods)\n");
   printf("  \n");
   printf("-video_options <string> Comma separated name value pair.\n");
   printf("  content_id=<string>   Encryption content ID. (Default empty)\n");
@@ -385,6 +635,21 @@ void Usage() {
   printf("                        empty)\n");
   printf("  unencrypted_range=<int64> Do not encrypt frames from\n");
   printf("                        [0, value) milliseconds (Default value=0)\n");
+  printf("  partitioned=<bool>    Leave VP8 and VP9 frame headers in the\n");
+  printf("                        clear. (Default false)\n");
+  printf("  key_rotation=<int64>  Encrypt each period of value milliseconds\n");
+  printf("                        with its own key derived from the base\n");
+  printf("                        secret. Must also be passed to -decrypt\n");
+  printf("                        and -verify. (Default value=0)\n");
+  printf("  key_rotation_clusters=<int64> Encrypt each period of value\n");
+  printf("                        Clusters with its own key, instead of\n");
+  printf("                        key_rotation. Requires\n");
+  printf("                        -match_src_clusters when encrypting. Must\n");
+  printf("                        also be passed to -decrypt and -verify.\n");
+  printf("                        (Default value=0)\n");
+  printf("  key_period_file=<string> Path to the file receiving the key ID\n");
+  printf("                        and key of each key period. (Default\n");
+  printf("                        output path + .vid_key_periods)\n");
 }
 
 void TestEncryption() {
@@ -527,21 +792,87 @@ void TestEncryption() {
   cout << "non_ascii  :" << non_ascii << endl;
   cout << "ciphertext :" << ciphertext << endl;
   cout << "decrypted  :" << decrypted << endl;
+
+  // Partitioned and full frame encryption of a VP8 key frame. The
+  // throughput of both modes is measured by webm_crypt_benchmark.
+  const size_t kFrameSize = 64 * 1024;
+  std::vector<uint8_t> frame(kFrameSize);
+  for (size_t i = 0; i < kFrameSize; ++i)
+    frame[i] = static_cast<uint8_t>(i * 7);
+  const uint8_t kVp8KeyFrameHeader[] = {
+    0x10, 0x02, 0x00, 0x9d, 0x01, 0x2a, 0x80, 0x02, 0xe0, 0x01
+  };
+  memcpy(&frame[0], kVp8KeyFrameHeader, sizeof(kVp8KeyFrameHeader));
+
+  webm_crypt::VpxFramePartitioner partitioner(
+      webm_crypt::VpxFramePartitioner::kVP8);
+  std::vector<uint32_t> partitions;
+  if (!partitioner.GetPartitions(&frame[0], kFrameSize, &partitions)) {
+    fprintf(stderr, "Could not partition VP8 frame.\n");
+    return;
+  }
+
+  EncryptionSettings enc;
+  const string frame_key(reinterpret_cast<const char*>(enc_key),
+                         AES_BLOCK_SIZE);
+  EncryptModule frame_encryptor(enc, frame_key);
+  DecryptModule frame_decryptor(enc, frame_key, false);
+  if (!frame_encryptor.Init() || !frame_decryptor.Init()) {
+    fprintf(stderr, "Could not initialize frame encryptor.\n");
+    return;
+  }
+  const AesCtr128Encryptor* const encrypt_schedule =
+      frame_encryptor.KeySchedule(0);
+  const AesCtr128Encryptor* const decrypt_schedule =
+      frame_decryptor.KeySchedule(0);
+  if (!encrypt_schedule || !decrypt_schedule)
+    return;
+
+  const std::vector<uint32_t> no_partitions;
+  std::vector<uint8_t> encrypted(
+      EncryptModule::MaxProcessedSize(kFrameSize, partitions.size()));
+  std::vector<uint8_t> decrypted_frame(kFrameSize);
+  for (int pass = 0; pass < 2; ++pass) {
+    const bool partitioned = pass == 1;
+    const std::vector<uint32_t>& frame_partitions =
+        partitioned ? partitions : no_partitions;
+    size_t encrypted_size = 0;
+    size_t decrypted_size = 0;
+    if (!frame_encryptor.ProcessDataWithIV(&frame[0], kFrameSize, true, pass,
+                                           encrypt_schedule, frame_partitions,
+                                           &encrypted[0], &encrypted_size)) {
+      fprintf(stderr, "Could not encrypt frame.\n");
+      return;
+    }
+
+    if (!frame_decryptor.DecryptData(&encrypted[0], encrypted_size,
+                                     decrypt_schedule, &decrypted_frame[0],
+                                     &decrypted_size) ||
+        decrypted_size != kFrameSize ||
+        memcmp(&decrypted_frame[0], &frame[0], kFrameSize)) {
+      fprintf(stderr, "Decrypted frame does not match.\n");
+      return;
+    }
+    const bool header_in_clear =
+        !memcmp(&encrypted[encrypted_size - kFrameSize], kVp8KeyFrameHeader,
+                sizeof(kVp8KeyFrameHeader));
+    if (header_in_clear != partitioned) {
+      fprintf(stderr, "Frame header encryption does not match mode.\n");
+      return;
+    }
+
+    printf("Test %d finished. %s\n", 4 + pass,
+           partitioned ? "partitioned" : "full frame");
+  }
   printf("Tests passed.\n");
 }
 
-// Opens and initializes the input and output WebM files. |input| path to the
-// input WebM file. |output| path to the output WebM file. |reader| WebM
-// reader class output parameter. |parser| WebM parser class output parameter.
-// |writer| WebM writer class output parameter. |muxer| WebM muxer class
-// output parameter.
-bool OpenWebMFiles(const string& input,
-                   const string& output,
-                   mkvparser::MkvReader* reader,
-                   unique_ptr<mkvparser::Segment>* parser,
-                   mkvmuxer::MkvWriter* writer,
-                   unique_ptr<mkvmuxer::Segment>* muxer) {
-  if (!reader || !parser || !writer || !muxer)
+// Opens and parses the headers of the WebM file |input|. |reader| WebM reader
+// class output parameter. |parser| WebM parser class output parameter.
+bool OpenWebMFile(const string& input,
+                  mkvparser::MkvReader* reader,
+                  unique_ptr<mkvparser::Segment>* parser) {
+  if (!reader || !parser)
     return false;
 
   if (reader->Open(input.c_str())) {
@@ -569,6 +900,25 @@ bool OpenWebMFiles(const string& input,
     fprintf(stderr, "Segment::Load() failed.");
     return false;
   }
+  return true;
+}
+
+// Opens and initializes the input and output WebM files. |input| path to the
+// input WebM file. |output| path to the output WebM file. |reader| WebM
+// reader class output parameter. |parser| WebM parser class output parameter.
+// |writer| WebM writer class output parameter. |muxer| WebM muxer class
+// output parameter.
+bool OpenWebMFiles(const string& input,
+                   const string& output,
+                   mkvparser::MkvReader* reader,
+                   unique_ptr<mkvparser::Segment>* parser,
+                   mkvmuxer::MkvWriter* writer,
+                   unique_ptr<mkvmuxer::Segment>* muxer) {
+  if (!writer || !muxer)
+    return false;
+
+  if (!OpenWebMFile(input, reader, parser))
+    return false;
 
   const mkvparser::SegmentInfo* const segment_info = (*parser)->GetInfo();
   const int64_t timeCodeScale = segment_info->GetTimeCodeScale();
@@ -733,6 +1083,170 @@ bool OutputDataToFile(const string& filename,
   return true;
 }
 
+// Returns |data| as a lower case hex string.
+string HexString(const string& data) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  string hex;
+  hex.reserve(data.size() * 2);
+  for (size_t i = 0; i < data.size(); ++i) {
+    const uint8_t byte = static_cast<uint8_t>(data[i]);
+    hex.push_back(kHexDigits[byte >> 4]);
+    hex.push_back(kHexDigits[byte & 0xf]);
+  }
+  return hex;
+}
+
+// Writes the key ID and key of each key period of a stream encrypted with
+// |enc| to |enc.key_period_file|, or to |default_name| if no file was set.
+// Each line holds the key period, its start time in milliseconds or, with
+// |enc.key_rotation_clusters|, the index of its first Cluster, the key ID and
+// the key in hex. The key ID of a key period is |content_id| followed by
+// the big endian 32 bit key period. The key periods listed run to the last
+// one used by |module|, and cover |duration_ns| when it is known. Does nothing
+// if |enc| does not have key rotation. Returns true on success.
+bool OutputKeyPeriods(const EncryptionSettings& enc,
+                      const string& default_name,
+                      const string& content_id,
+                      const string& base_secret,
+                      int64_t duration_ns,
+                      const EncryptModule& module) {
+  if (!webm_crypt::HasKeyRotation(enc))
+    return true;
+
+  const string& output_file =
+      enc.key_period_file.empty() ? default_name : enc.key_period_file;
+  FILE* const f = fopen(output_file.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "Could not open file: %s for writing.\n",
+            output_file.c_str());
+    return false;
+  }
+
+  size_t num_key_periods = module.num_key_periods();
+  if (duration_ns >= 0) {
+    num_key_periods = std::max(num_key_periods, webm_crypt::NumKeyPeriods(
+        enc, duration_ns / webm_tools::kNanosecondsPerMillisecond));
+  }
+  bool ok = true;
+  for (size_t i = 0; ok && i < num_key_periods; ++i) {
+    string key;
+    if (!webm_crypt::DeriveKeyPeriodKey(base_secret, i, &key)) {
+      fprintf(stderr, "Could not derive key of key period:%zu\n", i);
+      ok = false;
+      break;
+    }
+
+    string key_id = content_id;
+    for (int shift = 24; shift >= 0; shift -= 8)
+      key_id.push_back(static_cast<char>((i >> shift) & 0xff));
+
+    const int64_t period_start = static_cast<int64_t>(i) *
+        (enc.key_rotation_clusters > 0 ? enc.key_rotation_clusters :
+                                         enc.key_rotation);
+    ok = fprintf(f, "%zu %" PRId64 " %s %s\n", i, period_start,
+                 HexString(key_id).c_str(), HexString(key).c_str()) > 0;
+  }
+
+  if (fclose(f) != 0 || !ok) {
+    fprintf(stderr, "Error writing key periods to file: %s\n",
+            output_file.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Holds the base secrets of the streams processed by the app, so inputs that
+// share a base secret file only read or generate the secret once. Secrets are
+// keyed by the path of the file that holds them. The class is thread safe.
+class BaseSecretCache {
+ public:
+  BaseSecretCache() {}
+  ~BaseSecretCache() {}
+
+  // Returns the base secret for |enc| in |secret|. |default_name| is the file
+  // the secret is output to if |enc.base_secret_file| is empty. Reads or
+  // generates the secret with GetBaseSecret() the first time the file is
+  // seen. Returns true on success.
+  bool GetSecret(const EncryptionSettings& enc,
+                 const string& default_name,
+                 string* secret);
+
+  // Returns the contents of the base secret file |file| in |secret|. Reads
+  // the file the first time it is seen. Returns true on success.
+  bool ReadSecret(const string& file, string* secret);
+
+  // Same as OutputDataToFile() except each file is only output once. Empty
+  // secrets, from streams that were not encrypted, never replace a secret
+  // output by another input.
+  bool OutputSecret(const string& filename,
+                    const string& default_name,
+                    const string& secret);
+
+ private:
+  std::mutex mutex_;
+
+  // Base secrets keyed by file path.
+  std::map<string, string> secrets_;
+
+  // Files already output by OutputSecret() with a non-empty secret.
+  std::set<string> output_files_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(BaseSecretCache);
+};
+
+bool BaseSecretCache::GetSecret(const EncryptionSettings& enc,
+                                const string& default_name,
+                                string* secret) {
+  if (!secret)
+    return false;
+
+  const string& file =
+      enc.base_secret_file.empty() ? default_name : enc.base_secret_file;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, string>::const_iterator iter = secrets_.find(file);
+  if (iter != secrets_.end()) {
+    *secret = iter->second;
+    return true;
+  }
+
+  if (!GetBaseSecret(enc, secret))
+    return false;
+  secrets_[file] = *secret;
+  return true;
+}
+
+bool BaseSecretCache::ReadSecret(const string& file, string* secret) {
+  if (!secret)
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, string>::const_iterator iter = secrets_.find(file);
+  if (iter != secrets_.end()) {
+    *secret = iter->second;
+    return true;
+  }
+
+  if (!ReadDataFromFile(file, secret))
+    return false;
+  secrets_[file] = *secret;
+  return true;
+}
+
+bool BaseSecretCache::OutputSecret(const string& filename,
+                                   const string& default_name,
+                                   const string& secret) {
+  const string& file = filename.empty() ? default_name : filename;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (output_files_.count(file))
+    return true;
+
+  if (!OutputDataToFile(filename, default_name, secret))
+    return false;
+  if (!secret.empty())
+    output_files_.insert(file);
+  return true;
+}
+
 double StringToDouble(const string& s) {
   return strtod(s.c_str(), NULL);
 }
@@ -766,8 +1280,16 @@ void ParseStreamOptions(const string& option_list, EncryptionSettings* enc) {
         enc->initial_iv = strtoull(value.c_str(), NULL, 10);
       } else if (name == "base_file") {
         enc->base_secret_file = value;
+      } else if (name == "partitioned") {
+        enc->partitioned = value == "true";
       } else if (name == "unencrypted_range") {
         enc->unencrypted_range = strtoull(value.c_str(), NULL, 10);
+      } else if (name == "key_rotation") {
+        enc->key_rotation = strtoll(value.c_str(), NULL, 10);
+      } else if (name == "key_rotation_clusters") {
+        enc->key_rotation_clusters = strtoll(value.c_str(), NULL, 10);
+      } else if (name == "key_period_file") {
+        enc->key_period_file = value;
       }
     }
 
@@ -803,8 +1325,14 @@ bool ParseContentEncryption(const ContentEncoding& encoding,
 }
 
 // Function to encrypt a WebM file. |webm_crypt| encryption settings for
-// the source and destination files. Returns 0 on success and <0 for an error.
-int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
+// the source and destination files. |secret_cache| holds the base secrets
+// shared with the other files processed by the app. Returns 0 on success and
+// <0 for an error.
+int WebMEncrypt(const WebMCryptSettings& webm_crypt,
+                BaseSecretCache* secret_cache) {
+  if (!secret_cache)
+    return -1;
+
   mkvparser::MkvReader reader;
   mkvmuxer::MkvWriter writer;
   unique_ptr<mkvparser::Segment> parser_segment;
@@ -827,6 +1355,10 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
   uint64_t aud_track = 0;  // no track added
   string aud_base_secret;
   string vid_base_secret;
+  string aud_content_id;
+  string vid_content_id;
+  webm_crypt::VpxFramePartitioner::Codec video_codec =
+      webm_crypt::VpxFramePartitioner::kUnknown;
 
   while (i != parser_tracks->GetTracksCount()) {
     const int track_num = i++;
@@ -866,6 +1398,8 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
       }
 
       video->set_codec_id(parser_track->GetCodecId());
+      video_codec = webm_crypt::VpxFramePartitioner::CodecFromId(
+          parser_track->GetCodecId());
 
       if (track_name)
         video->set_name(track_name);
@@ -899,12 +1433,15 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
           return -1;
         }
 
-        if (!GetBaseSecret(webm_crypt.vid_enc, &vid_base_secret)) {
+        if (!secret_cache->GetSecret(webm_crypt.vid_enc,
+                                     "vid_base_secret.key",
+                                     &vid_base_secret)) {
           fprintf(stderr, "Error generating base secret.\n");
           return -1;
         }
 
-        string id = webm_crypt.vid_enc.content_id;
+        string& id = vid_content_id;
+        id = webm_crypt.vid_enc.content_id;
         if (id.empty()) {
           // If the content id is empty, create a content id.
           if (!GenerateRandomData(EncryptModule::kDefaultContentIDSize, &id)) {
@@ -991,12 +1528,15 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
           return -1;
         }
 
-        if (!GetBaseSecret(webm_crypt.aud_enc, &aud_base_secret)) {
+        if (!secret_cache->GetSecret(webm_crypt.aud_enc,
+                                     "aud_base_secret.key",
+                                     &aud_base_secret)) {
           fprintf(stderr, "Error generating base secret.\n");
           return -1;
         }
 
-        string id = webm_crypt.aud_enc.content_id;
+        string& id = aud_content_id;
+        id = webm_crypt.aud_enc.content_id;
         if (id.empty()) {
           // If the content id is empty, create a content id.
           if (!GenerateRandomData(EncryptModule::kDefaultContentIDSize, &id)) {
@@ -1016,141 +1556,210 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
   // Set Cues element attributes
   muxer_segment->CuesTrack(vid_track);
 
-  // Write clusters
-  unique_ptr<uint8_t[]> data;
-  int data_len = 0;
+  // Write clusters. The key schedule of a key period is set up when its
+  // first frame is encrypted, so the key periods do not depend on the
+  // Duration, which may be missing or shorter than the frames.
+  const int64_t duration_ns = parser_segment->GetDuration();
   EncryptModule audio_encryptor(webm_crypt.aud_enc, aud_base_secret);
+  audio_encryptor.set_do_not_encrypt(webm_crypt.no_encryption);
   if (webm_crypt.audio && !audio_encryptor.Init()) {
     fprintf(stderr, "Could not initialize audio encryptor.\n");
     return -1;
   }
-  audio_encryptor.set_do_not_encrypt(webm_crypt.no_encryption);
 
   EncryptModule video_encryptor(webm_crypt.vid_enc, vid_base_secret);
+  video_encryptor.set_do_not_encrypt(webm_crypt.no_encryption);
   if (webm_crypt.video && !video_encryptor.Init()) {
     fprintf(stderr, "Could not initialize video encryptor.\n");
     return -1;
   }
-  video_encryptor.set_do_not_encrypt(webm_crypt.no_encryption);
 
+  // Partitions are computed in decode order by the read stage, which VP9
+  // header parsing requires.
+  const bool partition_video = webm_crypt.video &&
+                               webm_crypt.vid_enc.partitioned &&
+                               !webm_crypt.no_encryption;
+  if (partition_video &&
+      video_codec == webm_crypt::VpxFramePartitioner::kUnknown) {
+    fprintf(stderr, "Partitioned encryption is only supported for VP8 and "
+            "VP9. Encrypting whole frames.\n");
+  }
+  webm_crypt::VpxFramePartitioner video_partitioner(video_codec);
+  int64_t video_frames = 0;
+  int64_t partitioned_frames = 0;
+  uint64_t video_bytes = 0;
+  uint64_t encrypted_video_bytes = 0;
+
+  // IVs are assigned in file order by the read stage so the output does not
+  // depend on the order in which the frames are encrypted.
+  FrameIterator frames(&reader, parser_segment.get());
+
+  // When the source Clusters are kept, each Cluster is read with one read and
+  // its frames are muxed and encrypted straight from the Cluster data.
+  frames.set_read_clusters(webm_crypt.match_src_clusters);
   const mkvparser::Cluster* prev_cluster = NULL;
-  const mkvparser::Cluster* cluster = parser_segment->GetFirst();
-  while ((cluster != NULL) && !cluster->EOS()) {
-    const mkvparser::BlockEntry* block_entry;
-    int status = cluster->GetFirst(block_entry);
-    if (status)
-      return -1;
-
-    while ((block_entry != NULL) && !block_entry->EOS()) {
-      const mkvparser::Block* const block = block_entry->GetBlock();
-      const int64_t trackNum = block->GetTrackNumber();
-      const mkvparser::Track* const parser_track =
-          parser_tracks->GetTrackByNumber(static_cast<uint32_t>(trackNum));
-      const int64_t track_type = parser_track->GetType();
-
-      if ((track_type == mkvparser::Track::kAudio) ||
-          (track_type == mkvparser::Track::kVideo)) {
-        const int frame_count = block->GetFrameCount();
-        const int64_t time_ns = block->GetTime(cluster);
-        const int64_t time_milli =
-            time_ns / webm_tools::kNanosecondsPerMillisecond;
-        const bool is_key = block->IsKey();
-
-        for (int i = 0; i < frame_count; ++i) {
-          const mkvparser::Block::Frame& frame = block->GetFrame(i);
-
-          if (frame.len > data_len) {
-            data.reset(new (std::nothrow) uint8_t[frame.len]);  // NOLINT
-            if (!data.get())
-              return -1;
-            data_len = frame.len;
-          }
+  const FramePipeline::ReadFunc read_frame = [&](FrameJob* job) {
+    const int status = frames.Next(job);
+    if (status <= 0)
+      return status;
+
+    job->new_cluster = false;
+    if (webm_crypt.match_src_clusters && prev_cluster != job->cluster) {
+      job->new_cluster = true;
+      prev_cluster = job->cluster;
+    }
 
-          if (frame.Read(&reader, data.get()))
-            return -1;
+    const int64_t time_milli =
+        job->time_ns / webm_tools::kNanosecondsPerMillisecond;
+    job->partitions.clear();
+    job->key_schedule = NULL;
+    const bool audio = job->track_type == mkvparser::Track::kAudio;
+    const EncryptionSettings& enc =
+        audio ? webm_crypt.aud_enc : webm_crypt.vid_enc;
+    EncryptModule& encryptor = audio ? audio_encryptor : video_encryptor;
+    job->track_num = audio ? aud_track : vid_track;
+    job->process = audio ? webm_crypt.audio : webm_crypt.video;
+    job->encrypt = time_milli >= enc.unencrypted_range;
+    if (job->process) {
+      job->iv = encryptor.ReserveIV(job->encrypt);
+      if (job->encrypt && !webm_crypt.no_encryption) {
+        job->key_schedule = encryptor.KeySchedule(
+            KeyPeriodForFrame(enc, time_milli, job->cluster_index));
+        if (!job->key_schedule)
+          return -1;
+      }
+    }
 
-          if (webm_crypt.match_src_clusters && prev_cluster != cluster) {
-            muxer_segment->ForceNewClusterOnNextFrame();
-            prev_cluster = cluster;
-          }
+    if (!audio) {
+      // Every frame is parsed so VP9 reference frame sizes are tracked
+      // through the unencrypted range.
+      if (partition_video &&
+          (!video_partitioner.GetPartitions(job->input_data,
+                                            job->input_size,
+                                            &job->partitions) ||
+           !job->encrypt)) {
+        job->partitions.clear();
+      }
 
-          const uint64_t track_num =
-              (track_type == mkvparser::Track::kAudio) ? aud_track : vid_track;
-
-          if ((track_type == mkvparser::Track::kVideo && webm_crypt.video) ||
-              (track_type == mkvparser::Track::kAudio && webm_crypt.audio) ) {
-            uint8_t* ciphertext;
-            size_t ciphertext_size;
-            const bool encrypt_frame =
-                time_milli >= webm_crypt.aud_enc.unencrypted_range;
-            if (track_type == mkvparser::Track::kAudio) {
-              if (!audio_encryptor.ProcessData(data.get(),
-                                               frame.len,
-                                               encrypt_frame,
-                                               &ciphertext,
-                                               &ciphertext_size)) {
-                fprintf(stderr, "Could not encrypt audio data.\n");
-                return -1;
-              }
-            } else {
-              const bool encrypt_frame =
-                  time_milli >= webm_crypt.vid_enc.unencrypted_range;
-              if (!video_encryptor.ProcessData(data.get(),
-                                               frame.len,
-                                               encrypt_frame,
-                                               &ciphertext,
-                                               &ciphertext_size)) {
-                fprintf(stderr, "Could not encrypt video data.\n");
-                return -1;
-              }
-            }
-
-            if (!muxer_segment->AddFrame(
-                    ciphertext,
-                    ciphertext_size,
-                    track_num,
-                    time_ns,
-                    is_key)) {
-              fprintf(stderr, "Could not add encrypted frame.\n");
-              return -1;
-            }
-          } else {
-            if (!muxer_segment->AddFrame(data.get(),
-                                         frame.len,
-                                         track_num,
-                                         time_ns,
-                                         is_key)) {
-              fprintf(stderr, "Could not add frame.\n");
-              return -1;
-            }
-          }
+      if (job->process && job->encrypt && !webm_crypt.no_encryption) {
+        ++video_frames;
+        video_bytes += job->input_size;
+        if (job->partitions.empty()) {
+          encrypted_video_bytes += job->input_size;
+        } else {
+          ++partitioned_frames;
+          encrypted_video_bytes +=
+              EncryptedPartitionsSize(job->partitions, job->input_size);
         }
       }
+    }
+    return 1;
+  };
+
+  const FramePipeline::ProcessFunc encrypt_frame = [&](FrameJob* job) {
+    const size_t max_size =
+        EncryptModule::MaxProcessedSize(job->input_size,
+                                        job->partitions.size());
+    if (!job->output.Reserve(max_size))
+      return false;
 
-      status = cluster->GetNext(block_entry, block_entry);
-      if (status)
-        return -1;
+    if (job->track_type == mkvparser::Track::kAudio) {
+      if (!audio_encryptor.ProcessDataWithIV(job->input_data,
+                                             job->input_size,
+                                             job->encrypt,
+                                             job->iv,
+                                             job->key_schedule,
+                                             job->partitions,
+                                             job->output.data(),
+                                             &job->output_size)) {
+        fprintf(stderr, "Could not encrypt audio data.\n");
+        return false;
+      }
+    } else {
+      if (!video_encryptor.ProcessDataWithIV(job->input_data,
+                                             job->input_size,
+                                             job->encrypt,
+                                             job->iv,
+                                             job->key_schedule,
+                                             job->partitions,
+                                             job->output.data(),
+                                             &job->output_size)) {
+        fprintf(stderr, "Could not encrypt video data.\n");
+        return false;
+      }
     }
+    return true;
+  };
+
+  const FramePipeline::MuxFunc mux_frame = [&](const FrameJob& job) {
+    if (job.new_cluster)
+      muxer_segment->ForceNewClusterOnNextFrame();
+
+    if (job.process) {
+      if (!muxer_segment->AddFrame(job.output.data(),
+                                   job.output_size,
+                                   job.track_num,
+                                   job.time_ns,
+                                   job.is_key)) {
+        fprintf(stderr, "Could not add encrypted frame.\n");
+        return false;
+      }
+    } else {
+      if (!muxer_segment->AddFrame(job.input_data,
+                                   job.input_size,
+                                   job.track_num,
+                                   job.time_ns,
+                                   job.is_key)) {
+        fprintf(stderr, "Could not add frame.\n");
+        return false;
+      }
+    }
+    return true;
+  };
 
-    cluster = parser_segment->GetNext(cluster);
-  }
+  FramePipeline pipeline(webm_crypt.num_threads);
+  if (!pipeline.Run(read_frame, encrypt_frame, mux_frame))
+    return -1;
 
   muxer_segment->Finalize();
 
+  if (partition_video && video_bytes > 0) {
+    printf("video: %" PRId64 " of %" PRId64 " encrypted frames partitioned, "
+           "%" PRIu64 " of %" PRIu64 " bytes encrypted (%.1f%%)\n",
+           partitioned_frames, video_frames, encrypted_video_bytes,
+           video_bytes, 100.0 * encrypted_video_bytes / video_bytes);
+  }
+
   // Output base secret data.
-  if (!OutputDataToFile(webm_crypt.aud_enc.base_secret_file,
-                        "aud_base_secret.key",
-                        aud_base_secret)) {
+  if (!secret_cache->OutputSecret(webm_crypt.aud_enc.base_secret_file,
+                                  "aud_base_secret.key",
+                                  aud_base_secret)) {
     fprintf(stderr, "Error writing audio base secret to file.\n");
     return -1;
   }
-  if (!OutputDataToFile(webm_crypt.vid_enc.base_secret_file,
-                        "vid_base_secret.key",
-                        vid_base_secret)) {
+  if (!secret_cache->OutputSecret(webm_crypt.vid_enc.base_secret_file,
+                                  "vid_base_secret.key",
+                                  vid_base_secret)) {
     fprintf(stderr, "Error writing video base secret to file.\n");
     return -1;
   }
 
+  // Output the keys of each key period.
+  if (webm_crypt.audio && !webm_crypt.no_encryption &&
+      !OutputKeyPeriods(webm_crypt.aud_enc,
+                        webm_crypt.output + ".aud_key_periods",
+                        aud_content_id, aud_base_secret, duration_ns,
+                        audio_encryptor)) {
+    return -1;
+  }
+  if (webm_crypt.video && !webm_crypt.no_encryption &&
+      !OutputKeyPeriods(webm_crypt.vid_enc,
+                        webm_crypt.output + ".vid_key_periods",
+                        vid_content_id, vid_base_secret, duration_ns,
+                        video_encryptor)) {
+    return -1;
+  }
+
   writer.Close();
   reader.Close();
 
@@ -1158,8 +1767,14 @@ int WebMEncrypt(const WebMCryptSettings& webm_crypt) {
 }
 
 // Function to decrypt a WebM file. |webm_crypt| encryption settings for
-// the source and destination files. Returns 0 on success and <0 for an error.
-int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
+// the source and destination files. |secret_cache| holds the base secrets
+// shared with the other files processed by the app. Returns 0 on success and
+// <0 for an error.
+int WebMDecrypt(const WebMCryptSettings& webm_crypt,
+                BaseSecretCache* secret_cache) {
+  if (!secret_cache)
+    return -1;
+
   mkvparser::MkvReader reader;
   mkvmuxer::MkvWriter writer;
   unique_ptr<mkvparser::Segment> parser_segment;
@@ -1182,6 +1797,11 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
   uint64_t aud_track = 0;  // no track added
   EncryptionSettings aud_enc;
   EncryptionSettings vid_enc;
+  // Key rotation is not stored in the file.
+  aud_enc.key_rotation = webm_crypt.aud_enc.key_rotation;
+  aud_enc.key_rotation_clusters = webm_crypt.aud_enc.key_rotation_clusters;
+  vid_enc.key_rotation = webm_crypt.vid_enc.key_rotation;
+  vid_enc.key_rotation_clusters = webm_crypt.vid_enc.key_rotation_clusters;
   bool decrypt_video = false;
   bool decrypt_audio = false;
   string aud_base_secret;
@@ -1250,8 +1870,8 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
           return -1;
         }
 
-        if (!ReadDataFromFile(webm_crypt.vid_enc.base_secret_file,
-                              &vid_base_secret)) {
+        if (!secret_cache->ReadSecret(webm_crypt.vid_enc.base_secret_file,
+                                      &vid_base_secret)) {
           fprintf(stderr, "Could not read video base secret file:%s\n",
                   webm_crypt.vid_enc.base_secret_file.c_str());
           return -1;
@@ -1324,8 +1944,8 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
           return -1;
         }
 
-        if (!ReadDataFromFile(webm_crypt.aud_enc.base_secret_file,
-                              &aud_base_secret)) {
+        if (!secret_cache->ReadSecret(webm_crypt.aud_enc.base_secret_file,
+                                      &aud_base_secret)) {
           fprintf(stderr, "Could not read audio base secret file:%s\n",
                   webm_crypt.aud_enc.base_secret_file.c_str());
           return -1;
@@ -1339,8 +1959,6 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
   muxer_segment->CuesTrack(vid_track);
 
   // Write clusters
-  unique_ptr<uint8_t[]> data;
-  int data_len = 0;
   DecryptModule audio_decryptor(aud_enc,
                                 aud_base_secret,
                                 webm_crypt.no_encryption);
@@ -1357,95 +1975,83 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
     return -1;
   }
 
-  const mkvparser::Cluster* cluster = parser_segment->GetFirst();
-  while ((cluster != NULL) && !cluster->EOS()) {
-    const mkvparser::BlockEntry* block_entry;
-    int status = cluster->GetFirst(block_entry);
-    if (status)
-      return -1;
-
-    while ((block_entry != NULL) && !block_entry->EOS()) {
-      const mkvparser::Block* const block = block_entry->GetBlock();
-      const int64_t trackNum = block->GetTrackNumber();
-      const mkvparser::Track* const parser_track =
-          parser_tracks->GetTrackByNumber(static_cast<uint32_t>(trackNum));
-      const int64_t track_type = parser_track->GetType();
-
-      if ((track_type == mkvparser::Track::kAudio) ||
-          (track_type == mkvparser::Track::kVideo)) {
-        const int frame_count = block->GetFrameCount();
-        const int64_t time_ns = block->GetTime(cluster);
-        const bool is_key = block->IsKey();
-
-        for (int i = 0; i < frame_count; ++i) {
-          const mkvparser::Block::Frame& frame = block->GetFrame(i);
-
-          if (frame.len > data_len) {
-            data.reset(new (std::nothrow) uint8_t[frame.len]);  // NOLINT
-            if (!data.get())
-              return -1;
-            data_len = frame.len;
-          }
+  FrameIterator frames(&reader, parser_segment.get());
+  const FramePipeline::ReadFunc read_frame = [&](FrameJob* job) {
+    const int status = frames.Next(job);
+    if (status <= 0)
+      return status;
+
+    const int64_t time_milli =
+        job->time_ns / webm_tools::kNanosecondsPerMillisecond;
+    const bool audio = job->track_type == mkvparser::Track::kAudio;
+    job->track_num = audio ? aud_track : vid_track;
+    job->process = audio ? decrypt_audio : decrypt_video;
+    job->key_schedule = NULL;
+    if (job->process && !webm_crypt.no_encryption) {
+      DecryptModule& decryptor = audio ? audio_decryptor : video_decryptor;
+      job->key_schedule = decryptor.KeySchedule(KeyPeriodForFrame(
+          audio ? aud_enc : vid_enc, time_milli, job->cluster_index));
+      if (!job->key_schedule)
+        return -1;
+    }
+    return 1;
+  };
 
-          if (frame.Read(&reader, data.get()))
-            return -1;
+  const FramePipeline::ProcessFunc decrypt_frame = [&](FrameJob* job) {
+    if (!job->output.Reserve(job->input_size))
+      return false;
 
-          const uint64_t track_num =
-              (track_type == mkvparser::Track::kAudio) ? aud_track : vid_track;
-
-          if ((track_type == mkvparser::Track::kVideo && decrypt_video) ||
-              (track_type == mkvparser::Track::kAudio && decrypt_audio) ) {
-            unique_ptr<uint8_t[]> decrypttext(new uint8_t[frame.len]);
-            size_t decrypttext_size = 0;
-            if (track_type == mkvparser::Track::kAudio) {
-              if (!audio_decryptor.DecryptData(data.get(),
-                                               frame.len,
-                                               decrypttext.get(),
-                                               &decrypttext_size)) {
-                fprintf(stderr, "Could not decrypt audio data.\n");
-                return -1;
-              }
-            } else {
-              if (!video_decryptor.DecryptData(data.get(),
-                                               frame.len,
-                                               decrypttext.get(),
-                                               &decrypttext_size)) {
-                fprintf(stderr, "Could not decrypt video data.\n");
-                return -1;
-              }
-            }
-
-            if (decrypttext_size != 0) {
-              if (!muxer_segment->AddFrame(
-                      decrypttext.get(),
-                      decrypttext_size,
-                      track_num,
-                      time_ns,
-                      is_key)) {
-                fprintf(stderr, "Could not add encrypted frame.\n");
-                return -1;
-              }
-            }
-          } else {
-            if (!muxer_segment->AddFrame(data.get(),
-                                         frame.len,
-                                         track_num,
-                                         time_ns,
-                                         is_key)) {
-              fprintf(stderr, "Could not add frame.\n");
-              return -1;
-            }
-          }
+    job->output_size = 0;
+    if (job->track_type == mkvparser::Track::kAudio) {
+      if (!audio_decryptor.DecryptData(job->input_data,
+                                       job->input_size,
+                                       job->key_schedule,
+                                       job->output.data(),
+                                       &job->output_size)) {
+        fprintf(stderr, "Could not decrypt audio data.\n");
+        return false;
+      }
+    } else {
+      if (!video_decryptor.DecryptData(job->input_data,
+                                       job->input_size,
+                                       job->key_schedule,
+                                       job->output.data(),
+                                       &job->output_size)) {
+        fprintf(stderr, "Could not decrypt video data.\n");
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const FramePipeline::MuxFunc mux_frame = [&](const FrameJob& job) {
+    if (job.process) {
+      if (job.output_size != 0) {
+        if (!muxer_segment->AddFrame(job.output.data(),
+                                     job.output_size,
+                                     job.track_num,
+                                     job.time_ns,
+                                     job.is_key)) {
+          fprintf(stderr, "Could not add encrypted frame.\n");
+          return false;
         }
       }
-
-      status = cluster->GetNext(block_entry, block_entry);
-      if (status)
-        return -1;
+    } else {
+      if (!muxer_segment->AddFrame(job.input_data,
+                                   job.input_size,
+                                   job.track_num,
+                                   job.time_ns,
+                                   job.is_key)) {
+        fprintf(stderr, "Could not add frame.\n");
+        return false;
+      }
     }
+    return true;
+  };
 
-    cluster = parser_segment->GetNext(cluster);
-  }
+  FramePipeline pipeline(webm_crypt.num_threads);
+  if (!pipeline.Run(read_frame, decrypt_frame, mux_frame))
+    return -1;
 
   muxer_segment->Finalize();
 
@@ -1454,6 +2060,207 @@ int WebMDecrypt(const WebMCryptSettings& webm_crypt) {
   return 0;
 }
 
+// Function to verify an encrypted WebM file without writing an output file.
+// Each frame of |webm_crypt.input| is decrypted into a scratch buffer and
+// compared with the frame at the same position of the same track type in
+// |webm_crypt.verify_source|. |secret_cache| holds the base secrets shared
+// with the other files processed by the app. Returns 0 if all the frames
+// match, 1 if any frame does not match and <0 for an error.
+int WebMVerify(const WebMCryptSettings& webm_crypt,
+               BaseSecretCache* secret_cache) {
+  if (!secret_cache)
+    return -1;
+
+  mkvparser::MkvReader reader;
+  mkvparser::MkvReader source_reader;
+  unique_ptr<mkvparser::Segment> parser_segment;
+  unique_ptr<mkvparser::Segment> source_segment;
+  if (!OpenWebMFile(webm_crypt.input, &reader, &parser_segment) ||
+      !OpenWebMFile(webm_crypt.verify_source, &source_reader,
+                    &source_segment)) {
+    fprintf(stderr, "Could not open WebM files.\n");
+    return -1;
+  }
+
+  const mkvparser::Tracks* const parser_tracks = parser_segment->GetTracks();
+  EncryptionSettings aud_enc;
+  EncryptionSettings vid_enc;
+  // Key rotation is not stored in the file.
+  aud_enc.key_rotation = webm_crypt.aud_enc.key_rotation;
+  aud_enc.key_rotation_clusters = webm_crypt.aud_enc.key_rotation_clusters;
+  vid_enc.key_rotation = webm_crypt.vid_enc.key_rotation;
+  vid_enc.key_rotation_clusters = webm_crypt.vid_enc.key_rotation_clusters;
+  bool decrypt_video = false;
+  bool decrypt_audio = false;
+  string aud_base_secret;
+  string vid_base_secret;
+
+  for (uint32_t i = 0; i < parser_tracks->GetTracksCount(); ++i) {
+    const mkvparser::Track* const parser_track =
+        parser_tracks->GetTrackByIndex(i);
+    if (parser_track == NULL || parser_track->GetContentEncodingCount() == 0)
+      continue;
+
+    const int64_t track_type = parser_track->GetType();
+    if (track_type != mkvparser::Track::kVideo &&
+        track_type != mkvparser::Track::kAudio) {
+      continue;
+    }
+    const bool video = track_type == mkvparser::Track::kVideo;
+
+    // Only check the first content encoding.
+    const ContentEncoding* const encoding =
+        parser_track->GetContentEncodingByIndex(0);
+    if (!encoding) {
+      fprintf(stderr, "Could not get first ContentEncoding.\n");
+      return -1;
+    }
+
+    if (!ParseContentEncryption(*encoding, video ? &vid_enc : &aud_enc)) {
+      fprintf(stderr, "Could not parse %s ContentEncryption element.\n",
+              video ? "video" : "audio");
+      return -1;
+    }
+
+    const string& secret_file = video ?
+        webm_crypt.vid_enc.base_secret_file :
+        webm_crypt.aud_enc.base_secret_file;
+    if (!secret_cache->ReadSecret(secret_file,
+                                  video ? &vid_base_secret :
+                                          &aud_base_secret)) {
+      fprintf(stderr, "Could not read %s base secret file:%s\n",
+              video ? "video" : "audio", secret_file.c_str());
+      return -1;
+    }
+
+    if (video)
+      decrypt_video = true;
+    else
+      decrypt_audio = true;
+  }
+
+  DecryptModule audio_decryptor(aud_enc,
+                                aud_base_secret,
+                                webm_crypt.no_encryption);
+  if (decrypt_audio && !audio_decryptor.Init()) {
+    fprintf(stderr, "Could not initialize audio decryptor.\n");
+    return -1;
+  }
+
+  DecryptModule video_decryptor(vid_enc,
+                                vid_base_secret,
+                                webm_crypt.no_encryption);
+  if (decrypt_video && !video_decryptor.Init()) {
+    fprintf(stderr, "Could not initialize video decryptor.\n");
+    return -1;
+  }
+
+  // The muxer may interleave audio and video differently from the source,
+  // so source frames are read per track type.
+  FrameIterator frames(&reader, parser_segment.get());
+  FrameIterator source_audio(&source_reader, source_segment.get());
+  source_audio.set_track_type(mkvparser::Track::kAudio);
+  FrameIterator source_video(&source_reader, source_segment.get());
+  source_video.set_track_type(mkvparser::Track::kVideo);
+  FrameJob source_frame;
+
+  const FramePipeline::ReadFunc read_frame = [&](FrameJob* job) {
+    const int status = frames.Next(job);
+    if (status <= 0)
+      return status;
+
+    const bool audio = job->track_type == mkvparser::Track::kAudio;
+    FrameIterator& source = audio ? source_audio : source_video;
+    const int source_status = source.Next(&source_frame);
+    if (source_status < 0)
+      return source_status;
+    if (source_status == 0) {
+      fprintf(stderr, "Source file has fewer %s frames.\n",
+              audio ? "audio" : "video");
+      return -1;
+    }
+
+    // The source frame buffer is recycled by the next read.
+    job->reference.Swap(&source_frame.input);
+    job->reference_size = source_frame.input_size;
+    job->verified = job->time_ns == source_frame.time_ns;
+    job->process = true;
+    job->key_schedule = NULL;
+    if ((audio ? decrypt_audio : decrypt_video) && !webm_crypt.no_encryption) {
+      DecryptModule& decryptor = audio ? audio_decryptor : video_decryptor;
+      job->key_schedule = decryptor.KeySchedule(KeyPeriodForFrame(
+          audio ? aud_enc : vid_enc,
+          job->time_ns / webm_tools::kNanosecondsPerMillisecond,
+          job->cluster_index));
+      if (!job->key_schedule)
+        return -1;
+    }
+    return 1;
+  };
+
+  const FramePipeline::ProcessFunc verify_frame = [&](FrameJob* job) {
+    const bool audio = job->track_type == mkvparser::Track::kAudio;
+    const uint8_t* data = job->input_data;
+    size_t size = job->input_size;
+    if (audio ? decrypt_audio : decrypt_video) {
+      if (!job->output.Reserve(job->input_size))
+        return false;
+
+      const DecryptModule& decryptor =
+          audio ? audio_decryptor : video_decryptor;
+      job->output_size = 0;
+      if (!decryptor.DecryptData(job->input_data,
+                                 job->input_size,
+                                 job->key_schedule,
+                                 job->output.data(),
+                                 &job->output_size)) {
+        fprintf(stderr, "Could not decrypt %s data.\n",
+                audio ? "audio" : "video");
+        return false;
+      }
+      data = job->output.data();
+      size = job->output_size;
+    }
+
+    job->verified = job->verified && size == job->reference_size &&
+                    (size == 0 || !memcmp(data, job->reference.data(), size));
+    return true;
+  };
+
+  const int kMaxReportedMismatches = 10;
+  int64_t frames_checked = 0;
+  int64_t mismatched_frames = 0;
+  const FramePipeline::MuxFunc check_frame = [&](const FrameJob& job) {
+    ++frames_checked;
+    if (!job.verified) {
+      if (mismatched_frames < kMaxReportedMismatches) {
+        fprintf(stderr, "Frame does not match source. track_type:%" PRId64
+                " time_ns:%" PRId64 "\n", job.track_type, job.time_ns);
+      }
+      ++mismatched_frames;
+    }
+    return true;
+  };
+
+  FramePipeline pipeline(webm_crypt.num_threads);
+  if (!pipeline.Run(read_frame, verify_frame, check_frame))
+    return -1;
+
+  if (source_audio.Next(&source_frame) != 0 ||
+      source_video.Next(&source_frame) != 0) {
+    fprintf(stderr, "Source file has more frames than:%s\n",
+            webm_crypt.input.c_str());
+    return 1;
+  }
+
+  printf("%s: %" PRId64 " frames checked, %" PRId64 " did not match.\n",
+         webm_crypt.input.c_str(), frames_checked, mismatched_frames);
+
+  reader.Close();
+  source_reader.Close();
+  return mismatched_frames > 0 ? 1 : 0;
+}
+
 bool CheckEncryptionOptions(const string& name,
                             const EncryptionSettings& enc) {
   if (enc.cipher_mode != "CTR") {
@@ -1462,16 +2269,293 @@ bool CheckEncryptionOptions(const string& name,
             enc.cipher_mode.c_str());
     return false;
   }
+  if (enc.partitioned && name != "video") {
+    fprintf(stderr, "stream:%s Partitioned encryption is only supported for "
+            "video.\n", name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Checks that stream |name| does not set both key rotation options. Returns
+// true on success.
+bool CheckKeyRotation(const string& name, const EncryptionSettings& enc) {
+  if (enc.key_rotation > 0 && enc.key_rotation_clusters > 0) {
+    fprintf(stderr, "stream:%s Only one of key_rotation and "
+            "key_rotation_clusters may be set.\n", name.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Parses the option at |args[*index]| if it is a per-file option and stores
+// the value in |settings|. |index| is advanced past the option's value.
+// Returns false if the option is unknown or is missing its value.
+bool ParseFileOption(const std::vector<string>& args,
+                     size_t* index,
+                     WebMCryptSettings* settings) {
+  if (!index || !settings || *index >= args.size())
+    return false;
+
+  size_t& i = *index;
+  const string& option = args[i];
+  const bool has_value = i + 1 < args.size();
+  if (option == "-decrypt") {
+    settings->decrypt = true;
+    return true;
+  }
+  if (!has_value)
+    return false;
+
+  const string& value = args[++i];
+  if (option == "-i") {
+    settings->input = value;
+  } else if (option == "-o") {
+    settings->output = value;
+  } else if (option == "-audio") {
+    settings->audio = value == "true";
+  } else if (option == "-video") {
+    settings->video = value == "true";
+  } else if (option == "-no_encryption") {
+    settings->no_encryption = value == "true";
+  } else if (option == "-match_src_clusters") {
+    settings->match_src_clusters = value == "true";
+  } else if (option == "-verify") {
+    settings->verify_source = value;
+  } else if (option == "-threads") {
+    settings->num_threads = strtol(value.c_str(), NULL, 10);
+  } else if (option == "-audio_options") {
+    ParseStreamOptions(value, &settings->aud_enc);
+  } else if (option == "-video_options") {
+    ParseStreamOptions(value, &settings->vid_enc);
+  } else {
+    --i;
+    return false;
+  }
+  return true;
+}
+
+// Checks that |settings| has the options needed to process a file. Returns
+// true on success.
+bool CheckFileSettings(const WebMCryptSettings& settings) {
+  if (settings.input.empty()) {
+    fprintf(stderr, "No input file set.\n");
+    return false;
+  }
+  if (settings.output.empty() && settings.verify_source.empty()) {
+    fprintf(stderr, "No output file set.\n");
+    return false;
+  }
+
+  if (!CheckKeyRotation("audio", settings.aud_enc) ||
+      !CheckKeyRotation("video", settings.vid_enc)) {
+    return false;
+  }
+
+  if (!settings.decrypt && settings.verify_source.empty()) {
+    if (settings.audio && !CheckEncryptionOptions("audio", settings.aud_enc))
+      return false;
+    if (settings.video && !CheckEncryptionOptions("video", settings.vid_enc))
+      return false;
+    const bool cluster_rotation =
+        (settings.audio && settings.aud_enc.key_rotation_clusters > 0) ||
+        (settings.video && settings.vid_enc.key_rotation_clusters > 0);
+    if (cluster_rotation && !settings.match_src_clusters) {
+      fprintf(stderr, "key_rotation_clusters requires -match_src_clusters.\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+// Encrypts or decrypts the file described by |settings|. Returns true on
+// success.
+bool ProcessFile(const WebMCryptSettings& settings,
+                 BaseSecretCache* secret_cache) {
+  if (!settings.verify_source.empty()) {
+    const int rv = WebMVerify(settings, secret_cache);
+    if (rv < 0) {
+      fprintf(stderr, "Error verifying WebM file:%s\n",
+              settings.input.c_str());
+      return false;
+    }
+    if (rv > 0) {
+      fprintf(stderr, "WebM file:%s does not match source:%s\n",
+              settings.input.c_str(), settings.verify_source.c_str());
+      return false;
+    }
+  } else if (settings.decrypt) {
+    if (WebMDecrypt(settings, secret_cache) < 0) {
+      fprintf(stderr, "Error decrypting WebM file:%s\n",
+              settings.input.c_str());
+      return false;
+    }
+  } else {
+    if (WebMEncrypt(settings, secret_cache) < 0) {
+      fprintf(stderr, "Error encrypting WebM file:%s\n",
+              settings.input.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reads the batch job file |filename|. Each line of the file holds the
+// per-file options of one job. Blank lines and lines starting with '#' are
+// skipped. Each job starts from |defaults| with new random initial IVs, so
+// files sharing a base secret never share IVs. |jobs| output list of jobs.
+// Returns true on success.
+bool ReadBatchFile(const string& filename,
+                   const WebMCryptSettings& defaults,
+                   std::vector<WebMCryptSettings>* jobs) {
+  if (!jobs)
+    return false;
+
+  std::ifstream file(filename.c_str());
+  if (!file) {
+    fprintf(stderr, "Could not open batch file:%s\n", filename.c_str());
+    return false;
+  }
+
+  string line;
+  int line_number = 0;
+  while (std::getline(file, line)) {
+    ++line_number;
+    std::istringstream line_stream(line);
+    std::vector<string> args;
+    string arg;
+    while (line_stream >> arg)
+      args.push_back(arg);
+    if (args.empty() || args[0][0] == '#')
+      continue;
+
+    WebMCryptSettings job = defaults;
+    if (!GenerateRandomuint64_t(&job.aud_enc.initial_iv) ||
+        !GenerateRandomuint64_t(&job.vid_enc.initial_iv)) {
+      fprintf(stderr, "Could not generate initial IV value.\n");
+      return false;
+    }
+
+    for (size_t i = 0; i < args.size(); ++i) {
+      if (!ParseFileOption(args, &i, &job)) {
+        fprintf(stderr, "%s:%d Unknown or invalid parameter:%s\n",
+                filename.c_str(), line_number, args[i].c_str());
+        return false;
+      }
+    }
+
+    if (!CheckFileSettings(job)) {
+      fprintf(stderr, "%s:%d Invalid job.\n", filename.c_str(), line_number);
+      return false;
+    }
+    jobs->push_back(job);
+  }
 
+  if (jobs->empty()) {
+    fprintf(stderr, "No jobs in batch file:%s\n", filename.c_str());
+    return false;
+  }
   return true;
 }
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+// Locks handed to OpenSSL by OpenSSLThreadLocks.
+std::mutex* g_openssl_locks = NULL;
+
+void OpenSSLLockingCallback(int mode, int n, const char* /* file */,
+                            int /* line */) {
+  if (mode & CRYPTO_LOCK)
+    g_openssl_locks[n].lock();
+  else
+    g_openssl_locks[n].unlock();
+}
+
+void OpenSSLThreadIdCallback(CRYPTO_THREADID* id) {
+  // The address of a thread local is unique among the running threads.
+  static thread_local char thread_tag;
+  CRYPTO_THREADID_set_pointer(id, &thread_tag);
+}
+#endif
+
+// OpenSSL before 1.1 is only thread safe once the application installs
+// locking callbacks. Batch jobs and the frame pipeline call RAND_bytes() and
+// HMAC() from several threads, so main() holds an instance for the life of
+// the app. Does nothing with OpenSSL 1.1 and later, which lock internally.
+class OpenSSLThreadLocks {
+ public:
+  OpenSSLThreadLocks() {}
+  ~OpenSSLThreadLocks() {
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    if (locks_.get()) {
+      CRYPTO_set_locking_callback(NULL);
+      CRYPTO_THREADID_set_callback(NULL);
+      g_openssl_locks = NULL;
+    }
+#endif
+  }
+
+  // Installs the callbacks. Must be called before any thread uses OpenSSL.
+  // Returns false on allocation failure.
+  bool Init() {
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    locks_.reset(new (std::nothrow) std::mutex[CRYPTO_num_locks()]);  // NOLINT
+    if (!locks_.get())
+      return false;
+    g_openssl_locks = locks_.get();
+    CRYPTO_THREADID_set_callback(OpenSSLThreadIdCallback);
+    CRYPTO_set_locking_callback(OpenSSLLockingCallback);
+#endif
+    return true;
+  }
+
+ private:
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+  unique_ptr<std::mutex[]> locks_;
+#endif
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(OpenSSLThreadLocks);
+};
+
+// Processes |jobs| with |num_jobs| files in flight at a time. All jobs share
+// |secret_cache|. Returns the number of jobs that failed.
+int RunBatch(const std::vector<WebMCryptSettings>& jobs,
+             int num_jobs,
+             BaseSecretCache* secret_cache) {
+  std::atomic<size_t> next_job(0);
+  std::atomic<int> failed_jobs(0);
+  auto run_jobs = [&]() {
+    for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+      if (!ProcessFile(jobs[i], secret_cache))
+        ++failed_jobs;
+    }
+  };
+
+  if (num_jobs > static_cast<int>(jobs.size()))
+    num_jobs = static_cast<int>(jobs.size());
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_jobs; ++i)
+    threads.push_back(std::thread(run_jobs));
+  run_jobs();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  return failed_jobs;
+}
+
 }  // namespace
 
 int main(int argc, char* argv[]) {
   WebMCryptSettings webm_crypt_settings;
-  bool encrypt = true;
   bool test = false;
+  string batch_file;
+  int num_jobs = 1;
+
+  OpenSSLThreadLocks openssl_locks;
+  if (!openssl_locks.Init()) {
+    fprintf(stderr, "Could not initialize OpenSSL locks.\n");
+    return EXIT_FAILURE;
+  }
 
   // Create initial random IV values.
   if (!GenerateRandomuint64_t(&webm_crypt_settings.aud_enc.initial_iv)) {
@@ -1484,42 +2568,28 @@ int main(int argc, char* argv[]) {
   }
 
   // Parse command line options.
-  const int argc_check = argc - 1;
-  for (int i = 1; i < argc; ++i) {
-    if (!strcmp("-h", argv[i]) || !strcmp("-?", argv[i])) {
+  const std::vector<string> args(argv, argv + argc);
+  const size_t args_check = args.size() - 1;
+  for (size_t i = 1; i < args.size(); ++i) {
+    if (args[i] == "-h" || args[i] == "-?") {
       Usage();
       return 0;
-    } else if (!strcmp("-v", argv[i])) {
+    } else if (args[i] == "-v") {
       printf("version: %s\n", WEBM_CRYPT_VERSION_STRING);
-    } else if (!strcmp("-i", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.input = argv[i];
-    } else if (!strcmp("-o", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.output = argv[i];
-    } else if (!strcmp("-audio", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.audio = !strcmp("true", argv[i]);
-    } else if (!strcmp("-video", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.video = !strcmp("true", argv[i]);
-    } else if (!strcmp("-decrypt", argv[i])) {
-      encrypt = false;
-    } else if (!strcmp("-no_encryption", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.no_encryption = !strcmp("true", argv[i]);
-    } else if (!strcmp("-match_src_clusters", argv[i]) && i++ < argc_check) {
-      webm_crypt_settings.match_src_clusters = !strcmp("true", argv[i]);
-    } else if (!strcmp("-audio_options", argv[i]) && i++ < argc_check) {
-      string option_list(argv[i]);
-      ParseStreamOptions(option_list, &webm_crypt_settings.aud_enc);
-    } else if (!strcmp("-video_options", argv[i]) && i++ < argc_check) {
-      string option_list(argv[i]);
-      ParseStreamOptions(option_list, &webm_crypt_settings.vid_enc);
-    } else if (!strcmp("-test", argv[i])) {
+    } else if (args[i] == "-test") {
       test = true;
-    } else {
-      if (i == argc_check) {
+    } else if (args[i] == "-batch" && i++ < args_check) {
+      batch_file = args[i];
+    } else if (args[i] == "-jobs" && i++ < args_check) {
+      num_jobs = strtol(args[i].c_str(), NULL, 10);
+    } else if (!ParseFileOption(args, &i, &webm_crypt_settings)) {
+      if (i == args_check) {
         --i;
-        printf("Unknown or invalid parameter. index:%d parameter:%s\n",
-               i, argv[i]);
+        printf("Unknown or invalid parameter. index:%zu parameter:%s\n",
+               i, args[i].c_str());
       } else {
-        printf("Unknown parameter. index:%d parameter:%s\n", i, argv[i]);
+        printf("Unknown parameter. index:%zu parameter:%s\n",
+               i, args[i].c_str());
       }
       return EXIT_FAILURE;
     }
@@ -1530,42 +2600,29 @@ int main(int argc, char* argv[]) {
     return EXIT_SUCCESS;
   }
 
-  // Check main parameters.
-  if (webm_crypt_settings.input.empty()) {
-    fprintf(stderr, "No input file set.\n");
-    Usage();
-    return EXIT_FAILURE;
-  }
-  if (webm_crypt_settings.output.empty()) {
-    fprintf(stderr, "No output file set.\n");
-    Usage();
-    return EXIT_FAILURE;
-  }
-
-  if (encrypt) {
-    if (webm_crypt_settings.audio &&
-        !CheckEncryptionOptions("audio", webm_crypt_settings.aud_enc)) {
-      Usage();
-      return EXIT_FAILURE;
-    }
-    if (webm_crypt_settings.video &&
-        !CheckEncryptionOptions("video", webm_crypt_settings.vid_enc)) {
+  BaseSecretCache secret_cache;
+  if (!batch_file.empty()) {
+    std::vector<WebMCryptSettings> jobs;
+    if (!ReadBatchFile(batch_file, webm_crypt_settings, &jobs)) {
       Usage();
       return EXIT_FAILURE;
     }
 
-    const int rv = WebMEncrypt(webm_crypt_settings);
-    if (rv < 0) {
-      fprintf(stderr, "Error encrypting WebM file.\n");
-      return EXIT_FAILURE;
-    }
-  } else {
-    const int rv = WebMDecrypt(webm_crypt_settings);
-    if (rv < 0) {
-      fprintf(stderr, "Error decrypting WebM file.\n");
+    const int failed_jobs = RunBatch(jobs, num_jobs, &secret_cache);
+    if (failed_jobs > 0) {
+      fprintf(stderr, "%d of %zu batch jobs failed.\n",
+              failed_jobs, jobs.size());
       return EXIT_FAILURE;
     }
+    return EXIT_SUCCESS;
   }
 
+  if (!CheckFileSettings(webm_crypt_settings)) {
+    Usage();
+    return EXIT_FAILURE;
+  }
+  if (!ProcessFile(webm_crypt_settings, &secret_cache))
+    return EXIT_FAILURE;
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,248 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+// Measures the per-frame cost of webm_crypt's encryption without file I/O.
+// Each frame profile is run through the parts of EncryptModule::ProcessData()
+// on their own (key setup, counter block generation, AES-CTR and the copy of
+// unencrypted frames) and then through ProcessData(), partitioned
+// ProcessDataWithIV() and DecryptModule::DecryptData(). The vp8_partitioned
+// stage partitions VP8 key frames with VpxFramePartitioner and encrypts them
+// in the partitioned format, for comparison with full frame encryption in
+// process_data.
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "encrypt_module.h"
+#include "vpx_frame_partitions.h"
+
+namespace {
+
+using std::string;
+using webm_crypt::DecryptModule;
+using webm_crypt::EncryptionSettings;
+using webm_crypt::EncryptModule;
+
+// Size of the uncompressed header left in the clear by partitioned
+// encryption. VP9 uncompressed headers are usually 10 to 30 bytes.
+const uint32_t kClearHeaderSize = 20;
+
+// Frame tag, start code and dimensions of a 640x480 VP8 key frame.
+const uint8_t kVp8KeyFrameHeader[] = {
+  0x10, 0x02, 0x00, 0x9d, 0x01, 0x2a, 0x80, 0x02, 0xe0, 0x01
+};
+
+// Describes the frames of one benchmark run. Frame sizes are spread evenly
+// over [|min_size|, |max_size|].
+struct FrameProfile {
+  const char* name;
+  size_t min_size;
+  size_t max_size;
+  int num_frames;
+};
+
+const FrameProfile kFrameProfiles[] = {
+  // 20ms Opus packets at 48 to 128 kbps.
+  { "opus", 120, 320, 50000 },
+  // VP9 1080p inter frames at about 4 Mbps.
+  { "vp9_inter", 4 * 1024, 40 * 1024, 5000 },
+  // VP9 4K key frames.
+  { "4k_key", 400 * 1024, 1200 * 1024, 200 },
+};
+
+// Times the calls of |func| for each frame. Returns the elapsed time in
+// nanoseconds.
+template <typename Func>
+double TimeFrames(const std::vector<size_t>& sizes, Func func) {
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (!func(i, sizes[i])) {
+      fprintf(stderr, "Benchmark function failed.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints one result line. |bytes| is the number of frame bytes processed.
+void PrintResult(const char* profile, const char* stage, int num_frames,
+                 uint64_t bytes, double elapsed_ns) {
+  const double ns_per_frame = elapsed_ns / num_frames;
+  const double gb_per_second = bytes > 0 ? bytes / elapsed_ns : 0;
+  printf("%-10s %-24s %12.1f %8.3f\n",
+         profile, stage, ns_per_frame, gb_per_second);
+}
+
+void RunProfile(const FrameProfile& profile, const string& key) {
+  // Deterministic frame sizes so runs can be compared.
+  std::vector<size_t> sizes(profile.num_frames);
+  uint64_t total_bytes = 0;
+  uint32_t seed = 1;
+  const size_t range = profile.max_size - profile.min_size + 1;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    seed = seed * 1103515245 + 12345;
+    sizes[i] = profile.min_size + (seed >> 8) % range;
+    total_bytes += sizes[i];
+  }
+
+  std::vector<uint8_t> source(profile.max_size);
+  for (size_t i = 0; i < source.size(); ++i)
+    source[i] = static_cast<uint8_t>(i * 31 + 7);
+  std::vector<uint8_t> encrypted(
+      EncryptModule::MaxProcessedSize(profile.max_size, 1));
+  std::vector<uint8_t> decrypted(profile.max_size);
+  const int num_frames = profile.num_frames;
+
+  // Key setup, which is done once per stream.
+  AesCtr128Encryptor encryptor;
+  double elapsed = TimeFrames(sizes, [&](size_t, size_t) {
+    return encryptor.InitKey(key);
+  });
+  PrintResult(profile.name, "key_setup", num_frames, 0, elapsed);
+
+  // Counter block generation.
+  uint8_t counter_block[EncryptModule::kKeySize];
+  uint64_t iv = 0;
+  elapsed = TimeFrames(sizes, [&](size_t, size_t) {
+    ++iv;
+    EncryptModule::GenerateCounterBlock(reinterpret_cast<uint8_t*>(&iv),
+                                        counter_block);
+    return true;
+  });
+  PrintResult(profile.name, "counter_block", num_frames, 0, elapsed);
+
+  // AES-CTR only.
+  elapsed = TimeFrames(sizes, [&](size_t, size_t size) {
+    return encryptor.Encrypt(counter_block, &source[0], size, &encrypted[0]);
+  });
+  PrintResult(profile.name, "cipher", num_frames, total_bytes, elapsed);
+
+  // Copy of an unencrypted frame.
+  elapsed = TimeFrames(sizes, [&](size_t, size_t size) {
+    memcpy(&encrypted[0], &source[0], size);
+    return encrypted[0] == source[0];
+  });
+  PrintResult(profile.name, "copy", num_frames, total_bytes, elapsed);
+
+  EncryptionSettings enc;
+  EncryptModule encrypt_module(enc, key);
+  DecryptModule decrypt_module(enc, key, false);
+  if (!encrypt_module.Init() || !decrypt_module.Init()) {
+    fprintf(stderr, "Could not initialize encryption modules.\n");
+    exit(EXIT_FAILURE);
+  }
+  const AesCtr128Encryptor* const encrypt_schedule =
+      encrypt_module.KeySchedule(0);
+  const AesCtr128Encryptor* const decrypt_schedule =
+      decrypt_module.KeySchedule(0);
+  if (!encrypt_schedule || !decrypt_schedule)
+    exit(EXIT_FAILURE);
+
+  size_t encrypted_size = 0;
+  elapsed = TimeFrames(sizes, [&](size_t, size_t size) {
+    return encrypt_module.ProcessData(&source[0], size, true,
+                                      &encrypted[0], &encrypted_size);
+  });
+  PrintResult(profile.name, "process_data", num_frames, total_bytes, elapsed);
+
+  elapsed = TimeFrames(sizes, [&](size_t, size_t size) {
+    return encrypt_module.ProcessData(&source[0], size, false,
+                                      &encrypted[0], &encrypted_size);
+  });
+  PrintResult(profile.name, "process_data_clear", num_frames, total_bytes,
+              elapsed);
+
+  // Partitioned encryption with the frame header in the clear.
+  std::vector<uint32_t> partitions(1, kClearHeaderSize);
+  elapsed = TimeFrames(sizes, [&](size_t i, size_t size) {
+    const std::vector<uint32_t> no_partitions;
+    return encrypt_module.ProcessDataWithIV(
+        &source[0], size, true, i, encrypt_schedule,
+        size > kClearHeaderSize ? partitions : no_partitions,
+        &encrypted[0], &encrypted_size);
+  });
+  PrintResult(profile.name, "process_partitioned", num_frames, total_bytes,
+              elapsed);
+
+  // VP8 key frames, partitioned by VpxFramePartitioner on every frame.
+  std::vector<uint8_t> vp8_source(source);
+  memcpy(&vp8_source[0], kVp8KeyFrameHeader, sizeof(kVp8KeyFrameHeader));
+  webm_crypt::VpxFramePartitioner partitioner(
+      webm_crypt::VpxFramePartitioner::kVP8);
+  std::vector<uint32_t> vp8_partitions;
+  elapsed = TimeFrames(sizes, [&](size_t i, size_t size) {
+    if (!partitioner.GetPartitions(&vp8_source[0], size, &vp8_partitions))
+      return false;
+    return encrypt_module.ProcessDataWithIV(
+        &vp8_source[0], size, true, i, encrypt_schedule, vp8_partitions,
+        &encrypted[0], &encrypted_size);
+  });
+  PrintResult(profile.name, "vp8_partitioned", num_frames, total_bytes,
+              elapsed);
+
+  // Decryption cycles through up to 64 frames encrypted up front, so only
+  // DecryptData() is timed.
+  std::vector<std::vector<uint8_t> > frames(sizes.size() < 64 ?
+                                            sizes.size() : 64);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (!encrypt_module.ProcessData(&source[0], sizes[i], true,
+                                    &encrypted[0], &encrypted_size)) {
+      fprintf(stderr, "Could not encrypt frame.\n");
+      exit(EXIT_FAILURE);
+    }
+    frames[i].assign(encrypted.begin(), encrypted.begin() + encrypted_size);
+  }
+  uint64_t decrypted_bytes = 0;
+  elapsed = TimeFrames(sizes, [&](size_t i, size_t) {
+    const std::vector<uint8_t>& frame = frames[i % frames.size()];
+    size_t decrypted_size = 0;
+    const bool ok = decrypt_module.DecryptData(&frame[0], frame.size(),
+                                               decrypt_schedule,
+                                               &decrypted[0],
+                                               &decrypted_size);
+    decrypted_bytes += decrypted_size;
+    return ok;
+  });
+  PrintResult(profile.name, "decrypt_data", num_frames, decrypted_bytes,
+              elapsed);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  double scale = 1.0;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp("-scale", argv[i]) && i + 1 < argc) {
+      scale = strtod(argv[++i], NULL);
+    } else {
+      printf("Usage: webm_crypt_benchmark [-scale <double>]\n");
+      printf("  -scale <double>  Multiplies the number of frames of each\n");
+      printf("                   profile. (Default 1.0)\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  const string key(EncryptModule::kKeySize, '\x5a');
+  printf("%-10s %-24s %12s %8s\n", "profile", "stage", "ns/frame", "GB/s");
+  for (size_t i = 0; i < sizeof(kFrameProfiles) / sizeof(kFrameProfiles[0]);
+       ++i) {
+    FrameProfile profile = kFrameProfiles[i];
+    profile.num_frames = static_cast<int>(profile.num_frames * scale);
+    if (profile.num_frames < 1)
+      profile.num_frames = 1;
+    RunProfile(profile, key);
+  }
+  return EXIT_SUCCESS;
+}
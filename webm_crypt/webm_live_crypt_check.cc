@@ -0,0 +1,322 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+// Checks that live streams encrypted by WebMLiveMuxer::SetTrackEncryption()
+// decrypt with webm_crypt. A short VP9 and Opus stream is muxed with both
+// tracks encrypted with the same key, parsed back with mkvparser, and every
+// frame is decrypted with DecryptModule and compared with its source frame.
+// The tracks must start from different random IVs, and a track with the key
+// and initial IV of the other track must be rejected.
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "encrypt_module.h"
+#include "mkvparser/mkvparser.h"
+#include "webm_frame_encryptor.h"
+#include "webm_incremental_reader.h"
+#include "webm_live_muxer.h"
+
+namespace {
+
+using std::string;
+using webm_crypt::DecryptModule;
+using webm_crypt::EncryptionSettings;
+using webm_crypt::EncryptModule;
+using webm_tools::WebMEncryptionConfig;
+using webm_tools::WebMLiveMuxer;
+
+const int kNumVideoFrames = 90;
+const int kFrameRate = 30;
+const int kKeyFrameInterval = 30;
+const int kAudioFrameMs = 20;
+const uint64_t kNanosecondsPerSecond = 1000000000ULL;
+const char kKey[] = "0123456789abcdef";
+
+struct SourceFrame {
+  bool video;
+  uint64_t timestamp_ns;
+  bool is_key;
+  std::vector<uint8_t> data;
+};
+
+// Returns |kNumVideoFrames| video frames and the audio frames of the same
+// duration, in timestamp order. Frame contents are deterministic.
+std::vector<SourceFrame> MakeFrames() {
+  std::vector<SourceFrame> frames;
+  const uint64_t duration_ns =
+      kNumVideoFrames * kNanosecondsPerSecond / kFrameRate;
+  const uint64_t audio_duration_ns = kAudioFrameMs * 1000000ULL;
+  int video_frame = 0;
+  int audio_frame = 0;
+  for (;;) {
+    const uint64_t video_ns = video_frame * kNanosecondsPerSecond / kFrameRate;
+    const uint64_t audio_ns = audio_frame * audio_duration_ns;
+    if (video_ns >= duration_ns && audio_ns >= duration_ns)
+      break;
+
+    SourceFrame frame;
+    frame.video = video_ns <= audio_ns;
+    size_t size = 0;
+    if (frame.video) {
+      frame.timestamp_ns = video_ns;
+      frame.is_key = video_frame % kKeyFrameInterval == 0;
+      size = frame.is_key ? 16 * 1024 : 1024 + (video_frame * 97) % 4096;
+      ++video_frame;
+    } else {
+      frame.timestamp_ns = audio_ns;
+      frame.is_key = true;
+      size = 120 + (audio_frame * 13) % 200;
+      ++audio_frame;
+    }
+    frame.data.resize(size);
+    for (size_t i = 0; i < size; ++i)
+      frame.data[i] = static_cast<uint8_t>(i * 31 + frames.size());
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+// Adds the tracks to |muxer| and stores their numbers in |ptr_video_track|
+// and |ptr_audio_track|.
+bool AddTracks(WebMLiveMuxer* muxer, uint64_t* ptr_video_track,
+               uint64_t* ptr_audio_track) {
+  if (muxer->Init() != WebMLiveMuxer::kSuccess) {
+    fprintf(stderr, "Cannot Init the muxer.\n");
+    return false;
+  }
+  const int video_track = muxer->AddVideoTrack(640, 360, "V_VP9");
+  const int audio_track = muxer->AddAudioTrack(48000, 2, NULL, 0, "A_OPUS");
+  if (video_track < 1 || audio_track < 1) {
+    fprintf(stderr, "Cannot add tracks.\n");
+    return false;
+  }
+  *ptr_video_track = video_track;
+  *ptr_audio_track = audio_track;
+  return true;
+}
+
+// Muxes |frames| with both tracks encrypted with |kKey| and random IVs, and
+// stores the stream in |ptr_stream|.
+bool MuxEncryptedStream(const std::vector<SourceFrame>& frames,
+                        std::vector<uint8_t>* ptr_stream) {
+  WebMLiveMuxer muxer;
+  uint64_t video_track = 0;
+  uint64_t audio_track = 0;
+  if (!AddTracks(&muxer, &video_track, &audio_track))
+    return false;
+
+  WebMEncryptionConfig config;
+  config.key = kKey;
+  config.key_id = "video";
+  if (muxer.SetTrackEncryption(video_track, config) !=
+      WebMLiveMuxer::kSuccess) {
+    fprintf(stderr, "Cannot encrypt the video track.\n");
+    return false;
+  }
+  config.key_id = "audio";
+  if (muxer.SetTrackEncryption(audio_track, config) !=
+      WebMLiveMuxer::kSuccess) {
+    fprintf(stderr, "Cannot encrypt the audio track.\n");
+    return false;
+  }
+
+  ptr_stream->clear();
+  WebMLiveMuxer::ChunkBuffer chunk;
+  webm_tools::int32 chunk_length = 0;
+  for (size_t i = 0; i <= frames.size(); ++i) {
+    if (i < frames.size()) {
+      const SourceFrame& frame = frames[i];
+      const int status = frame.video ?
+          muxer.WriteVideoFrame(&frame.data[0], frame.data.size(),
+                                frame.timestamp_ns, frame.is_key) :
+          muxer.WriteAudioFrame(&frame.data[0], frame.data.size(),
+                                frame.timestamp_ns, frame.is_key);
+      if (status != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "Cannot write frame %zu.\n", i);
+        return false;
+      }
+    } else if (muxer.Finalize() != WebMLiveMuxer::kSuccess) {
+      fprintf(stderr, "Cannot finalize.\n");
+      return false;
+    }
+    while (muxer.ChunkReady(&chunk_length)) {
+      if (muxer.ReadChunk(&chunk) != WebMLiveMuxer::kSuccess)
+        return false;
+      ptr_stream->insert(ptr_stream->end(), chunk.begin(), chunk.end());
+    }
+  }
+  return !ptr_stream->empty();
+}
+
+// Parses |stream|, decrypts every frame and compares it with |frames|.
+bool DecryptStream(const std::vector<uint8_t>& stream,
+                   const std::vector<SourceFrame>& frames) {
+  EncryptionSettings enc;
+  DecryptModule decryptor(enc, kKey, false);
+  if (!decryptor.Init())
+    return false;
+  const AesCtr128Encryptor* const key_schedule = decryptor.KeySchedule(0);
+  if (!key_schedule)
+    return false;
+
+  webm_tools::WebmIncrementalReader reader;
+  const int64_t stream_size = static_cast<int64_t>(stream.size());
+  if (reader.SetBufferWindow(&stream[0],
+                             static_cast<webm_tools::int32>(stream_size), 0) ||
+      !reader.SetEndOfSegmentPosition(stream_size)) {
+    return false;
+  }
+  long long pos = 0;  // NOLINT
+  mkvparser::EBMLHeader ebml_header;
+  if (ebml_header.Parse(&reader, pos)) {
+    fprintf(stderr, "Stream is not WebM.\n");
+    return false;
+  }
+  mkvparser::Segment* parser_segment = NULL;
+  if (mkvparser::Segment::CreateInstance(&reader, pos, parser_segment)) {
+    fprintf(stderr, "Segment::CreateInstance() failed.\n");
+    return false;
+  }
+  std::unique_ptr<mkvparser::Segment> parser(parser_segment);
+  if (parser->Load() < 0) {
+    fprintf(stderr, "Segment::Load() failed.\n");
+    return false;
+  }
+  const mkvparser::Tracks* const tracks = parser->GetTracks();
+
+  // Index in |frames| of the next frame of each track, and the first IV of
+  // each track.
+  size_t next_frame[2] = { 0, 0 };
+  uint64_t first_iv[2] = { 0, 0 };
+  bool has_first_iv[2] = { false, false };
+  std::vector<uint8_t> encrypted;
+  std::vector<uint8_t> decrypted;
+  for (const mkvparser::Cluster* cluster = parser->GetFirst();
+       cluster && !cluster->EOS(); cluster = parser->GetNext(cluster)) {
+    const mkvparser::BlockEntry* block_entry = NULL;
+    if (cluster->GetFirst(block_entry))
+      return false;
+    while (block_entry && !block_entry->EOS()) {
+      const mkvparser::Block* const block = block_entry->GetBlock();
+      const mkvparser::Track* const track = tracks->GetTrackByNumber(
+          static_cast<unsigned long>(block->GetTrackNumber()));  // NOLINT
+      if (!track)
+        return false;
+      const int video = track->GetType() == mkvparser::Track::kVideo ? 1 : 0;
+
+      for (int i = 0; i < block->GetFrameCount(); ++i) {
+        const mkvparser::Block::Frame& frame = block->GetFrame(i);
+        encrypted.resize(frame.len);
+        decrypted.resize(frame.len);
+        size_t decrypted_size = 0;
+        const size_t header_size =
+            EncryptModule::kSignalByteSize + EncryptModule::kIVSize;
+        if (encrypted.size() < header_size ||
+            frame.Read(&reader, &encrypted[0]) ||
+            !(encrypted[0] & EncryptModule::kEncryptedFrame) ||
+            !decryptor.DecryptData(&encrypted[0], encrypted.size(),
+                                   key_schedule, &decrypted[0],
+                                   &decrypted_size)) {
+          fprintf(stderr, "Cannot decrypt frame.\n");
+          return false;
+        }
+
+        size_t& index = next_frame[video];
+        while (index < frames.size() && frames[index].video != (video == 1))
+          ++index;
+        if (index == frames.size()) {
+          fprintf(stderr, "Too many frames.\n");
+          return false;
+        }
+        const std::vector<uint8_t>& source = frames[index++].data;
+        if (decrypted_size != source.size() ||
+            memcmp(&decrypted[0], &source[0], source.size())) {
+          fprintf(stderr, "Decrypted frame does not match.\n");
+          return false;
+        }
+        if (!has_first_iv[video]) {
+          memcpy(&first_iv[video], &encrypted[EncryptModule::kSignalByteSize],
+                 EncryptModule::kIVSize);
+          has_first_iv[video] = true;
+        }
+      }
+      if (cluster->GetNext(block_entry, block_entry))
+        return false;
+    }
+  }
+
+  for (int video = 0; video < 2; ++video) {
+    size_t index = next_frame[video];
+    while (index < frames.size() && frames[index].video != (video == 1))
+      ++index;
+    if (index != frames.size()) {
+      fprintf(stderr, "Missing %s frames.\n", video ? "video" : "audio");
+      return false;
+    }
+  }
+  if (!has_first_iv[0] || !has_first_iv[1] || first_iv[0] == first_iv[1]) {
+    fprintf(stderr, "Tracks start from the same IV.\n");
+    return false;
+  }
+  return true;
+}
+
+// Returns true when the muxer rejects a track encrypted with the key and
+// initial IV of the other track, and accepts it with another key.
+bool CheckSharedIV() {
+  WebMLiveMuxer muxer;
+  uint64_t video_track = 0;
+  uint64_t audio_track = 0;
+  if (!AddTracks(&muxer, &video_track, &audio_track))
+    return false;
+
+  WebMEncryptionConfig config;
+  config.key = kKey;
+  config.key_id = "video";
+  config.initial_iv = 1;
+  config.has_initial_iv = true;
+  if (muxer.SetTrackEncryption(video_track, config) !=
+      WebMLiveMuxer::kSuccess) {
+    return false;
+  }
+  config.key_id = "audio";
+  if (muxer.SetTrackEncryption(audio_track, config) !=
+      WebMLiveMuxer::kInvalidArg) {
+    fprintf(stderr, "Shared key and IV was not rejected.\n");
+    return false;
+  }
+  config.key = "fedcba9876543210";
+  return muxer.SetTrackEncryption(audio_track, config) ==
+         WebMLiveMuxer::kSuccess;
+}
+
+}  // namespace
+
+int main(int /* argc */, char* /* argv */[]) {
+  const std::vector<SourceFrame> frames = MakeFrames();
+  std::vector<uint8_t> stream;
+  if (!MuxEncryptedStream(frames, &stream) ||
+      !DecryptStream(stream, frames)) {
+    fprintf(stderr, "Round trip check failed.\n");
+    return EXIT_FAILURE;
+  }
+  printf("Round trip of %zu frames passed.\n", frames.size());
+
+  if (!CheckSharedIV()) {
+    fprintf(stderr, "Shared IV check failed.\n");
+    return EXIT_FAILURE;
+  }
+  printf("Shared IV check passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -15,16 +15,16 @@
 #include <utility>
 
 #include "dash_model.h"
-#include "indent.h"
 #include "representation.h"
 #include "webm_constants.h"
 #include "webm_file.h"
+#include "xml_writer.h"
 
 using std::string;
 using std::vector;
-using webm_tools::Indent;
 using webm_tools::kNanosecondsPerSecond;
 using webm_tools::WebMFile;
+using webm_tools::XmlWriter;
 
 namespace webm_dash {
 
@@ -38,7 +38,13 @@ AdaptationSet::AdaptationSet(const string& id, const DashModel& dash)
       lang_(),
       mimetype_(),
       profile_(),
-      duration_(0.0) {
+      duration_(0.0),
+      audio_sampling_rate_(0),
+      width_(0),
+      height_(0),
+      bitstream_switching_(false),
+      subsegment_alignment_(false),
+      subsegment_starts_with_sap_(false) {
 }
 
 AdaptationSet::~AdaptationSet() {
@@ -112,18 +118,18 @@ bool AdaptationSet::Init() {
     }
   }
 
-  const int sample_rate = MatchingAudioSamplingRate();
-  const int width = MatchingWidth();
-  const int height = MatchingHeight();
+  audio_sampling_rate_ = MatchingAudioSamplingRate();
+  width_ = MatchingWidth();
+  height_ = MatchingHeight();
 
   for (iter = representations_.begin();
       iter != representations_.end();
       ++iter) {
-    if (sample_rate)
+    if (audio_sampling_rate_)
       (*iter)->set_output_audio_sample_rate(false);
-    if (width)
+    if (width_)
       (*iter)->set_output_video_width(false);
-    if (height)
+    if (height_)
       (*iter)->set_output_video_height(false);
   }
 
@@ -158,73 +164,70 @@ const Representation* AdaptationSet::FindRepresentation(
   return NULL;
 }
 
-void AdaptationSet::OutputDashManifest(FILE* o, Indent* indent) const {
-  indent->Adjust(webm_tools::kIncreaseIndent);
-  fprintf(o, "%s<AdaptationSet id=\"%s\"", indent->indent_str().c_str(),
-          id_.c_str());
-  fprintf(o, " mimeType=\"%s\"", mimetype_.c_str());
-  fprintf(o, " codecs=\"%s\"", codec_.c_str());
+void AdaptationSet::ComputeManifestValues() {
+  subsegment_alignment_ = SubsegmentAlignment();
+  subsegment_starts_with_sap_ = SubsegmentStartsWithSAP();
+  bitstream_switching_ = BitstreamSwitching();
+}
+
+void AdaptationSet::OutputDashManifest(XmlWriter* writer) const {
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->StartElement("AdaptationSet");
+  writer->Attribute("id", id_);
+  writer->Attribute("mimeType", mimetype_);
+  writer->Attribute("codecs", codec_);
 
   if (!lang_.empty())
-    fprintf(o, " lang=\"%s\"", lang_.c_str());
+    writer->Attribute("lang", lang_);
 
-  const int sample_rate = MatchingAudioSamplingRate();
-  if (sample_rate)
-    fprintf(o, " audioSamplingRate=\"%d\"", sample_rate);
+  if (audio_sampling_rate_)
+    writer->Attribute("audioSamplingRate", audio_sampling_rate_);
 
-  const int width = MatchingWidth();
-  if (width)
-    fprintf(o, " width=\"%d\"", width);
+  if (width_)
+    writer->Attribute("width", width_);
 
-  const int height = MatchingHeight();
-  if (height)
-    fprintf(o, " height=\"%d\"", height);
+  if (height_)
+    writer->Attribute("height", height_);
 
-  const bool alignment = SubsegmentAlignment();
-  if (alignment) {
-    fprintf(o, " subsegmentAlignment=\"true\"");
+  if (subsegment_alignment_) {
+    writer->Write(" subsegmentAlignment=\"true\"");
   } else if (representations_.size() > 1 &&
              profile_ == DashModel::webm_on_demand) {
-    printf("Warning profile is WebM On-Demand and AdaptationSet id:%s",
-           id_.c_str());
-    printf(" does not have subSegmentAlignment.\n");
+    printf("Warning profile is WebM On-Demand and AdaptationSet id:%s"
+           " does not have subSegmentAlignment.\n", id_.c_str());
   }
 
   // WebM is only type '1' or '0'.
-  const bool subsegment_starts_with_SAP = SubsegmentStartsWithSAP();
-  if (subsegment_starts_with_SAP) {
-    fprintf(o, " subsegmentStartsWithSAP=\"1\"");
+  if (subsegment_starts_with_sap_) {
+    writer->Write(" subsegmentStartsWithSAP=\"1\"");
   } else if (profile_ == DashModel::webm_on_demand) {
-    printf("Warning profile is WebM On-Demand and AdaptationSet id:%s",
-           id_.c_str());
-    printf(" has subsegments that do not start with SAP.\n");
+    printf("Warning profile is WebM On-Demand and AdaptationSet id:%s"
+           " has subsegments that do not start with SAP.\n", id_.c_str());
   }
 
-  const bool switching = BitstreamSwitching();
-  if (switching)
-    fprintf(o, " bitstreamSwitching=\"true\"");
-  fprintf(o, ">\n");
+  if (bitstream_switching_)
+    writer->Write(" bitstreamSwitching=\"true\"");
+  writer->EndStartTag();
 
   for (RepresentationConstIterator c_iter = representations_.begin();
       c_iter != representations_.end();
       ++c_iter) {
-    (*c_iter)->OutputDashManifest(o, indent);
+    (*c_iter)->OutputDashManifest(writer);
   }
 
-  fprintf(o, "%s</AdaptationSet>\n", indent->indent_str().c_str());
-  indent->Adjust(webm_tools::kDecreaseIndent);
+  writer->EndElement("AdaptationSet");
+  writer->Adjust(webm_tools::kDecreaseIndent);
 }
 
 bool AdaptationSet::BitstreamSwitching() const {
   if (representations_.size() < 2)
     return false;
 
-  RepresentationConstIterator golden_iter(representations_.begin());
   for (RepresentationConstIterator iter = representations_.begin() + 1;
       iter != representations_.end();
       ++iter) {
     const Representation* const r = *iter;
-    if (!r->BitstreamSwitching(**golden_iter))
+    if (!r->bitstream_switching())
       return false;
   }
 
@@ -289,12 +292,11 @@ bool AdaptationSet::SubsegmentAlignment() const {
   if (representations_.size() < 2)
     return false;
 
-  RepresentationConstIterator golden_iter(representations_.begin());
   for (RepresentationConstIterator iter = representations_.begin() + 1;
       iter != representations_.end();
       ++iter) {
     const Representation* const r = *iter;
-    if (!r->CheckCuesAlignment(**golden_iter))
+    if (!r->cues_aligned())
       return false;
   }
 
@@ -309,7 +311,7 @@ bool AdaptationSet::SubsegmentStartsWithSAP() const {
       iter != representations_.end();
       ++iter) {
     const Representation* const r = *iter;
-    if (!r->SubsegmentStartsWithSAP())
+    if (!r->subsegment_starts_with_sap())
       return false;
   }
 
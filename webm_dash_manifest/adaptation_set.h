@@ -17,7 +17,7 @@
 #include "webm_tools_types.h"
 
 namespace webm_tools {
-class Indent;
+class XmlWriter;
 }  // namespace webm_tools
 
 namespace webm_dash {
@@ -46,8 +46,13 @@ class AdaptationSet {
   // Search the Representation list for |id|. If not found return NULL
   const Representation* FindRepresentation(const std::string& id) const;
 
+  // Sets the AdaptationSet attributes from the values computed by
+  // Representation::ComputeManifestValues(). Must be called after the values
+  // of all the Representations have been computed.
+  void ComputeManifestValues();
+
   // Outputs AdaptationSet in the WebM Dash format.
-  void OutputDashManifest(FILE* o, webm_tools::Indent* indent) const;
+  void OutputDashManifest(webm_tools::XmlWriter* writer) const;
 
   double duration() const { return duration_; }
 
@@ -58,10 +63,14 @@ class AdaptationSet {
   void set_lang(const std::string& lang) { lang_ = lang; }
 
   void set_profile(const std::string& profile) { profile_ = profile; }
+  const std::vector<Representation*>& representations() const {
+    return representations_;
+  }
 
  private:
   // Check all the files within the AdaptationSet to see if they conform to
-  // the bitstreamSwitching attribute.
+  // the bitstreamSwitching attribute. Reads the values computed by the
+  // Representations.
   bool BitstreamSwitching() const;
 
   // Check all the Representations within the AdaptationSet to see if they
@@ -83,11 +92,13 @@ class AdaptationSet {
   int MatchingWidth() const;
 
   // Check all the files within the AdaptationSet to see if they conform to
-  // the subsegmentAlignment attribute.
+  // the subsegmentAlignment attribute. Reads the values computed by the
+  // Representations.
   bool SubsegmentAlignment() const;
 
   // Check all the files within the AdaptationSet to see if they conform to
-  // the subsegmentStartsWithSAP attribute.
+  // the subsegmentStartsWithSAP attribute. Reads the values computed by the
+  // Representations.
   bool SubsegmentStartsWithSAP() const;
 
   // Codec string of all the files.
@@ -112,6 +123,15 @@ class AdaptationSet {
   // Maximum duration of all |media_|.
   double duration_;
 
+  // Attribute values set by Init() and ComputeManifestValues(). 0 when the
+  // values do not match within the AdaptationSet.
+  int audio_sampling_rate_;
+  int width_;
+  int height_;
+  bool bitstream_switching_;
+  bool subsegment_alignment_;
+  bool subsegment_starts_with_sap_;
+
   // TODO(fgalligan): Think about changing representations_ to a map with rep
   // id as the key.
   // Media list for this media group.
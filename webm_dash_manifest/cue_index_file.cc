@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "cue_index_file.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "webm_constants.h"
+#include "webm_cue_index.h"
+#include "webm_file.h"
+#include "webm_file_util.h"
+
+using std::string;
+using std::vector;
+using webm_tools::CueDesc;
+using webm_tools::int64;
+using webm_tools::kNanosecondsPerSecondi;
+using webm_tools::uint8;
+using webm_tools::WebMCueIndex;
+using webm_tools::WebMCueIndexEntry;
+using webm_tools::WebMFile;
+
+namespace webm_dash {
+
+bool BuildCueIndex(const WebMFile& webm_file, WebMCueIndex* index) {
+  if (!index || !webm_file.CheckForCues())
+    return false;
+
+  const vector<CueDesc>& cue_descs = webm_file.cue_desc_list();
+  vector<bool> key_frames;
+  if (!webm_file.CueKeyFrames(&key_frames) ||
+      key_frames.size() != cue_descs.size()) {
+    return false;
+  }
+
+  const int64 timecode_scale = webm_file.OutputTimecodeScale();
+  index->timescale =
+      static_cast<webm_tools::uint32>(kNanosecondsPerSecondi / timecode_scale);
+
+  int64 header_start = 0;
+  int64 header_end = 0;
+  webm_file.GetHeaderRange(&header_start, &header_end);
+  index->init_offset = header_start;
+  index->init_size = header_end - header_start;
+
+  // CueDesc offsets are relative to the Segment payload.
+  const int64 segment_start = webm_file.GetSegmentStartOffset();
+  index->entries.resize(cue_descs.size());
+  for (size_t i = 0; i < cue_descs.size(); ++i) {
+    WebMCueIndexEntry& entry = index->entries[i];
+    entry.time = cue_descs[i].start_time_ns / timecode_scale;
+    entry.offset = segment_start + cue_descs[i].start_offset;
+    entry.size = cue_descs[i].end_offset - cue_descs[i].start_offset;
+    entry.key_frame = key_frames[i];
+  }
+
+  return true;
+}
+
+bool WriteCueIndexFile(const WebMFile& webm_file, bool compressed) {
+  WebMCueIndex index;
+  if (!BuildCueIndex(webm_file, &index)) {
+    fprintf(stderr, "Could not build the cue index of:%s\n",
+            webm_file.filename().c_str());
+    return false;
+  }
+
+  vector<uint8> buffer;
+  if (!webm_tools::SerializeWebMCueIndex(index, compressed, &buffer)) {
+    fprintf(stderr, "Could not serialize the cue index of:%s\n",
+            webm_file.filename().c_str());
+    return false;
+  }
+
+  const string path =
+      webm_file.filename() + webm_tools::kWebMCueIndexExtension;
+  return webm_tools::WriteFileAtomically(path, &buffer[0], buffer.size());
+}
+
+}  // namespace webm_dash
@@ -0,0 +1,34 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBM_DASH_MANIFEST_CUE_INDEX_FILE_H_
+#define WEBM_DASH_MANIFEST_CUE_INDEX_FILE_H_
+
+namespace webm_tools {
+class WebMFile;
+struct WebMCueIndex;
+}  // namespace webm_tools
+
+namespace webm_dash {
+
+// Builds the cue index of |webm_file|, with one entry per CuePoint. Returns
+// false if the file has no Cues or the Cues cannot be read.
+bool BuildCueIndex(const webm_tools::WebMFile& webm_file,
+                   webm_tools::WebMCueIndex* index);
+
+// Writes the cue index of |webm_file| next to it, to its filename followed
+// by |webm_tools::kWebMCueIndexExtension|. The entries are compressed when
+// |compressed| is true. Returns true if the file was written.
+bool WriteCueIndexFile(const webm_tools::WebMFile& webm_file,
+                       bool compressed);
+
+}  // namespace webm_dash
+
+#endif  // WEBM_DASH_MANIFEST_CUE_INDEX_FILE_H_
@@ -13,13 +13,18 @@
 #include <cstdio>
 
 #include "adaptation_set.h"
-#include "indent.h"
+#include "cue_index_file.h"
 #include "period.h"
+#include "representation.h"
+#include "task_runner.h"
 #include "webm_file.h"
+#include "webm_file_cache.h"
+#include "xml_writer.h"
 
 using std::string;
 using std::vector;
 using webm_tools::WebMFile;
+using webm_tools::XmlWriter;
 
 namespace webm_dash {
 
@@ -27,8 +32,8 @@ typedef vector<AdaptationSet*>::iterator AdaptationSetIterator;
 typedef vector<AdaptationSet*>::const_iterator AdaptationSetConstIterator;
 typedef vector<Period*>::iterator PeriodIterator;
 typedef vector<Period*>::const_iterator PeriodConstIterator;
-typedef vector<WebMFile*>::iterator WebMFileIterator;
-typedef vector<WebMFile*>::const_iterator WebMFileConstIterator;
+typedef vector<std::shared_ptr<const WebMFile> >::const_iterator
+    WebMFileConstIterator;
 
 const char DashModel::webm_on_demand[] =
     "urn:webm:dash:profile:webm-on-demand:2012";
@@ -44,7 +49,11 @@ DashModel::DashModel()
       duration_(0.0),
       min_buffer_time_(1.0),
       profile_(DashModel::webm_on_demand),
-      output_filename_("manifest.mpd") {
+      webm_file_cache_(NULL),
+      output_filename_("manifest.mpd"),
+      cue_index_format_(kNoCueIndex),
+      output_segment_list_(false),
+      num_threads_(0) {
 }
 
 DashModel::~DashModel() {
@@ -61,24 +70,23 @@ DashModel::~DashModel() {
     const Period* const period = *period_iter;
     delete period;
   }
-
-  for (WebMFileIterator webm_iter = webm_files_.begin();
-      webm_iter != webm_files_.end();
-      ++webm_iter) {
-    const WebMFile* const webm = *webm_iter;
-    delete webm;
-  }
 }
 
 bool DashModel::Init() {
   for (vector<string>::const_iterator file_iter = webm_filenames_.begin();
        file_iter != webm_filenames_.end();
        ++file_iter) {
-    std::unique_ptr<WebMFile> webm(new (std::nothrow) WebMFile());  // NOLINT
+    std::shared_ptr<const WebMFile> webm;
+    if (webm_file_cache_) {
+      webm = webm_file_cache_->GetWebMFile(*file_iter);
+    } else {
+      std::shared_ptr<WebMFile> parsed(
+          new (std::nothrow) WebMFile());  // NOLINT
+      if (parsed.get() && parsed->ParseFile(*file_iter))
+        webm = parsed;
+    }
     if (!webm.get())
       return false;
-    if (!webm->ParseFile(*file_iter))
-      return false;
 
     if (profile_ == DashModel::webm_on_demand) {
       if (!webm->OnlyOneStream()) {
@@ -86,7 +94,7 @@ bool DashModel::Init() {
       }
     }
 
-    webm_files_.push_back(webm.release());
+    webm_files_.push_back(webm);
   }
 
   AdaptationSetIterator as_iter;
@@ -98,6 +106,8 @@ bool DashModel::Init() {
       return false;
   }
 
+  ComputeManifestValues();
+
   // If no periods have been added on the command line add one by default.
   if (periods_.empty())
     AddPeriod();
@@ -203,12 +213,49 @@ const WebMFile* DashModel::FindWebMFile(const string& filename) const {
       iter != webm_files_.end();
       ++iter) {
     if ((*iter)->filename() == filename)
-      return *iter;
+      return iter->get();
   }
 
   return NULL;
 }
 
+void DashModel::ComputeManifestValues() {
+  // Each Representation is computed against the first Representation of its
+  // AdaptationSet. The WebM files are fully parsed by Init(), so the workers
+  // only read them.
+  vector<Representation*> representations;
+  vector<const Representation*> goldens;
+  for (AdaptationSetConstIterator as_iter = adaptation_sets_.begin();
+      as_iter != adaptation_sets_.end();
+      ++as_iter) {
+    const vector<Representation*>& list = (*as_iter)->representations();
+    for (size_t i = 0; i < list.size(); ++i) {
+      representations.push_back(list[i]);
+      goldens.push_back(i > 0 ? list[0] : NULL);
+    }
+  }
+
+  RunTasks(representations.size(), num_threads_, [&](size_t i) {
+    representations[i]->ComputeManifestValues(goldens[i]);
+  });
+
+  for (AdaptationSetIterator as_iter = adaptation_sets_.begin();
+      as_iter != adaptation_sets_.end();
+      ++as_iter) {
+    (*as_iter)->ComputeManifestValues();
+  }
+}
+
+bool DashModel::OutputDashManifest(string* manifest) const {
+  if (!manifest)
+    return false;
+
+  XmlWriter writer;
+  WriteDashManifest(&writer);
+  writer.Release(manifest);
+  return true;
+}
+
 bool DashModel::OutputDashManifestFile() const {
   if (output_filename_.empty())
     return false;
@@ -217,37 +264,70 @@ bool DashModel::OutputDashManifestFile() const {
   if (!o)
     return false;
 
-  fprintf(o, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-  fprintf(o, "<MPD\n");
+  XmlWriter writer(o);
+  WriteDashManifest(&writer);
+  const bool flushed = writer.Flush();
+  if (fclose(o) || !flushed) {
+    fprintf(stderr, "Could not write manifest:%s\n",
+            output_filename_.c_str());
+    return false;
+  }
+
+  return true;
+}
 
-  fprintf(o, "  %s\n", xml_schema_location);
-  fprintf(o, "  %s\n", xml_namespace);
-  fprintf(o, "  %s\n", xml_namespace_location);
+bool DashModel::OutputCueIndexFiles() const {
+  if (cue_index_format_ == kNoCueIndex)
+    return true;
 
-  fprintf(o, "  type=\"%s\"\n", type_.c_str());
-  fprintf(o, "  mediaPresentationDuration=\"PT%gS\"\n", duration_);
-  fprintf(o, "  minBufferTime=\"PT%gS\"\n", min_buffer_time_);
-  fprintf(o, "  profiles=\"%s\"", profile_.c_str());
+  for (WebMFileConstIterator iter = webm_files_.begin();
+      iter != webm_files_.end();
+      ++iter) {
+    if (!WriteCueIndexFile(**iter, cue_index_format_ == kCompressedCueIndex))
+      return false;
+  }
 
-  fprintf(o, ">\n");
+  return true;
+}
 
+void DashModel::WriteDashManifest(XmlWriter* writer) const {
+  writer->Write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  writer->Write("<MPD\n");
+
+  writer->Write("  ");
+  writer->Write(xml_schema_location);
+  writer->Write("\n  ");
+  writer->Write(xml_namespace);
+  writer->Write("\n  ");
+  writer->Write(xml_namespace_location);
+  writer->Write("\n");
+
+  // The MPD attributes are written one per line.
+  writer->Write(" ");
+  writer->Attribute("type", type_);
+  writer->Write("\n ");
+  writer->DurationAttribute("mediaPresentationDuration", duration_);
+  writer->Write("\n ");
+  writer->DurationAttribute("minBufferTime", min_buffer_time_);
+  writer->Write("\n ");
+  writer->Attribute("profiles", profile_);
+  writer->EndStartTag();
+
+  writer->Adjust(webm_tools::kIncreaseIndent);
   for (vector<string>::const_iterator stri = base_urls_.begin();
       stri != base_urls_.end();
       ++stri) {
-    fprintf(o, "  <BaseURL>%s</BaseURL>\n", (*stri).c_str());
+    writer->TextElement("BaseURL", *stri);
   }
+  writer->Adjust(webm_tools::kDecreaseIndent);
 
-  webm_tools::Indent indent(0);
   for (PeriodConstIterator iter = periods_.begin();
       iter != periods_.end();
       ++iter) {
-    (*iter)->OutputDashManifest(o, &indent);
+    (*iter)->OutputDashManifest(writer);
   }
 
-  fprintf(o, "</MPD>\n");
-  fclose(o);
-
-  return true;
+  writer->EndElement("MPD");
 }
 
 }  // namespace webm_dash
@@ -11,6 +11,7 @@
 #ifndef WEBM_DASH_MANIFEST_DASH_MODEL_H_
 #define WEBM_DASH_MANIFEST_DASH_MODEL_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,12 +19,14 @@
 
 namespace webm_tools {
 class WebMFile;
+class XmlWriter;
 }  // namespace webm_tools
 
 namespace webm_dash {
 
 class AdaptationSet;
 class Period;
+class WebMFileCache;
 
 // This class models how the manifest should be laid out.
 class DashModel {
@@ -31,10 +34,17 @@ class DashModel {
   // WebM On-Demand profile.
   static const char webm_on_demand[];
 
+  // Layouts of the cue index files written by |OutputCueIndexFiles()|.
+  enum CueIndexFormat {
+    kNoCueIndex = 0,
+    kFixedCueIndex = 1,
+    kCompressedCueIndex = 2,
+  };
+
   DashModel();
   ~DashModel();
 
-  // Inits all of the media groups.
+  // Inits all of the media groups and computes the values of the manifest.
   bool Init();
 
   // Adds a new AdaptationSet that is controlled by the DashModel. If
@@ -67,10 +77,34 @@ class DashModel {
   // Search the webm file list for |filename|. If not found return NULL.
   const webm_tools::WebMFile* FindWebMFile(const std::string& filename) const;
 
+  // Write out the manifest to |manifest|.
+  bool OutputDashManifest(std::string* manifest) const;
+
   // Write out the manifest file to |output_filename_|.
   bool OutputDashManifestFile() const;
 
+  // Writes a cue index file next to each input WebM file, in the
+  // |cue_index_format_| layout. Does nothing if the format is kNoCueIndex.
+  bool OutputCueIndexFiles() const;
+
   double min_buffer_time() const { return min_buffer_time_; }
+  CueIndexFormat cue_index_format() const { return cue_index_format_; }
+  void set_cue_index_format(CueIndexFormat format) {
+    cue_index_format_ = format;
+  }
+  bool output_segment_list() const { return output_segment_list_; }
+  void set_output_segment_list(bool output) { output_segment_list_ = output; }
+  int num_threads() const { return num_threads_; }
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+  // Sets the cache |Init()| gets the WebM files from. When NULL, the default,
+  // the files are parsed by the DashModel. This class does not own the
+  // pointer.
+  void set_webm_file_cache(WebMFileCache* cache) {
+    webm_file_cache_ = cache;
+  }
+  const std::vector<std::string>& webm_filenames() const {
+    return webm_filenames_;
+  }
 
   std::string output_filename() const { return output_filename_; }
   void set_output_filename(const std::string& file) {
@@ -80,6 +114,14 @@ class DashModel {
   void set_profile(const std::string& profile) { profile_ = profile; }
 
  private:
+  // Computes the values of all the Representations on |num_threads_|
+  // worker threads, then the values of all the AdaptationSets. The output
+  // functions only read the computed values.
+  void ComputeManifestValues();
+
+  // Writes the manifest to |writer|.
+  void WriteDashManifest(webm_tools::XmlWriter* writer) const;
+
   // XML Schema location.
   static const char xml_schema_location[];
 
@@ -107,8 +149,12 @@ class DashModel {
   // List of input WebM filenames.
   std::vector<std::string> webm_filenames_;
 
-  // List of input WebM files.
-  std::vector<webm_tools::WebMFile*> webm_files_;
+  // List of input WebM files. The files may be shared with other DashModels
+  // through |webm_file_cache_|.
+  std::vector<std::shared_ptr<const webm_tools::WebMFile> > webm_files_;
+
+  // Cache of parsed WebM files. This class does not own the pointer.
+  WebMFileCache* webm_file_cache_;
 
   // Adaptation set list for a presentation.
   std::vector<AdaptationSet*> adaptation_sets_;
@@ -119,6 +165,17 @@ class DashModel {
   // Path to output the manifest.
   std::string output_filename_;
 
+  // Layout of the cue index files.
+  CueIndexFormat cue_index_format_;
+
+  // Flag telling if the Representations output a SegmentList with the byte
+  // range of every cue instead of a SegmentBase.
+  bool output_segment_list_;
+
+  // Number of threads computing the Representation values. 0 uses one
+  // thread per hardware thread.
+  int num_threads_;
+
   WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(DashModel);
 };
 
@@ -10,14 +10,12 @@
 
 #include "period.h"
 
-#include <cstdio>
-
 #include "adaptation_set.h"
-#include "indent.h"
+#include "xml_writer.h"
 
 using std::string;
 using std::vector;
-using webm_tools::Indent;
+using webm_tools::XmlWriter;
 
 namespace webm_dash {
 
@@ -67,22 +65,22 @@ void Period::AddAdaptationSet(const AdaptationSet* as) {
   adaptation_sets_.push_back(as);
 }
 
-void Period::OutputDashManifest(FILE* o, Indent* indent) const {
-  indent->Adjust(webm_tools::kIncreaseIndent);
-  fprintf(o, "%s<Period id=\"%s\"", indent->indent_str().c_str(), id_.c_str());
-
-  fprintf(o, " start=\"PT%gS\"", start_);
-  fprintf(o, " duration=\"PT%gS\"", duration_);
-  fprintf(o, " >\n");
+void Period::OutputDashManifest(XmlWriter* writer) const {
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->StartElement("Period");
+  writer->Attribute("id", id_);
+  writer->DurationAttribute("start", start_);
+  writer->DurationAttribute("duration", duration_);
+  writer->Write(" >\n");
 
   for (AdaptationSetConstIterator iter = adaptation_sets_.begin();
       iter != adaptation_sets_.end();
       ++iter) {
-    (*iter)->OutputDashManifest(o, indent);
+    (*iter)->OutputDashManifest(writer);
   }
 
-  fprintf(o, "%s</Period>\n", indent->indent_str().c_str());
-  indent->Adjust(webm_tools::kDecreaseIndent);
+  writer->EndElement("Period");
+  writer->Adjust(webm_tools::kDecreaseIndent);
 }
 
 }  // namespace adaptive_manifest
@@ -17,7 +17,7 @@
 #include "webm_tools_types.h"
 
 namespace webm_tools {
-class Indent;
+class XmlWriter;
 }  // namespace webm_tools
 
 namespace webm_dash {
@@ -46,7 +46,7 @@ class Period {
   void AddAdaptationSet(const AdaptationSet* as);
 
   // Outputs AdaptationSet in the prototype format.
-  void OutputDashManifest(FILE* o, webm_tools::Indent* indent) const;
+  void OutputDashManifest(webm_tools::XmlWriter* writer) const;
 
   double duration() const { return duration_; }
   void set_duration(double duration) { duration_ = duration; }
@@ -10,24 +10,32 @@
 
 #include "representation.h"
 
+#include <vector>
+
 #include "mkvparser/mkvreader.h"
 
 #include "dash_model.h"
-#include "indent.h"
 #include "webm_constants.h"
 #include "webm_file.h"
+#include "xml_writer.h"
 
 using std::string;
-using webm_tools::Indent;
+using webm_tools::CueDesc;
 using webm_tools::int64;
 using webm_tools::kNanosecondsPerSecond;
+using webm_tools::kNanosecondsPerSecondi;
 using webm_tools::WebMFile;
+using webm_tools::XmlWriter;
 
 namespace webm_dash {
 
 Representation::Representation(const string& id, const DashModel& dash)
     : dash_model_(dash),
       id_(id),
+      bandwidth_(0),
+      bitstream_switching_(false),
+      cues_aligned_(false),
+      subsegment_starts_with_sap_(false),
       output_audio_sample_rate_(true),
       output_header_(true),
       output_index_(true),
@@ -103,28 +111,23 @@ int Representation::GetVideoWidth() const {
   return webm_file_->VideoWidth();
 }
 
-bool Representation::OutputDashManifest(FILE* o, Indent* indent) const {
-  indent->Adjust(webm_tools::kIncreaseIndent);
-  fprintf(o, "%s<Representation id=\"%s\"", indent->indent_str().c_str(),
-          id_.c_str());
-
-  const int64 prebuffer_ns =
-      static_cast<int64>(dash_model_.min_buffer_time() *
-                         kNanosecondsPerSecond);
-  fprintf(o, " bandwidth=\"%lld\"",
-          webm_file_->PeakBitsPerSecondOverFile(prebuffer_ns));
+bool Representation::OutputDashManifest(XmlWriter* writer) const {
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->StartElement("Representation");
+  writer->Attribute("id", id_);
+  writer->Attribute("bandwidth", bandwidth_);
 
   // Video
   if (output_video_width_) {
     const int width = webm_file_->VideoWidth();
     if (width > 0) {
-      fprintf(o, " width=\"%d\"", width);
+      writer->Attribute("width", width);
     }
   }
   if (output_video_height_) {
     const int height = webm_file_->VideoHeight();
     if (height > 0) {
-      fprintf(o, " height=\"%d\"", height);
+      writer->Attribute("height", height);
     }
   }
 
@@ -134,28 +137,28 @@ bool Representation::OutputDashManifest(FILE* o, Indent* indent) const {
   // will most likely need to change later.
   const double rate = webm_file_->VideoFramerate();
   if (rate > 0.0) {
-    fprintf(o, " framerate=\"%g\"", rate);
+    writer->DoubleAttribute("framerate", rate);
   }
 
   if (output_audio_sample_rate_) {
     const int sample_rate = webm_file_->AudioSampleRate();
     if (sample_rate > 0) {
-      fprintf(o, " audioSamplingRate=\"%d\"", sample_rate);
+      writer->Attribute("audioSamplingRate", sample_rate);
     }
   }
-  fprintf(o, ">\n");
+  writer->EndStartTag();
 
-  indent->Adjust(webm_tools::kIncreaseIndent);
-  fprintf(o, "%s<BaseURL>%s</BaseURL>\n", indent->indent_str().c_str(),
-          webm_file_->filename().c_str());
-  indent->Adjust(webm_tools::kDecreaseIndent);
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->TextElement("BaseURL", webm_file_->filename());
+  writer->Adjust(webm_tools::kDecreaseIndent);
 
-  const bool b = OutputSegmentBase(o, indent);
+  const bool b = dash_model_.output_segment_list() ?
+      OutputSegmentList(writer) : OutputSegmentBase(writer);
   if (!b)
     return false;
 
-  fprintf(o, "%s</Representation>\n", indent->indent_str().c_str());
-  indent->Adjust(webm_tools::kDecreaseIndent);
+  writer->EndElement("Representation");
+  writer->Adjust(webm_tools::kDecreaseIndent);
 
   return true;
 }
@@ -169,14 +172,30 @@ bool Representation::SubsegmentStartsWithSAP() const {
   return webm_file_->CuesFirstInCluster(WebMFile::kUnknown);
 }
 
-bool Representation::OutputSegmentBase(FILE* o, Indent* indent) const {
+void Representation::ComputeManifestValues(const Representation* golden) {
+  if (!webm_file_)
+    return;
+
+  const int64 prebuffer_ns =
+      static_cast<int64>(dash_model_.min_buffer_time() *
+                         kNanosecondsPerSecond);
+  bandwidth_ = webm_file_->PeakBitsPerSecondOverFile(prebuffer_ns);
+  subsegment_starts_with_sap_ = SubsegmentStartsWithSAP();
+
+  if (golden) {
+    cues_aligned_ = CheckCuesAlignment(*golden);
+    bitstream_switching_ = BitstreamSwitching(*golden);
+  }
+}
+
+bool Representation::OutputSegmentBase(XmlWriter* writer) const {
   if (!output_header_ && !output_index_)
     return true;
   if (!webm_file_)
     return true;
 
-  indent->Adjust(webm_tools::kIncreaseIndent);
-  fprintf(o, "%s<SegmentBase", indent->indent_str().c_str());
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->StartElement("SegmentBase");
 
   if (output_index_) {
     if (!webm_file_->CheckForCues())
@@ -188,28 +207,106 @@ bool Representation::OutputSegmentBase(FILE* o, Indent* indent) const {
     const int64 end = start + cues->m_element_size;
 
     // Range is based off RFC 2616. All byte positions are inclusive.
-    fprintf(o, " indexRange=\"%lld-%lld\"", start, end - 1);
+    writer->RangeAttribute("indexRange", start, end - 1);
   }
 
   if (output_header_) {
-    fprintf(o, ">\n");
+    writer->EndStartTag();
 
     int64 start;
     int64 end;
     webm_file_->GetHeaderRange(&start, &end);
 
-    indent->Adjust(webm_tools::kIncreaseIndent);
-    fprintf(o, "%s<Initialization", indent->indent_str().c_str());
+    writer->Adjust(webm_tools::kIncreaseIndent);
+    writer->StartElement("Initialization");
 
     // Range is based off RFC 2616. All byte positions are inclusive.
-    fprintf(o, " range=\"%lld-%lld\" />\n", start, end - 1);
-    indent->Adjust(webm_tools::kDecreaseIndent);
+    writer->RangeAttribute("range", start, end - 1);
+    writer->EndEmptyElement();
+    writer->Adjust(webm_tools::kDecreaseIndent);
 
-    fprintf(o, "%s</SegmentBase>\n", indent->indent_str().c_str());
+    writer->EndElement("SegmentBase");
   } else {
-    fprintf(o, " />\n");
+    writer->EndEmptyElement();
   }
-  indent->Adjust(webm_tools::kDecreaseIndent);
+  writer->Adjust(webm_tools::kDecreaseIndent);
+
+  return true;
+}
+
+bool Representation::OutputSegmentList(XmlWriter* writer) const {
+  if (!webm_file_)
+    return true;
+
+  if (!webm_file_->CheckForCues())
+    return false;
+  const std::vector<CueDesc>& cue_descs = webm_file_->cue_desc_list();
+  if (cue_descs.empty())
+    return false;
+
+  const int64 timecode_scale = webm_file_->OutputTimecodeScale();
+
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  writer->StartElement("SegmentList");
+  writer->Attribute("timescale", kNanosecondsPerSecondi / timecode_scale);
+  writer->EndStartTag();
+  writer->Adjust(webm_tools::kIncreaseIndent);
+
+  if (output_header_) {
+    int64 start;
+    int64 end;
+    webm_file_->GetHeaderRange(&start, &end);
+
+    // Range is based off RFC 2616. All byte positions are inclusive.
+    writer->StartElement("Initialization");
+    writer->RangeAttribute("range", start, end - 1);
+    writer->EndEmptyElement();
+  }
+
+  // Runs of cues with the same duration are output as one S element.
+  writer->StartElement("SegmentTimeline");
+  writer->EndStartTag();
+  writer->Adjust(webm_tools::kIncreaseIndent);
+  size_t i = 0;
+  while (i < cue_descs.size()) {
+    const int64 start = cue_descs[i].start_time_ns / timecode_scale;
+    const int64 duration =
+        cue_descs[i].end_time_ns / timecode_scale - start;
+    int64 run_end = start + duration;
+    int64 repeat = 0;
+    for (++i; i < cue_descs.size(); ++i) {
+      const CueDesc& desc = cue_descs[i];
+      if (desc.start_time_ns / timecode_scale != run_end ||
+          desc.end_time_ns / timecode_scale - run_end != duration) {
+        break;
+      }
+      run_end += duration;
+      ++repeat;
+    }
+
+    writer->StartElement("S");
+    writer->Attribute("t", start);
+    writer->Attribute("d", duration);
+    if (repeat > 0)
+      writer->Attribute("r", repeat);
+    writer->EndEmptyElement();
+  }
+  writer->Adjust(webm_tools::kDecreaseIndent);
+  writer->EndElement("SegmentTimeline");
+
+  // CueDesc offsets are relative to the Segment payload.
+  const int64 segment_start = webm_file_->GetSegmentStartOffset();
+  for (size_t i = 0; i < cue_descs.size(); ++i) {
+    writer->StartElement("SegmentURL");
+    writer->RangeAttribute("mediaRange",
+                           segment_start + cue_descs[i].start_offset,
+                           segment_start + cue_descs[i].end_offset - 1);
+    writer->EndEmptyElement();
+  }
+
+  writer->Adjust(webm_tools::kDecreaseIndent);
+  writer->EndElement("SegmentList");
+  writer->Adjust(webm_tools::kDecreaseIndent);
 
   return true;
 }
@@ -17,7 +17,7 @@
 #include "webm_tools_types.h"
 
 namespace webm_tools {
-class Indent;
+class XmlWriter;
 class WebMFile;
 }  // namespace webm_tools
 
@@ -71,12 +71,24 @@ class Representation {
 
   // Outputs Representation in the Dash format. Returns true if there were no
   // errors with the output.
-  bool OutputDashManifest(FILE* o, webm_tools::Indent* indent) const;
+  bool OutputDashManifest(webm_tools::XmlWriter* writer) const;
 
   // Check all the subsegments within the Representation to see if they
   // conform to the subsegmentStartsWithSAP attribute.
   bool SubsegmentStartsWithSAP() const;
 
+  // Computes the values output by OutputDashManifest() and read by the
+  // AdaptationSet. If |golden| is not NULL the cues alignment and bitstream
+  // switching are checked against |golden|. Only reads the parsed WebM
+  // files, so different Representations may be computed concurrently.
+  void ComputeManifestValues(const Representation* golden);
+
+  webm_tools::int64 bandwidth() const { return bandwidth_; }
+  bool bitstream_switching() const { return bitstream_switching_; }
+  bool cues_aligned() const { return cues_aligned_; }
+  bool subsegment_starts_with_sap() const {
+    return subsegment_starts_with_sap_;
+  }
   std::string id() const { return id_; }
   void set_id(const std::string& id) { id_ = id; }
 
@@ -102,7 +114,12 @@ class Representation {
  private:
   // Outputs SegmentBase in the Dash format. Returns true if there were no
   // errors with the output.
-  bool OutputSegmentBase(FILE* o, webm_tools::Indent* indent) const;
+  bool OutputSegmentBase(webm_tools::XmlWriter* writer) const;
+
+  // Outputs SegmentList in the Dash format, with a SegmentTimeline and one
+  // SegmentURL per cue so clients do not have to fetch the Cues first.
+  // Returns true if there were no errors with the output.
+  bool OutputSegmentList(webm_tools::XmlWriter* writer) const;
 
   // The main class for the manifest.
   const DashModel& dash_model_;
@@ -112,6 +129,17 @@ class Representation {
   // adaptation set.
   std::string id_;
 
+  // Values set by ComputeManifestValues().
+  // Peak bandwidth over the file in bits per second.
+  webm_tools::int64 bandwidth_;
+  // Flag telling if the bitstream switching check passed against the golden
+  // Representation.
+  bool bitstream_switching_;
+  // Flag telling if the cues are aligned with the golden Representation.
+  bool cues_aligned_;
+  // Flag telling if all the subsegments start with a SAP.
+  bool subsegment_starts_with_sap_;
+
   // Flag telling if the class should output audio sample rate.
   bool output_audio_sample_rate_;
 
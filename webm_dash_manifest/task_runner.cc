@@ -0,0 +1,45 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "task_runner.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace webm_dash {
+
+int HardwareThreadCount() {
+  const int count = static_cast<int>(std::thread::hardware_concurrency());
+  return count > 0 ? count : 1;
+}
+
+void RunTasks(size_t num_tasks, int num_threads,
+              const std::function<void(size_t)>& task) {
+  if (num_threads <= 0)
+    num_threads = HardwareThreadCount();
+  if (static_cast<size_t>(num_threads) > num_tasks)
+    num_threads = static_cast<int>(num_tasks);
+
+  std::atomic<size_t> next_index(0);
+  const auto worker = [&]() {
+    for (size_t i = next_index++; i < num_tasks; i = next_index++)
+      task(i);
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i)
+    threads.push_back(std::thread(worker));
+  worker();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+}
+
+}  // namespace webm_dash
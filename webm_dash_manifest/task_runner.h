@@ -0,0 +1,31 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBM_DASH_MANIFEST_TASK_RUNNER_H_
+#define WEBM_DASH_MANIFEST_TASK_RUNNER_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace webm_dash {
+
+// Returns the number of hardware threads, or 1 if it is not known.
+int HardwareThreadCount();
+
+// Calls |task| with each index in [0, |num_tasks|) on up to |num_threads|
+// threads, the calling thread included. Idle threads take the next index, so
+// long tasks do not hold up the others. A |num_threads| of 0 or less uses
+// |HardwareThreadCount()| threads. Returns when all the tasks are done.
+void RunTasks(size_t num_tasks, int num_threads,
+              const std::function<void(size_t)>& task);
+
+}  // namespace webm_dash
+
+#endif  // WEBM_DASH_MANIFEST_TASK_RUNNER_H_
@@ -8,33 +8,61 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "adaptation_set.h"
+#include "cue_index_file.h"
 #include "dash_model.h"
 #include "period.h"
 #include "representation.h"
+#include "task_runner.h"
+#include "webm_file.h"
+#include "webm_file_cache.h"
 
 using std::string;
+using std::vector;
 using webm_dash::DashModel;
 using webm_dash::AdaptationSet;
 using webm_dash::Period;
 using webm_dash::Representation;
+using webm_dash::WebMFileCache;
 
 static const char VERSION_STRING[] = "1.0.3.0";
 
 static void Usage() {
   printf("Usage: webm_dash_manifest [-o output_file] [-p options] ");
   printf("<-as [as options] <-r [r options]>... >...\n");
+  printf("       webm_dash_manifest -batch <job_file> [-threads <int>]\n");
   printf("\n");
   printf("Main options:\n");
   printf("-h | -?               show help\n");
   printf("-v                    show version\n");
   printf("-url <string> [...]   Base URL list\n");
   printf("-profile <string>     Set profile.\n");
+  printf("-threads <int>        Threads computing the Representations.\n");
+  printf("                      0 uses all hardware threads. (Default 0)\n");
+  printf("-segment_list         Output a SegmentList with the byte range\n");
+  printf("                      of every cue instead of a SegmentBase.\n");
+  printf("-cue_index <string>   Write a cue index next to each input file.\n");
+  printf("                      fixed or compressed.\n");
+  printf("-batch <string>       Job file. Each line holds the options of one\n");
+  printf("                      manifest. Input files shared by several\n");
+  printf("                      manifests are parsed once. Lines starting\n");
+  printf("                      with # are ignored.\n");
   printf("\n");
   printf("Period (-p) options:\n");
   printf("-duration <double>    duration in seconds\n");
@@ -142,7 +170,8 @@ static void ParseRepresentationOptions(const string& option_list,
 
 static bool ParseMainCommandLine(int argc,
                                  char* argv[],
-                                 DashModel* model) {
+                                 DashModel* model,
+                                 string* job_filename) {
   if (argc < 2) {
     Usage();
     return false;
@@ -184,19 +213,246 @@ static bool ParseMainCommandLine(int argc,
       model->AppendBaseUrl(argv[++i]);
     } else if (!strcmp("-profile", argv[i]) && i < argc_check) {
       model->set_profile(argv[++i]);
+    } else if (!strcmp("-segment_list", argv[i])) {
+      model->set_output_segment_list(true);
+    } else if (!strcmp("-cue_index", argv[i]) && i < argc_check) {
+      const string format(argv[++i]);
+      if (format == "fixed") {
+        model->set_cue_index_format(DashModel::kFixedCueIndex);
+      } else if (format == "compressed") {
+        model->set_cue_index_format(DashModel::kCompressedCueIndex);
+      } else {
+        fprintf(stderr, "Unknown cue index format:%s\n", format.c_str());
+        return false;
+      }
+    } else if (!strcmp("-threads", argv[i]) && i < argc_check) {
+      model->set_num_threads(strtol(argv[++i], NULL, 10));
+    } else if (!strcmp("-batch", argv[i]) && i < argc_check) {
+      if (!job_filename) {
+        fprintf(stderr, "-batch is not allowed in a job.\n");
+        return false;
+      }
+      *job_filename = argv[++i];
+    }
+  }
+
+  return true;
+}
+
+// A manifest of a batch.
+struct BatchJob {
+  BatchJob() : line(0), init_ok(false), output_ok(false),
+               init_seconds(0.0), output_seconds(0.0) {}
+
+  // Line of the job in the job file.
+  int line;
+
+  // Released once the job has run, so the model does not keep its input
+  // files open.
+  std::unique_ptr<DashModel> model;
+  string output_filename;
+
+  // Distinct input files of |model|.
+  vector<string> filenames;
+
+  bool init_ok;
+  bool output_ok;
+  double init_seconds;
+  double output_seconds;
+};
+
+static double SecondsSince(const std::chrono::steady_clock::time_point& t) {
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - t;
+  return elapsed.count();
+}
+
+// Reads the jobs of |job_filename|. Each job gets its WebM files from
+// |cache|. Returns false if a job is not valid.
+static bool ReadBatchJobs(const string& job_filename, WebMFileCache* cache,
+                          vector<std::unique_ptr<BatchJob> >* jobs) {
+  std::ifstream job_file(job_filename.c_str());
+  if (!job_file) {
+    fprintf(stderr, "Could not open job file:%s\n", job_filename.c_str());
+    return false;
+  }
+
+  std::set<string> output_filenames;
+  string line;
+  for (int line_number = 1; std::getline(job_file, line); ++line_number) {
+    std::istringstream line_stream(line);
+    vector<string> args(1, "webm_dash_manifest");
+    string arg;
+    while (line_stream >> arg)
+      args.push_back(arg);
+    if (args.size() < 2 || args[1][0] == '#')
+      continue;
+
+    vector<char*> argv;
+    for (size_t i = 0; i < args.size(); ++i)
+      argv.push_back(&args[i][0]);
+
+    std::unique_ptr<BatchJob> job(new (std::nothrow) BatchJob());  // NOLINT
+    if (!job.get())
+      return false;
+    job->line = line_number;
+    job->model.reset(new (std::nothrow) DashModel());  // NOLINT
+    if (!job->model.get())
+      return false;
+    if (!ParseMainCommandLine(static_cast<int>(argv.size()), &argv[0],
+                              job->model.get(), NULL)) {
+      fprintf(stderr, "Job on line %d is not valid.\n", line_number);
+      return false;
+    }
+    if (!output_filenames.insert(job->model->output_filename()).second) {
+      fprintf(stderr, "Job on line %d output:%s is duplicate.\n",
+              line_number, job->model->output_filename().c_str());
+      return false;
     }
+
+    job->output_filename = job->model->output_filename();
+    const vector<string>& filenames = job->model->webm_filenames();
+    const std::set<string> filename_set(filenames.begin(), filenames.end());
+    job->filenames.assign(filename_set.begin(), filename_set.end());
+
+    // The jobs run concurrently, so each job computes on one thread.
+    job->model->set_num_threads(1);
+    job->model->set_webm_file_cache(cache);
+    jobs->push_back(std::move(job));
   }
 
   return true;
 }
 
+// Sets |cue_index_files| to the input files of |jobs| that need a cue index
+// file, mapped to true for the compressed format. Returns false if two jobs
+// ask for different formats for the same file.
+static bool GetCueIndexFiles(const vector<std::unique_ptr<BatchJob> >& jobs,
+                             std::map<string, bool>* cue_index_files) {
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const BatchJob& job = *jobs[i];
+    const DashModel::CueIndexFormat format = job.model->cue_index_format();
+    if (format == DashModel::kNoCueIndex)
+      continue;
+    const bool compressed = format == DashModel::kCompressedCueIndex;
+    for (size_t j = 0; j < job.filenames.size(); ++j) {
+      const std::pair<std::map<string, bool>::iterator, bool> result =
+          cue_index_files->insert(std::make_pair(job.filenames[j],
+                                                 compressed));
+      if (result.first->second != compressed) {
+        fprintf(stderr, "Job on line %d cue index format of:%s conflicts "
+                "with an earlier job.\n", job.line, job.filenames[j].c_str());
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Writes the manifests of the jobs in |job_filename| using |num_threads|
+// threads. Each input file is parsed once, by the first job using it, and
+// released after the last job using it. Cue index files are written by the
+// first job using their file. Returns true if all the jobs succeeded.
+static bool RunBatch(const string& job_filename, int num_threads) {
+  WebMFileCache cache;
+  vector<std::unique_ptr<BatchJob> > jobs;
+  if (!ReadBatchJobs(job_filename, &cache, &jobs))
+    return false;
+
+  std::map<string, bool> cue_index_files;
+  if (!GetCueIndexFiles(jobs, &cue_index_files))
+    return false;
+
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    for (size_t j = 0; j < jobs[i]->filenames.size(); ++j)
+      cache.AddUser(jobs[i]->filenames[j]);
+  }
+
+  // Guards |cue_index_written|.
+  std::mutex cue_index_mutex;
+  std::set<string> cue_index_written;
+  std::atomic<int> cue_index_failed(0);
+
+  const std::chrono::steady_clock::time_point jobs_start =
+      std::chrono::steady_clock::now();
+  webm_dash::RunTasks(jobs.size(), num_threads, [&](size_t i) {
+    BatchJob* const job = jobs[i].get();
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    job->init_ok = job->model->Init();
+    job->init_seconds = SecondsSince(start);
+    if (job->init_ok) {
+      start = std::chrono::steady_clock::now();
+      job->output_ok = job->model->OutputDashManifestFile();
+      job->output_seconds = SecondsSince(start);
+    }
+    job->model.reset();
+
+    for (size_t j = 0; j < job->filenames.size(); ++j) {
+      const string& filename = job->filenames[j];
+      const std::map<string, bool>::const_iterator cue_index =
+          cue_index_files.find(filename);
+      if (cue_index != cue_index_files.end()) {
+        bool write = false;
+        {
+          std::lock_guard<std::mutex> lock(cue_index_mutex);
+          write = cue_index_written.insert(filename).second;
+        }
+        if (write) {
+          const std::shared_ptr<const webm_tools::WebMFile> webm =
+              cache.GetWebMFile(filename);
+          if (!webm.get() ||
+              !webm_dash::WriteCueIndexFile(*webm, cue_index->second)) {
+            ++cue_index_failed;
+          }
+        }
+      }
+      cache.Release(filename);
+    }
+  });
+  const double jobs_seconds = SecondsSince(jobs_start);
+
+  int failed = 0;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const BatchJob& job = *jobs[i];
+    const char* status = "ok";
+    if (!job.init_ok)
+      status = "Init() failed";
+    else if (!job.output_ok)
+      status = "OutputDashManifestFile() failed";
+    if (!job.init_ok || !job.output_ok)
+      ++failed;
+
+    printf("line %d %s: init %.3f ms, output %.3f ms, %s\n", job.line,
+           job.output_filename.c_str(), job.init_seconds * 1000.0,
+           job.output_seconds * 1000.0, status);
+  }
+  printf("Parsed %d files (%.3f ms of parsing).\n", cache.num_parsed(),
+         cache.parse_seconds() * 1000.0);
+  printf("Ran %d jobs in %.3f ms, %d failed.\n",
+         static_cast<int>(jobs.size()), jobs_seconds * 1000.0, failed);
+  if (!cue_index_files.empty()) {
+    printf("Wrote %d cue index files, %d failed.\n",
+           static_cast<int>(cue_index_files.size()),
+           static_cast<int>(cue_index_failed));
+  }
+
+  return failed == 0 && cue_index_failed == 0;
+}
+
 int main(int argc, char* argv[]) {
   DashModel model;
+  string job_filename;
 
-  if (!ParseMainCommandLine(argc, argv, &model)) {
+  if (!ParseMainCommandLine(argc, argv, &model, &job_filename)) {
     return EXIT_FAILURE;
   }
 
+  if (!job_filename.empty()) {
+    return RunBatch(job_filename, model.num_threads()) ? EXIT_SUCCESS :
+                                                         EXIT_FAILURE;
+  }
+
   if (!model.Init()) {
     fprintf(stderr, "Manifest Model Init() Failed.\n");
     return EXIT_FAILURE;
@@ -207,5 +463,10 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (!model.OutputCueIndexFiles()) {
+    fprintf(stderr, "OutputCueIndexFiles() Failed.\n");
+    return EXIT_FAILURE;
+  }
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webm_file_cache.h"
+
+#include <chrono>
+#include <new>
+
+#include "webm_file.h"
+
+using std::string;
+using webm_tools::WebMFile;
+
+namespace webm_dash {
+
+WebMFileCache::WebMFileCache()
+    : num_parsed_(0),
+      parse_seconds_(0.0) {
+}
+
+WebMFileCache::~WebMFileCache() {
+}
+
+std::shared_ptr<const WebMFile> WebMFileCache::GetWebMFile(
+    const string& filename) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry = FindOrAddEntry(filename);
+    if (!entry.get())
+      return std::shared_ptr<const WebMFile>();
+  }
+
+  std::lock_guard<std::mutex> entry_lock(entry->mutex);
+  if (entry->parsed)
+    return entry->webm_file;
+
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::shared_ptr<WebMFile> webm(new (std::nothrow) WebMFile());  // NOLINT
+  if (webm.get() && webm->ParseFile(filename))
+    entry->webm_file = webm;
+  entry->parsed = true;
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++num_parsed_;
+  parse_seconds_ += elapsed.count();
+  return entry->webm_file;
+}
+
+void WebMFileCache::AddUser(const string& filename) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::shared_ptr<Entry> entry = FindOrAddEntry(filename);
+  if (entry.get())
+    ++entry->users;
+}
+
+void WebMFileCache::Release(const string& filename) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, std::shared_ptr<Entry> >::iterator iter =
+      entries_.find(filename);
+  if (iter == entries_.end() || iter->second->users <= 0)
+    return;
+  if (--iter->second->users == 0)
+    entries_.erase(iter);
+}
+
+int WebMFileCache::num_parsed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_parsed_;
+}
+
+double WebMFileCache::parse_seconds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return parse_seconds_;
+}
+
+std::shared_ptr<WebMFileCache::Entry> WebMFileCache::FindOrAddEntry(
+    const string& filename) {
+  std::shared_ptr<Entry>& slot = entries_[filename];
+  if (!slot.get()) {
+    slot.reset(new (std::nothrow) Entry());  // NOLINT
+    if (!slot.get()) {
+      entries_.erase(filename);
+      return std::shared_ptr<Entry>();
+    }
+  }
+  return slot;
+}
+
+}  // namespace webm_dash
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBM_DASH_MANIFEST_WEBM_FILE_CACHE_H_
+#define WEBM_DASH_MANIFEST_WEBM_FILE_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "webm_tools_types.h"
+
+namespace webm_tools {
+class WebMFile;
+}  // namespace webm_tools
+
+namespace webm_dash {
+
+// Parsed WebM files shared by several DashModels, so a file used by many
+// manifests is only parsed once. The files are not modified after they are
+// parsed, so DashModels on different threads may read them concurrently.
+//
+// A parsed file holds its file open and its Segment in memory. To bound both
+// over a large catalog, callers declare the users of each file up front with
+// |AddUser()| and call |Release()| as each user finishes. The cache drops a
+// file after its last user, so a file is only open between its first and last
+// use.
+class WebMFileCache {
+ public:
+  WebMFileCache();
+  ~WebMFileCache();
+
+  // Returns the WebM file parsed from |filename|, parsing it on the first
+  // call. Returns NULL if the file could not be parsed, without trying to
+  // parse it again. Concurrent calls for the same file wait for one parse.
+  std::shared_ptr<const webm_tools::WebMFile> GetWebMFile(
+      const std::string& filename);
+
+  // Adds a user of |filename|. Files without users are kept until the cache
+  // is destroyed.
+  void AddUser(const std::string& filename);
+
+  // Ends a use of |filename| added with |AddUser()|. After the last user the
+  // cache drops the file, which is closed once no DashModel holds it.
+  void Release(const std::string& filename);
+
+  // Returns the number of files parsed, including the files that failed.
+  int num_parsed() const;
+
+  // Returns the time spent parsing files in seconds, summed over all the
+  // threads.
+  double parse_seconds() const;
+
+ private:
+  struct Entry {
+    Entry() : parsed(false), users(0) {}
+
+    // Held while the file is parsed.
+    std::mutex mutex;
+    bool parsed;
+    std::shared_ptr<const webm_tools::WebMFile> webm_file;
+
+    // Users left, guarded by |WebMFileCache::mutex_|.
+    int users;
+  };
+
+  // Returns the entry of |filename|, adding it if needed. Returns NULL on
+  // allocation failure. |mutex_| must be held.
+  std::shared_ptr<Entry> FindOrAddEntry(const std::string& filename);
+
+  // Guards the members below.
+  mutable std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<Entry> > entries_;
+  int num_parsed_;
+  double parse_seconds_;
+
+  WEBM_TOOLS_DISALLOW_COPY_AND_ASSIGN(WebMFileCache);
+};
+
+}  // namespace webm_dash
+
+#endif  // WEBM_DASH_MANIFEST_WEBM_FILE_CACHE_H_
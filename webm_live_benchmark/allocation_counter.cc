@@ -0,0 +1,63 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<int64_t> g_allocations(0);
+std::atomic<int64_t> g_allocated_bytes(0);
+
+void* CountedAlloc(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  return malloc(size ? size : 1);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* const ptr = CountedAlloc(size);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+void* operator new[](size_t size) {
+  void* const ptr = CountedAlloc(size);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+  return CountedAlloc(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) throw() {
+  return CountedAlloc(size);
+}
+void operator delete(void* ptr) throw() { free(ptr); }
+void operator delete[](void* ptr) throw() { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) throw() { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) throw() {
+  free(ptr);
+}
+
+namespace webm_live_benchmark {
+
+int64_t TotalAllocations() {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+int64_t TotalAllocatedBytes() {
+  return g_allocated_bytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace webm_live_benchmark
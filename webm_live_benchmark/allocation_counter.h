@@ -0,0 +1,50 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef WEBM_LIVE_BENCHMARK_ALLOCATION_COUNTER_H_
+#define WEBM_LIVE_BENCHMARK_ALLOCATION_COUNTER_H_
+
+#include <stdint.h>
+
+namespace webm_live_benchmark {
+
+// Linking allocation_counter.cc replaces the global operator new and delete
+// of the program, so every C++ heap allocation of every thread, including
+// libwebm's, is counted.
+
+// Returns the number of allocations made since the program started.
+int64_t TotalAllocations();
+
+// Returns the number of bytes allocated since the program started.
+int64_t TotalAllocatedBytes();
+
+// Counts the allocations made between |Start()| and |Stop()|.
+class AllocationCounter {
+ public:
+  AllocationCounter() : allocations_(0), bytes_(0) {}
+
+  void Start() {
+    allocations_ = TotalAllocations();
+    bytes_ = TotalAllocatedBytes();
+  }
+  void Stop() {
+    allocations_ = TotalAllocations() - allocations_;
+    bytes_ = TotalAllocatedBytes() - bytes_;
+  }
+
+  int64_t allocations() const { return allocations_; }
+  int64_t bytes() const { return bytes_; }
+
+ private:
+  int64_t allocations_;
+  int64_t bytes_;
+};
+
+}  // namespace webm_live_benchmark
+
+#endif  // WEBM_LIVE_BENCHMARK_ALLOCATION_COUNTER_H_
@@ -0,0 +1,82 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace webm_live_benchmark {
+
+LatencyHistogram::LatencyHistogram() : sorted_(true), sum_(0), max_(0) {
+  std::fill(buckets_, buckets_ + kNumBuckets, 0);
+}
+
+void LatencyHistogram::Add(int64_t latency_ns) {
+  if (latency_ns < 0)
+    latency_ns = 0;
+  int bucket = 0;
+  while (bucket < kNumBuckets - 1 && (latency_ns >> bucket) != 0)
+    ++bucket;
+  ++buckets_[bucket];
+
+  if (!samples_.empty() && latency_ns < samples_.back())
+    sorted_ = false;
+  samples_.push_back(latency_ns);
+  sum_ += latency_ns;
+  if (latency_ns > max_)
+    max_ = latency_ns;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) {
+  if (samples_.empty())
+    return 0;
+  if (!sorted_) {
+    std::sort(samples_.begin(), samples_.end());
+    sorted_ = true;
+  }
+  const double clamped = std::min(100.0, std::max(0.0, percentile));
+  // Nearest rank: the smallest sample with at least |percentile| percent of
+  // the samples at or below it.
+  const size_t rank =
+      static_cast<size_t>(std::ceil(clamped / 100.0 * samples_.size()));
+  return samples_[rank > 0 ? std::min(rank, samples_.size()) - 1 : 0];
+}
+
+double LatencyHistogram::mean() const {
+  return samples_.empty() ? 0.0 :
+      static_cast<double>(sum_) / samples_.size();
+}
+
+std::string LatencyHistogram::ToJson() {
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer),
+           "{\"count\":%zu,\"mean_ns\":%.0f,\"p50_ns\":%lld,\"p90_ns\":%lld,"
+           "\"p99_ns\":%lld,\"max_ns\":%lld,\"buckets\":[",
+           count(), mean(), static_cast<long long>(Percentile(50)),
+           static_cast<long long>(Percentile(90)),
+           static_cast<long long>(Percentile(99)),
+           static_cast<long long>(max_));
+  std::string json = buffer;
+  bool first = true;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    if (buckets_[i] == 0)
+      continue;
+    snprintf(buffer, sizeof(buffer), "%s[%lld,%lld]", first ? "" : ",",
+             static_cast<long long>(i == 0 ? 0 : (1LL << i) - 1),
+             static_cast<long long>(buckets_[i]));
+    json += buffer;
+    first = false;
+  }
+  json += "]}";
+  return json;
+}
+
+}  // namespace webm_live_benchmark
@@ -0,0 +1,61 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef WEBM_LIVE_BENCHMARK_LATENCY_HISTOGRAM_H_
+#define WEBM_LIVE_BENCHMARK_LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace webm_live_benchmark {
+
+// Latency samples in nanoseconds, summarized as percentiles and as a
+// histogram of power of two buckets. Bucket 0 counts samples of 0ns, and
+// bucket |b| samples in [2^(b-1), 2^b) ns.
+class LatencyHistogram {
+ public:
+  enum { kNumBuckets = 48 };
+
+  LatencyHistogram();
+
+  // Reserves room for |count| samples, so |Add()| does not allocate while
+  // allocations are counted.
+  void Reserve(size_t count) { samples_.reserve(count); }
+
+  // Adds a sample. Negative samples are counted as 0.
+  void Add(int64_t latency_ns);
+
+  // Returns the sample at percentile |percentile|, in [0, 100], or 0 when
+  // there are no samples.
+  int64_t Percentile(double percentile);
+
+  // Returns the summary as a JSON object with the count, mean, p50, p90,
+  // p99 and max in nanoseconds, and the non empty buckets as
+  // [upper bound, count] pairs.
+  std::string ToJson();
+
+  // Accessors.
+  size_t count() const { return samples_.size(); }
+  int64_t max() const { return max_; }
+  double mean() const;
+  int64_t bucket(int index) const { return buckets_[index]; }
+
+ private:
+  std::vector<int64_t> samples_;
+  bool sorted_;
+  int64_t sum_;
+  int64_t max_;
+  int64_t buckets_[kNumBuckets];
+};
+
+}  // namespace webm_live_benchmark
+
+#endif  // WEBM_LIVE_BENCHMARK_LATENCY_HISTOGRAM_H_
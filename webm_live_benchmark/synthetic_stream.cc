@@ -0,0 +1,83 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "synthetic_stream.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace webm_live_benchmark {
+
+namespace {
+
+const uint64_t kNanosecondsPerSecond = 1000000000;
+const uint64_t kNanosecondsPerMillisecond = 1000000;
+
+// Advances the linear congruential generator |seed| and returns a size in
+// [|min_size|, |max_size|].
+size_t NextSize(size_t min_size, size_t max_size, uint32_t* seed) {
+  *seed = *seed * 1103515245 + 12345;
+  return min_size + (*seed >> 8) % (max_size - min_size + 1);
+}
+
+}  // namespace
+
+std::vector<SyntheticFrame> MakeSyntheticStream(
+    const SyntheticStreamConfig& config) {
+  std::vector<SyntheticFrame> frames;
+  if ((!config.video && !config.audio) || config.num_video_frames <= 0 ||
+      config.video_frame_rate <= 0 || config.key_frame_interval <= 0 ||
+      config.audio_frame_duration_ms <= 0 ||
+      config.min_video_frame_size == 0 ||
+      config.min_video_frame_size > config.max_video_frame_size ||
+      config.min_audio_frame_size == 0 ||
+      config.min_audio_frame_size > config.max_audio_frame_size) {
+    fprintf(stderr, "Invalid synthetic stream configuration.\n");
+    return frames;
+  }
+
+  const uint64_t video_frame_duration_ns =
+      kNanosecondsPerSecond / config.video_frame_rate;
+  const uint64_t audio_frame_duration_ns =
+      config.audio_frame_duration_ms * kNanosecondsPerMillisecond;
+  uint32_t seed = 1;
+  uint64_t audio_timestamp = 0;
+  for (int i = 0; i < config.num_video_frames; ++i) {
+    const uint64_t video_timestamp = i * video_frame_duration_ns;
+    while (config.audio && audio_timestamp <= video_timestamp) {
+      const SyntheticFrame audio = {
+        audio_timestamp,
+        NextSize(config.min_audio_frame_size, config.max_audio_frame_size,
+                 &seed),
+        false, true };
+      frames.push_back(audio);
+      audio_timestamp += audio_frame_duration_ns;
+    }
+    if (!config.video)
+      continue;
+    const bool is_key = i % config.key_frame_interval == 0;
+    const size_t inter_size = NextSize(config.min_video_frame_size,
+                                       config.max_video_frame_size, &seed);
+    const SyntheticFrame video = {
+      video_timestamp, is_key ? config.key_frame_size : inter_size,
+      true, is_key };
+    frames.push_back(video);
+  }
+  return frames;
+}
+
+size_t MaxFrameSize(const std::vector<SyntheticFrame>& frames) {
+  size_t max_size = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frames[i].size > max_size)
+      max_size = frames[i].size;
+  }
+  return max_size;
+}
+
+}  // namespace webm_live_benchmark
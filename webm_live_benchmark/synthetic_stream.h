@@ -0,0 +1,74 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef WEBM_LIVE_BENCHMARK_SYNTHETIC_STREAM_H_
+#define WEBM_LIVE_BENCHMARK_SYNTHETIC_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace webm_live_benchmark {
+
+// Shape of a synthetic audio and video stream. The defaults describe 30 fps
+// video with a key frame every 2 seconds and 20ms audio packets.
+struct SyntheticStreamConfig {
+  SyntheticStreamConfig()
+      : video(true),
+        audio(true),
+        num_video_frames(9000),
+        video_frame_rate(30),
+        key_frame_interval(60),
+        min_video_frame_size(4 * 1024),
+        max_video_frame_size(40 * 1024),
+        key_frame_size(120 * 1024),
+        audio_frame_duration_ms(20),
+        min_audio_frame_size(120),
+        max_audio_frame_size(320) {
+  }
+
+  // Tracks of the stream. At least one must be enabled.
+  bool video;
+  bool audio;
+
+  // Duration of the stream in video frames, also used when |video| is false.
+  int num_video_frames;
+  int video_frame_rate;
+  int key_frame_interval;
+
+  // Inter frame sizes are uniformly distributed in
+  // [|min_video_frame_size|, |max_video_frame_size|].
+  size_t min_video_frame_size;
+  size_t max_video_frame_size;
+  size_t key_frame_size;
+
+  int audio_frame_duration_ms;
+  size_t min_audio_frame_size;
+  size_t max_audio_frame_size;
+};
+
+struct SyntheticFrame {
+  uint64_t timestamp_ns;
+  size_t size;
+  bool video;
+  bool is_key;
+};
+
+// Returns the frames of the stream described by |config|, interleaved in
+// timestamp order, or an empty vector when |config| is invalid. Sizes are
+// deterministic so runs can be compared.
+std::vector<SyntheticFrame> MakeSyntheticStream(
+    const SyntheticStreamConfig& config);
+
+// Returns the largest frame size of |frames|.
+size_t MaxFrameSize(const std::vector<SyntheticFrame>& frames);
+
+}  // namespace webm_live_benchmark
+
+#endif  // WEBM_LIVE_BENCHMARK_SYNTHETIC_STREAM_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+// Counts the heap allocations made per frame while live muxing. A synthetic
+// VP9 and Opus stream is muxed through WebMLiveMuxer directly and through
+// WebMAsyncLiveMuxer, and the allocations made after a warm up period are
+// reported per frame. The difference between the two runs is the cost of the
+// asynchronous front end, which should be zero once its frame pool is warm.
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "synthetic_stream.h"
+#include "webm_async_live_muxer.h"
+#include "webm_live_muxer.h"
+
+namespace {
+
+using webm_live_benchmark::AllocationCounter;
+using webm_live_benchmark::SyntheticFrame;
+using webm_live_benchmark::SyntheticStreamConfig;
+using webm_tools::WebMAsyncLiveMuxer;
+using webm_tools::WebMLiveMuxer;
+
+const int kKeyFrameInterval = SyntheticStreamConfig().key_frame_interval;
+
+bool AddTracks(WebMLiveMuxer* muxer) {
+  if (muxer->AddVideoTrack(1920, 1080, "V_VP9") < 1 ||
+      muxer->AddAudioTrack(48000, 2, NULL, 0, "A_OPUS") < 1) {
+    fprintf(stderr, "Cannot add tracks.\n");
+    return false;
+  }
+  return true;
+}
+
+void PrintResult(const char* run, const AllocationCounter& counter,
+                 size_t num_frames, int64_t chunks) {
+  printf("%-8s %10lld %14.3f %14.1f %8lld\n", run,
+         static_cast<long long>(counter.allocations()),
+         static_cast<double>(counter.allocations()) / num_frames,
+         static_cast<double>(counter.bytes()) / num_frames,
+         static_cast<long long>(chunks));
+}
+
+// Muxes |frames| with WebMLiveMuxer on the calling thread. Allocations made
+// for the frames after |warm_up|, and by |Finalize()|, are counted.
+bool RunDirect(const std::vector<SyntheticFrame>& frames, size_t warm_up,
+               const std::vector<uint8_t>& payload) {
+  WebMLiveMuxer muxer;
+  if (muxer.Init() != WebMLiveMuxer::kSuccess || !AddTracks(&muxer))
+    return false;
+
+  AllocationCounter counter;
+  WebMLiveMuxer::SharedChunk chunk;
+  int64_t chunks = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (i == warm_up)
+      counter.Start();
+    const SyntheticFrame& frame = frames[i];
+    const int status = frame.video ?
+        muxer.WriteVideoFrame(&payload[0], frame.size, frame.timestamp_ns,
+                              frame.is_key) :
+        muxer.WriteAudioFrame(&payload[0], frame.size, frame.timestamp_ns,
+                              frame.is_key);
+    if (status != WebMLiveMuxer::kSuccess) {
+      fprintf(stderr, "Cannot write frame %zu.\n", i);
+      return false;
+    }
+    webm_tools::int32 chunk_length = 0;
+    while (muxer.ChunkReady(&chunk_length)) {
+      if (muxer.ReadChunk(&chunk) != WebMLiveMuxer::kSuccess)
+        return false;
+      ++chunks;
+    }
+  }
+  if (muxer.Finalize() != WebMLiveMuxer::kSuccess)
+    return false;
+  counter.Stop();
+
+  PrintResult("direct", counter, frames.size() - warm_up, chunks);
+  return true;
+}
+
+// Muxes |frames| with WebMAsyncLiveMuxer, writing from the calling thread
+// and reading chunks with |PopChunk()|. Allocations of both threads made
+// after |warm_up| frames, and by |Finalize()|, are counted.
+bool RunAsync(const std::vector<SyntheticFrame>& frames, size_t warm_up,
+              const std::vector<uint8_t>& payload) {
+  WebMAsyncLiveMuxer async_muxer(64, 64, WebMAsyncLiveMuxer::kBlock);
+  if (async_muxer.Init() != WebMAsyncLiveMuxer::kSuccess ||
+      !AddTracks(async_muxer.muxer()) ||
+      async_muxer.Start(WebMAsyncLiveMuxer::ChunkCallback()) !=
+          WebMAsyncLiveMuxer::kSuccess) {
+    return false;
+  }
+
+  AllocationCounter counter;
+  WebMAsyncLiveMuxer::Chunk chunk;
+  int64_t chunks = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (i == warm_up)
+      counter.Start();
+    const SyntheticFrame& frame = frames[i];
+    const int status = frame.video ?
+        async_muxer.WriteVideoFrame(&payload[0], frame.size,
+                                    frame.timestamp_ns, frame.is_key) :
+        async_muxer.WriteAudioFrame(&payload[0], frame.size,
+                                    frame.timestamp_ns, frame.is_key);
+    if (status != WebMAsyncLiveMuxer::kSuccess) {
+      fprintf(stderr, "Cannot write frame %zu.\n", i);
+      return false;
+    }
+    while (async_muxer.PopChunk(&chunk))
+      ++chunks;
+  }
+  // Chunks are popped before |Finalize()| so the queue never fills up.
+  if (async_muxer.Finalize() != WebMAsyncLiveMuxer::kSuccess)
+    return false;
+  counter.Stop();
+  while (async_muxer.PopChunk(&chunk))
+    ++chunks;
+
+  PrintResult("async", counter, frames.size() - warm_up, chunks);
+  printf("  frame pool: %lld allocations, high water mark %zu bytes\n",
+         static_cast<long long>(async_muxer.frame_pool().allocations()),
+         async_muxer.frame_pool().high_water_mark());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int num_video_frames = 9000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp("-frames", argv[i]) && i + 1 < argc) {
+      num_video_frames = strtol(argv[++i], NULL, 10);
+    } else {
+      printf("Usage: webm_live_alloc_benchmark [-frames <int>]\n");
+      printf("  -frames <int>  Number of video frames muxed. (Default 9000)\n");
+      return argc == 2 && !strcmp("-h", argv[1]) ? EXIT_SUCCESS :
+                                                   EXIT_FAILURE;
+    }
+  }
+  if (num_video_frames < kKeyFrameInterval * 2) {
+    fprintf(stderr, "-frames must be at least %d.\n", kKeyFrameInterval * 2);
+    return EXIT_FAILURE;
+  }
+
+  SyntheticStreamConfig config;
+  config.num_video_frames = num_video_frames;
+  const std::vector<SyntheticFrame> frames =
+      webm_live_benchmark::MakeSyntheticStream(config);
+  // The first key frame interval warms up the muxer and the frame pool.
+  const size_t warm_up = frames.size() / (num_video_frames / kKeyFrameInterval);
+  std::vector<uint8_t> payload(webm_live_benchmark::MaxFrameSize(frames));
+  for (size_t i = 0; i < payload.size(); ++i)
+    payload[i] = static_cast<uint8_t>(i * 31 + 7);
+
+  printf("%-8s %10s %14s %14s %8s\n",
+         "run", "allocs", "allocs/frame", "bytes/frame", "chunks");
+  if (!RunDirect(frames, warm_up, payload) ||
+      !RunAsync(frames, warm_up, payload)) {
+    fprintf(stderr, "Benchmark failed.\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
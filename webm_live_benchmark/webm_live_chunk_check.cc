@@ -0,0 +1,232 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+// Checks that low latency chunks keep the Cluster boundaries. A synthetic
+// VP9 and Opus stream is muxed with whole Cluster chunks, with partial
+// chunks limited in bytes and with partial chunks limited in frames, and
+// each run is written through WebMSegmentFileChunkSink. Partial chunks only
+// change how the data is cut, so every run must produce the same
+// initialization and segment files.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "synthetic_stream.h"
+#include "webm_chunk_sink.h"
+#include "webm_live_muxer.h"
+
+namespace {
+
+using webm_live_benchmark::SyntheticFrame;
+using webm_live_benchmark::SyntheticStreamConfig;
+using webm_tools::WebMLiveMuxer;
+using webm_tools::WebMSegmentFileChunkSink;
+
+struct CheckRun {
+  const char* name;
+  int partial_chunk_frames;
+  webm_tools::int64 partial_chunk_bytes;
+};
+
+// Byte limit below the key frame size, so key frames complete a partial
+// chunk right after a Cluster start.
+const CheckRun kRuns[] = {
+  { "cluster", 0, 0 },
+  { "bytes", 0, 16 * 1024 },
+  { "frames", 2, 0 },
+};
+
+std::string InitPath(const std::string& dir, const char* run) {
+  return dir + "/" + run + "_init.webm";
+}
+
+std::string SegmentTemplate(const std::string& dir, const char* run) {
+  return dir + "/" + run + "_$Number$.webm";
+}
+
+// Muxes |frames| with the limits of |run| and writes every chunk to a
+// segment sink in |dir|. Stores the number of segments in
+// |ptr_segments|.
+bool MuxRun(const std::vector<SyntheticFrame>& frames,
+            const std::vector<uint8_t>& payload, const CheckRun& run,
+            const std::string& dir, webm_tools::int64* ptr_segments) {
+  WebMLiveMuxer muxer;
+  if (muxer.Init() != WebMLiveMuxer::kSuccess ||
+      muxer.AddVideoTrack(1920, 1080, "V_VP9") < 1 ||
+      muxer.AddAudioTrack(48000, 2, NULL, 0, "A_OPUS") < 1) {
+    fprintf(stderr, "%s: cannot set up the muxer.\n", run.name);
+    return false;
+  }
+  muxer.set_partial_chunk_frames(run.partial_chunk_frames);
+  muxer.set_partial_chunk_bytes(run.partial_chunk_bytes);
+
+  WebMSegmentFileChunkSink sink(InitPath(dir, run.name),
+                                SegmentTemplate(dir, run.name), 1);
+  if (!sink.Init())
+    return false;
+
+  webm_tools::int32 chunk_length = 0;
+  for (size_t i = 0; i <= frames.size(); ++i) {
+    if (i < frames.size()) {
+      const SyntheticFrame& frame = frames[i];
+      const int status = frame.video ?
+          muxer.WriteVideoFrame(&payload[0], frame.size, frame.timestamp_ns,
+                                frame.is_key) :
+          muxer.WriteAudioFrame(&payload[0], frame.size, frame.timestamp_ns,
+                                frame.is_key);
+      if (status != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "%s: cannot write frame %zu.\n", run.name, i);
+        return false;
+      }
+    } else if (muxer.Finalize() != WebMLiveMuxer::kSuccess) {
+      fprintf(stderr, "%s: cannot finalize.\n", run.name);
+      return false;
+    }
+    while (muxer.ChunkReady(&chunk_length)) {
+      if (muxer.WriteChunk(&sink) != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "%s: cannot write chunk.\n", run.name);
+        return false;
+      }
+    }
+  }
+  if (!sink.Close())
+    return false;
+  *ptr_segments = sink.segments_written();
+  return true;
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>* ptr_data) {
+  FILE* const file = fopen(path.c_str(), "rb");
+  if (!file) {
+    fprintf(stderr, "Cannot open %s.\n", path.c_str());
+    return false;
+  }
+  ptr_data->clear();
+  uint8_t buffer[4096];
+  size_t read = 0;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    ptr_data->insert(ptr_data->end(), buffer, buffer + read);
+  fclose(file);
+  return true;
+}
+
+// Returns true when |path| and |expected_path| hold the same bytes.
+bool SameFile(const std::string& path, const std::string& expected_path) {
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> expected;
+  if (!ReadFile(path, &data) || !ReadFile(expected_path, &expected))
+    return false;
+  if (data != expected) {
+    fprintf(stderr, "%s differs from %s.\n", path.c_str(),
+            expected_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Removes the files written by run |run|, including those of a failed run.
+void RemoveRunFiles(const std::string& dir, const char* run) {
+  WebMSegmentFileChunkSink sink(InitPath(dir, run),
+                                SegmentTemplate(dir, run), 1);
+  if (!sink.Init())
+    return;
+  unlink(InitPath(dir, run).c_str());
+  for (webm_tools::int64 number = 1;
+       unlink(sink.SegmentPath(number).c_str()) == 0; ++number) {
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int num_video_frames = 600;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp("-frames", argv[i]) && i + 1 < argc) {
+      num_video_frames = strtol(argv[++i], NULL, 10);
+    } else {
+      printf("Usage: webm_live_chunk_check [-frames <int>]\n");
+      printf("  -frames <int>  Number of video frames muxed. (Default 600)\n");
+      return argc == 2 && !strcmp("-h", argv[1]) ? EXIT_SUCCESS :
+                                                   EXIT_FAILURE;
+    }
+  }
+
+  SyntheticStreamConfig config;
+  if (num_video_frames < config.key_frame_interval * 2) {
+    fprintf(stderr, "-frames must be at least %d.\n",
+            config.key_frame_interval * 2);
+    return EXIT_FAILURE;
+  }
+  config.num_video_frames = num_video_frames;
+  const std::vector<SyntheticFrame> frames =
+      webm_live_benchmark::MakeSyntheticStream(config);
+  std::vector<uint8_t> payload(webm_live_benchmark::MaxFrameSize(frames));
+  for (size_t i = 0; i < payload.size(); ++i)
+    payload[i] = static_cast<uint8_t>(i * 31 + 7);
+
+  char dir_template[] = "/tmp/webm_live_chunk_check.XXXXXX";
+  if (!mkdtemp(dir_template)) {
+    fprintf(stderr, "Cannot create a temporary directory.\n");
+    return EXIT_FAILURE;
+  }
+  const std::string dir = dir_template;
+
+  const size_t num_runs = sizeof(kRuns) / sizeof(kRuns[0]);
+  std::vector<webm_tools::int64> segments(num_runs, 0);
+  bool ok = true;
+  for (size_t i = 0; ok && i < num_runs; ++i)
+    ok = MuxRun(frames, payload, kRuns[i], dir, &segments[i]);
+
+  // The first run, with whole Cluster chunks, is the reference.
+  const CheckRun& reference = kRuns[0];
+  if (ok && segments[0] < 2) {
+    fprintf(stderr, "%s: only %lld segments.\n", reference.name,
+            static_cast<long long>(segments[0]));
+    ok = false;
+  }
+  for (size_t i = 1; ok && i < num_runs; ++i) {
+    const CheckRun& run = kRuns[i];
+    if (segments[i] != segments[0]) {
+      fprintf(stderr, "%s: %lld segments, expected %lld.\n", run.name,
+              static_cast<long long>(segments[i]),
+              static_cast<long long>(segments[0]));
+      ok = false;
+      break;
+    }
+    ok = SameFile(InitPath(dir, run.name), InitPath(dir, reference.name));
+    WebMSegmentFileChunkSink sink(InitPath(dir, run.name),
+                                  SegmentTemplate(dir, run.name), 1);
+    WebMSegmentFileChunkSink reference_sink(
+        InitPath(dir, reference.name), SegmentTemplate(dir, reference.name),
+        1);
+    if (!sink.Init() || !reference_sink.Init())
+      ok = false;
+    for (webm_tools::int64 number = 1; ok && number <= segments[i]; ++number)
+      ok = SameFile(sink.SegmentPath(number),
+                    reference_sink.SegmentPath(number));
+    if (ok) {
+      printf("%-8s %lld segments match\n", run.name,
+             static_cast<long long>(segments[i]));
+    }
+  }
+
+  for (size_t i = 0; i < num_runs; ++i)
+    RemoveRunFiles(dir, kRuns[i].name);
+  rmdir(dir.c_str());
+
+  if (!ok) {
+    fprintf(stderr, "Check failed.\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,433 @@
+// Copyright (c) 2026 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+// Measures the throughput and latency of WebMLiveMuxer on synthetic VP8 or
+// VP9 and Opus streams. Each run reports:
+// - The frames per second sustained, counting only the time spent in the
+//   muxer, and the time taken by each |WriteFrame()| call.
+// - The latency from the |WriteFrame()| call of a frame to the
+//   |ChunkReady()| call returning the chunk holding it, per frame and per
+//   chunk. Without -realtime frames are written as fast as possible, so the
+//   latencies are muxing costs; with -realtime they include the time spent
+//   waiting for Clusters to end.
+// - The allocations made after the first key frame interval, and the peak
+//   number of bytes buffered by the muxer.
+//
+// -key_interval takes a comma separated list to sweep Cluster lengths. With
+// -json each run is printed as one JSON object per line.
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "latency_histogram.h"
+#include "synthetic_stream.h"
+#include "webm_live_muxer.h"
+
+namespace {
+
+using webm_live_benchmark::AllocationCounter;
+using webm_live_benchmark::LatencyHistogram;
+using webm_live_benchmark::SyntheticFrame;
+using webm_live_benchmark::SyntheticStreamConfig;
+using webm_tools::WebMChunkStats;
+using webm_tools::WebMLiveMuxer;
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchmarkConfig {
+  BenchmarkConfig()
+      : video_codec("vp9"),
+        audio_codec("opus"),
+        num_video_frames(9000),
+        frame_rate(30),
+        video_kbps(2000),
+        audio_kbps(64),
+        audio_frame_ms(20),
+        partial_chunk_frames(0),
+        realtime(false),
+        json(false) {
+  }
+
+  std::string video_codec;
+  std::string audio_codec;
+  int num_video_frames;
+  int frame_rate;
+  int video_kbps;
+  int audio_kbps;
+  int audio_frame_ms;
+  int partial_chunk_frames;
+  bool realtime;
+  bool json;
+  std::vector<int> key_intervals;
+};
+
+struct RunResult {
+  RunResult()
+      : frames(0),
+        input_bytes(0),
+        chunks(0),
+        output_bytes(0),
+        mux_ns(0),
+        max_bytes_buffered(0),
+        measured_frames(0) {
+  }
+
+  int64_t frames;
+  int64_t input_bytes;
+  int64_t chunks;
+  int64_t output_bytes;
+  int64_t mux_ns;
+  int64_t max_bytes_buffered;
+  int64_t measured_frames;
+  AllocationCounter allocations;
+  LatencyHistogram write_ns;
+  LatencyHistogram frame_latency_ns;
+  LatencyHistogram chunk_latency_ns;
+};
+
+int64_t ElapsedNs(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      end - start).count();
+}
+
+bool ParseIntList(const char* list, std::vector<int>* ptr_values) {
+  ptr_values->clear();
+  const char* ptr = list;
+  while (*ptr) {
+    char* end = NULL;
+    const long value = strtol(ptr, &end, 10);
+    if (end == ptr || value <= 0 || (*end && *end != ','))
+      return false;
+    ptr_values->push_back(static_cast<int>(value));
+    ptr = *end ? end + 1 : end;
+  }
+  return !ptr_values->empty();
+}
+
+// Returns the stream shape for |config| with a key frame every
+// |key_interval| frames. Key frames are 4 times the mean inter frame size,
+// and inter frames vary by +/-50%, so the mean bitrate is |video_kbps|.
+SyntheticStreamConfig MakeStreamConfig(const BenchmarkConfig& config,
+                                       int key_interval) {
+  SyntheticStreamConfig stream;
+  stream.video = config.video_codec != "none";
+  stream.audio = config.audio_codec != "none";
+  stream.num_video_frames = config.num_video_frames;
+  stream.video_frame_rate = config.frame_rate;
+  stream.key_frame_interval = key_interval;
+
+  const double frame_bytes =
+      config.video_kbps * 1000.0 / 8 / config.frame_rate;
+  const size_t inter_size = static_cast<size_t>(
+      frame_bytes * key_interval / (key_interval + 3));
+  stream.min_video_frame_size = inter_size / 2 > 0 ? inter_size / 2 : 1;
+  stream.max_video_frame_size = inter_size + inter_size / 2 + 1;
+  stream.key_frame_size = inter_size * 4 + 1;
+
+  const size_t audio_size =
+      static_cast<size_t>(config.audio_kbps * config.audio_frame_ms / 8);
+  stream.audio_frame_duration_ms = config.audio_frame_ms;
+  stream.min_audio_frame_size = audio_size * 3 / 4 > 0 ? audio_size * 3 / 4 : 1;
+  stream.max_audio_frame_size = audio_size + audio_size / 4 + 1;
+  return stream;
+}
+
+bool AddTracks(const BenchmarkConfig& config, WebMLiveMuxer* muxer) {
+  if (config.video_codec != "none") {
+    const std::string codec_id =
+        config.video_codec == "vp8" ? "V_VP8" : "V_VP9";
+    if (muxer->AddVideoTrack(1280, 720, codec_id) < 1) {
+      fprintf(stderr, "Cannot add video track.\n");
+      return false;
+    }
+  }
+  if (config.audio_codec != "none" &&
+      muxer->AddAudioTrack(48000, 2, NULL, 0, "A_OPUS") < 1) {
+    fprintf(stderr, "Cannot add audio track.\n");
+    return false;
+  }
+  return true;
+}
+
+// Muxes |frames| and fills |result|. Frame |i| is delivered once the
+// stream position after its |WriteFrame()| call has been read in chunks.
+// Frames libwebm holds back to interleave the tracks are counted from the
+// call that writes them out, so their latencies are slightly understated.
+bool RunBenchmark(const BenchmarkConfig& config,
+                  const std::vector<SyntheticFrame>& frames,
+                  int key_interval,
+                  const std::vector<uint8_t>& payload,
+                  RunResult* result) {
+  WebMLiveMuxer muxer;
+  if (muxer.Init() != WebMLiveMuxer::kSuccess || !AddTracks(config, &muxer))
+    return false;
+  muxer.set_partial_chunk_frames(config.partial_chunk_frames);
+
+  // Everything the loop needs is allocated up front, so the allocations
+  // counted are the muxer's.
+  std::vector<Clock::time_point> write_times(frames.size());
+  std::vector<int64_t> positions(frames.size());
+  result->write_ns.Reserve(frames.size());
+  result->frame_latency_ns.Reserve(frames.size());
+  result->chunk_latency_ns.Reserve(frames.size());
+  WebMLiveMuxer::ChunkBuffer chunk;
+
+  // The first key frame interval warms up the muxer.
+  const uint64_t warm_up_ns =
+      key_interval * (1000000000ULL / config.frame_rate);
+  size_t warm_up = 0;
+  while (warm_up < frames.size() && frames[warm_up].timestamp_ns < warm_up_ns)
+    ++warm_up;
+
+  size_t next_undelivered = 0;
+  const Clock::time_point start = Clock::now();
+  for (size_t i = 0; i <= frames.size(); ++i) {
+    if (i == warm_up)
+      result->allocations.Start();
+
+    if (i < frames.size()) {
+      const SyntheticFrame& frame = frames[i];
+      if (config.realtime) {
+        std::this_thread::sleep_until(
+            start + std::chrono::nanoseconds(frame.timestamp_ns));
+      }
+      const Clock::time_point write_start = Clock::now();
+      const int status = frame.video ?
+          muxer.WriteVideoFrame(&payload[0], frame.size, frame.timestamp_ns,
+                                frame.is_key) :
+          muxer.WriteAudioFrame(&payload[0], frame.size, frame.timestamp_ns,
+                                frame.is_key);
+      const Clock::time_point write_end = Clock::now();
+      if (status != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "Cannot write frame %zu.\n", i);
+        return false;
+      }
+      const int64_t write_ns = ElapsedNs(write_start, write_end);
+      result->write_ns.Add(write_ns);
+      result->mux_ns += write_ns;
+      result->input_bytes += frame.size;
+      write_times[i] = write_start;
+      const WebMChunkStats stats = muxer.chunk_stats();
+      positions[i] = stats.bytes_emitted + stats.bytes_buffered;
+    } else {
+      const Clock::time_point finalize_start = Clock::now();
+      if (muxer.Finalize() != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "Cannot finalize muxer.\n");
+        return false;
+      }
+      result->mux_ns += ElapsedNs(finalize_start, Clock::now());
+    }
+
+    webm_tools::int32 chunk_length = 0;
+    for (;;) {
+      const Clock::time_point read_start = Clock::now();
+      if (!muxer.ChunkReady(&chunk_length))
+        break;
+      if (muxer.ReadChunk(&chunk) != WebMLiveMuxer::kSuccess) {
+        fprintf(stderr, "Cannot read chunk.\n");
+        return false;
+      }
+      const Clock::time_point read_end = Clock::now();
+      result->mux_ns += ElapsedNs(read_start, read_end);
+      ++result->chunks;
+      result->output_bytes += chunk.size();
+
+      // After |Finalize()| every frame is in the last chunks.
+      const int64_t emitted = muxer.chunk_stats().bytes_emitted;
+      const size_t first_delivered = next_undelivered;
+      while (next_undelivered < frames.size() &&
+             next_undelivered <= i &&
+             (i == frames.size() || positions[next_undelivered] <= emitted)) {
+        result->frame_latency_ns.Add(
+            ElapsedNs(write_times[next_undelivered], read_start));
+        ++next_undelivered;
+      }
+      if (next_undelivered > first_delivered) {
+        result->chunk_latency_ns.Add(
+            ElapsedNs(write_times[first_delivered], read_start));
+      }
+    }
+  }
+  result->allocations.Stop();
+  result->frames = frames.size();
+  result->measured_frames = frames.size() - warm_up;
+  result->max_bytes_buffered = muxer.chunk_stats().max_bytes_buffered;
+  return true;
+}
+
+void PrintText(const BenchmarkConfig& config, int key_interval,
+               RunResult* result) {
+  const double mux_seconds = result->mux_ns / 1e9;
+  printf("video=%s audio=%s fps=%d key_interval=%d partial_frames=%d%s\n",
+         config.video_codec.c_str(), config.audio_codec.c_str(),
+         config.frame_rate, key_interval, config.partial_chunk_frames,
+         config.realtime ? " realtime" : "");
+  printf("  frames %lld, chunks %lld, output %lld bytes\n",
+         static_cast<long long>(result->frames),
+         static_cast<long long>(result->chunks),
+         static_cast<long long>(result->output_bytes));
+  printf("  throughput %.0f frames/s, %.1f MB/s\n",
+         mux_seconds > 0 ? result->frames / mux_seconds : 0.0,
+         mux_seconds > 0 ? result->input_bytes / mux_seconds / 1e6 : 0.0);
+  printf("  %-16s %12s %12s %12s %12s\n", "latency (us)", "p50", "p90", "p99",
+         "max");
+  struct {
+    const char* name;
+    LatencyHistogram* histogram;
+  } const rows[] = {
+    { "WriteFrame", &result->write_ns },
+    { "frame to chunk", &result->frame_latency_ns },
+    { "chunk", &result->chunk_latency_ns },
+  };
+  for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); ++i) {
+    LatencyHistogram* const histogram = rows[i].histogram;
+    printf("  %-16s %12.1f %12.1f %12.1f %12.1f\n", rows[i].name,
+           histogram->Percentile(50) / 1e3, histogram->Percentile(90) / 1e3,
+           histogram->Percentile(99) / 1e3, histogram->max() / 1e3);
+  }
+  printf("  allocations %.3f/frame, %.1f bytes/frame\n",
+         result->measured_frames > 0 ?
+             static_cast<double>(result->allocations.allocations()) /
+                 result->measured_frames : 0.0,
+         result->measured_frames > 0 ?
+             static_cast<double>(result->allocations.bytes()) /
+                 result->measured_frames : 0.0);
+  printf("  peak buffered %lld bytes\n",
+         static_cast<long long>(result->max_bytes_buffered));
+}
+
+void PrintJson(const BenchmarkConfig& config, int key_interval,
+               RunResult* result) {
+  const double mux_seconds = result->mux_ns / 1e9;
+  printf("{\"video\":\"%s\",\"audio\":\"%s\",\"fps\":%d,\"video_kbps\":%d,"
+         "\"audio_kbps\":%d,\"key_interval\":%d,\"partial_frames\":%d,"
+         "\"realtime\":%s,",
+         config.video_codec.c_str(), config.audio_codec.c_str(),
+         config.frame_rate, config.video_kbps, config.audio_kbps,
+         key_interval, config.partial_chunk_frames,
+         config.realtime ? "true" : "false");
+  printf("\"frames\":%lld,\"chunks\":%lld,\"input_bytes\":%lld,"
+         "\"output_bytes\":%lld,\"mux_ns\":%lld,\"frames_per_second\":%.1f,",
+         static_cast<long long>(result->frames),
+         static_cast<long long>(result->chunks),
+         static_cast<long long>(result->input_bytes),
+         static_cast<long long>(result->output_bytes),
+         static_cast<long long>(result->mux_ns),
+         mux_seconds > 0 ? result->frames / mux_seconds : 0.0);
+  printf("\"measured_frames\":%lld,\"allocations\":%lld,"
+         "\"allocated_bytes\":%lld,\"max_bytes_buffered\":%lld,",
+         static_cast<long long>(result->measured_frames),
+         static_cast<long long>(result->allocations.allocations()),
+         static_cast<long long>(result->allocations.bytes()),
+         static_cast<long long>(result->max_bytes_buffered));
+  printf("\"write_frame\":%s,\"frame_latency\":%s,\"chunk_latency\":%s}\n",
+         result->write_ns.ToJson().c_str(),
+         result->frame_latency_ns.ToJson().c_str(),
+         result->chunk_latency_ns.ToJson().c_str());
+}
+
+void Usage() {
+  printf("Usage: webm_live_muxer_benchmark [options]\n");
+  printf("  -video <vp8|vp9|none>  Video codec. (Default vp9)\n");
+  printf("  -audio <opus|none>     Audio codec. (Default opus)\n");
+  printf("  -frames <int>          Video frames muxed. (Default 9000)\n");
+  printf("  -fps <int>             Video frame rate. (Default 30)\n");
+  printf("  -video_kbps <int>      Video bitrate. (Default 2000)\n");
+  printf("  -audio_kbps <int>      Audio bitrate. (Default 64)\n");
+  printf("  -audio_frame_ms <int>  Audio frame duration. (Default 20)\n");
+  printf("  -key_interval <list>   Comma separated key frame intervals in\n");
+  printf("                         frames, one run each. (Default 60)\n");
+  printf("  -partial_frames <int>  Frames per partial chunk. (Default 0)\n");
+  printf("  -realtime              Write frames at their timestamps.\n");
+  printf("  -json                  Print one JSON object per run.\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  BenchmarkConfig config;
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp("-video", argv[i]) && has_value) {
+      config.video_codec = argv[++i];
+    } else if (!strcmp("-audio", argv[i]) && has_value) {
+      config.audio_codec = argv[++i];
+    } else if (!strcmp("-frames", argv[i]) && has_value) {
+      config.num_video_frames = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-fps", argv[i]) && has_value) {
+      config.frame_rate = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-video_kbps", argv[i]) && has_value) {
+      config.video_kbps = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-audio_kbps", argv[i]) && has_value) {
+      config.audio_kbps = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-audio_frame_ms", argv[i]) && has_value) {
+      config.audio_frame_ms = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-key_interval", argv[i]) && has_value) {
+      if (!ParseIntList(argv[++i], &config.key_intervals)) {
+        fprintf(stderr, "Invalid -key_interval list: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    } else if (!strcmp("-partial_frames", argv[i]) && has_value) {
+      config.partial_chunk_frames = strtol(argv[++i], NULL, 10);
+    } else if (!strcmp("-realtime", argv[i])) {
+      config.realtime = true;
+    } else if (!strcmp("-json", argv[i])) {
+      config.json = true;
+    } else {
+      Usage();
+      return argc == 2 && !strcmp("-h", argv[1]) ? EXIT_SUCCESS :
+                                                   EXIT_FAILURE;
+    }
+  }
+  if (config.key_intervals.empty())
+    config.key_intervals.push_back(60);
+
+  if ((config.video_codec != "vp8" && config.video_codec != "vp9" &&
+       config.video_codec != "none") ||
+      (config.audio_codec != "opus" && config.audio_codec != "none") ||
+      (config.video_codec == "none" && config.audio_codec == "none")) {
+    fprintf(stderr, "Invalid -video or -audio codec.\n");
+    return EXIT_FAILURE;
+  }
+  if (config.num_video_frames <= 0 || config.frame_rate <= 0 ||
+      config.video_kbps <= 0 || config.audio_kbps <= 0 ||
+      config.audio_frame_ms <= 0 || config.partial_chunk_frames < 0) {
+    fprintf(stderr, "Numeric options must be positive.\n");
+    return EXIT_FAILURE;
+  }
+
+  for (size_t i = 0; i < config.key_intervals.size(); ++i) {
+    const int key_interval = config.key_intervals[i];
+    const std::vector<SyntheticFrame> frames =
+        webm_live_benchmark::MakeSyntheticStream(
+            MakeStreamConfig(config, key_interval));
+    if (frames.empty())
+      return EXIT_FAILURE;
+    std::vector<uint8_t> payload(webm_live_benchmark::MaxFrameSize(frames));
+    for (size_t j = 0; j < payload.size(); ++j)
+      payload[j] = static_cast<uint8_t>(j * 31 + 7);
+
+    RunResult result;
+    if (!RunBenchmark(config, frames, key_interval, payload, &result)) {
+      fprintf(stderr, "Benchmark failed.\n");
+      return EXIT_FAILURE;
+    }
+    if (config.json)
+      PrintJson(config, key_interval, &result);
+    else
+      PrintText(config, key_interval, &result);
+  }
+  return EXIT_SUCCESS;
+}